@@ -0,0 +1,116 @@
+/**
+ * @file bench_builder.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of message building and printing: linked list wrapper, message builder and template
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "mcu_msg.h"
+
+#define KEY_CNT     1000
+#define ROUNDS      200
+#define OUT_SIZE    60000
+
+/*Key strings and wrapper nodes*/
+static char keys[KEY_CNT][8];
+static msg_wrap_int_t ints[KEY_CNT];
+static msg_wrap_float_t floats[KEY_CNT];
+static msg_bld_entry_t arena[2 * KEY_CNT + 1];
+
+static msg_tpl_slot_t slots[2 * KEY_CNT];
+
+static char out_wrap[OUT_SIZE], out_bld[OUT_SIZE], out_tpl[OUT_SIZE];
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*Build object with KEY_CNT ints and floats using the wrapper*/
+static void build_wrapper(msg_wrap_t *msg, msg_wrap_obj_t *obj)
+{
+    int i;
+    *msg = msg_wrapper_create_msg("BENCH");
+    *obj = msg_wrapper_create_obj("vals");
+    for(i = 0; i < KEY_CNT; i++) {
+        ints[i] = msg_wrapper_create_int(keys[i], i * 37);
+        floats[i] = msg_wrapper_create_float(keys[i], i * 0.25f, 2);
+        msg_wrapper_add_int_to_obj(obj, &ints[i]);
+        msg_wrapper_add_float_to_obj(obj, &floats[i]);
+    }
+    msg_wrapper_add_obj_to_msg(msg, obj);
+}
+
+/*Build the same object with the builder*/
+static void build_builder(msg_builder_t *b)
+{
+    msg_size_t obj;
+    int i;
+    *b = msg_builder_create("BENCH", arena, sizeof(arena) / sizeof(arena[0]));
+    obj = msg_builder_add_obj(b, "vals");
+    for(i = 0; i < KEY_CNT; i++) {
+        msg_builder_add_int(b, obj, keys[i], i * 37);
+        msg_builder_add_float(b, obj, keys[i], i * 0.25f, 2);
+    }
+}
+
+int main()
+{
+    clock_t start;
+    msg_ctx_t ctx;
+    msg_wrap_t msg;
+    msg_wrap_obj_t obj;
+    msg_builder_t b;
+    msg_template_t tpl;
+    int r, i;
+
+    for(i = 0; i < KEY_CNT; i++) sprintf(keys[i], "k%d", i);
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_enable_buff(&ctx);
+
+    printf("Message building benchmark (%d int + %d float keys x %d rounds)\n", KEY_CNT, KEY_CNT, ROUNDS);
+    printf("==============================================================\n\n");
+
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) build_wrapper(&msg, &obj);
+    printf("build wrapper: %8.3f s\n", elapsed(start));
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) build_builder(&b);
+    printf("build builder: %8.3f s\n\n", elapsed(start));
+
+    msg_ctx_init_str_buff(&ctx, out_wrap, OUT_SIZE);
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        msg_ctx_reset_str_buff(&ctx);
+        msg_ctx_print_wrapper_msg(&ctx, msg);
+    }
+    printf("print wrapper: %8.3f s (%d bytes)\n", elapsed(start), (int)(ctx.p - out_wrap));
+
+    msg_ctx_init_str_buff(&ctx, out_bld, OUT_SIZE);
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        msg_ctx_reset_str_buff(&ctx);
+        msg_ctx_print_builder(&ctx, &b);
+    }
+    printf("print builder: %8.3f s (%d bytes)\n", elapsed(start), (int)(ctx.p - out_bld));
+    printf("outputs are %s\n\n", memcmp(out_wrap, out_bld, OUT_SIZE) ? "DIFFERENT" : "the same");
+
+    tpl = msg_template_compile(msg, out_tpl, OUT_SIZE, slots, 2 * KEY_CNT);
+    msg_ctx_init_str_buff(&ctx, out_wrap, OUT_SIZE);
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        ints[r % KEY_CNT].val++; // one changed value per message
+        msg_ctx_reset_str_buff(&ctx);
+        msg_ctx_print_template(&ctx, &tpl);
+    }
+    printf("print template:%8.3f s (%d bytes, one value changed per message)\n", elapsed(start), (int)(ctx.p - out_wrap));
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file bench_capture.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Scaling benchmark of the capture parser from 1 to N threads, the merged output is
+ * compared with the sequential parse of the whole capture
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "capture.h"
+
+#define CAPTURE_SIZE    (64 * 1024 * 1024)
+#define CHUNK_SIZE      (256 * 1024)
+
+static cap_t cap;
+
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*FNV-1a hash of the merged output*/
+static uint32_t out_hash(void)
+{
+    uint32_t h = 2166136261UL, i;
+    size_t k;
+
+    for(i = 0; i < cap.chunk_cnt; i++) {
+        for(k = 0; k < cap.chunk[i].out_len; k++) h = (h ^ (uint8_t)cap.chunk[i].out[k]) * 16777619UL;
+    }
+    return h;
+}
+
+/*UART log: sensor and status messages, line noise and logs with message flags in strings*/
+static size_t gen_capture(char *buff, size_t size)
+{
+    size_t len = 0;
+    int i = 0;
+
+    while(len + 256 < size) {
+        switch(i % 8) {
+            case 3:
+                len += sprintf(buff + len, "#STATUS{<Get_Temp>@Status($up=%d;$err=%d;$fw='v1.2.3')}\r\n", i, i % 3);
+            break;
+            case 5:
+                len += (i % 40 == 5) ? sprintf(buff + len, "#LOG{$text='reset\n#SENSOR{@Temp($T1=0)} in log, %d'}\r\n", i)
+                                     : sprintf(buff + len, "noise %d\x01\r\n", i);
+            break;
+            default:
+                len += sprintf(buff + len, "#SENSOR{@Temp($T1=%d.%02d;$T2=-%d.5;$cnt=%d;$name='unit, %d')}\r\n",
+                               20 + i % 10, i % 100, i % 30, i, i % 16);
+            break;
+        }
+        i++;
+    }
+    return len;
+}
+
+int main()
+{
+    char *buff = malloc(CAPTURE_SIZE);
+    int ncpu = sysconf(_SC_NPROCESSORS_ONLN), max = ncpu > 4 ? ncpu : 4;
+    double start, t, t1 = 0;
+    uint32_t ref;
+    size_t len;
+    int n;
+
+    if(buff == NULL) return 1;
+    len = gen_capture(buff, CAPTURE_SIZE);
+    cap_init(&cap, buff, len);
+    cap_add_field(&cap, "SENSOR", "Temp", "T1");
+    cap_add_field(&cap, "SENSOR", "Temp", "cnt");
+    cap_add_field(&cap, "SENSOR", "Temp", "name");
+    cap_add_field(&cap, "STATUS", "Status", "up");
+
+    printf("Capture parsing (%zu MB, %d KB chunks, %d cpu)\n", len >> 20, CHUNK_SIZE >> 10, ncpu);
+    printf("==============================================\n\n");
+
+    start = now_s();
+    cap_run(&cap, 1, len + 1);
+    ref = out_hash();
+    printf("sequential:  %8.3f s (%llu messages, %llu lines)\n", now_s() - start,
+           (unsigned long long)cap.msgs, (unsigned long long)cap.lines);
+
+    for(n = 1; n <= max; n *= 2) {
+        start = now_s();
+        cap_run(&cap, n, CHUNK_SIZE);
+        t = now_s() - start;
+        if(n == 1) t1 = t;
+        printf("%2d threads:  %8.3f s (speedup %.2f, %u chunks, %u resynced, %s)\n", n, t, t1 / t,
+               cap.chunk_cnt, cap.resync, out_hash() == ref ? "same output" : "DIFFERENT OUTPUT");
+    }
+    cap_free(&cap);
+    free(buff);
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file bench_delta.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of delta mode: bytes and merge time per message against full messages
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mcu_msg.h"
+
+#define KEY_CNT     1000
+#define ROUNDS      1000
+#define PERIOD      100
+#define OUT_SIZE    20000
+
+/*Model with KEY_CNT ints*/
+static char keys[KEY_CNT][8];
+static msg_wrap_int_t ints[KEY_CNT];
+static msg_delta_slot_t slots[KEY_CNT];
+static msg_state_entry_t entries[KEY_CNT];
+static char pool[KEY_CNT * 24];
+static char out[OUT_SIZE];
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*Send ROUNDS messages with chg changed keys, the receiver merges every message*/
+static void run(msg_delta_t *d, msg_state_t *st, int chg, uint16_t period)
+{
+    msg_ctx_t ctx;
+    clock_t start;
+    uint32_t bytes = 0;
+    int r, i, v;
+
+    d->period = period;
+    msg_delta_keyframe(d);
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_init_str_buff(&ctx, out, OUT_SIZE);
+    msg_ctx_enable_buff(&ctx);
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        for(i = 0; i < chg; i++) ints[rand() % KEY_CNT].val++;
+        msg_ctx_reset_str_buff(&ctx);
+        msg_ctx_print_delta(&ctx, d);
+        bytes += ctx.p - out;
+        msg_state_merge(st, msg_get(out, "BENCH", ctx.p - out));
+    }
+    v = 0;
+    msg_state_get_int(&v, st, "vals", keys[KEY_CNT - 1]);
+    printf("%4d changed, %s: %8.3f s %8u bytes/msg%s\n", chg, period == 1 ? "full " : "delta", elapsed(start),
+                                    (unsigned)(bytes / ROUNDS), v == ints[KEY_CNT - 1].val ? "" : " (state is DIFFERENT)");
+}
+
+int main()
+{
+    msg_wrap_t msg;
+    msg_wrap_obj_t obj;
+    msg_delta_t d;
+    msg_state_t st;
+    int i;
+
+    msg = msg_wrapper_create_msg("BENCH");
+    obj = msg_wrapper_create_obj("vals");
+    for(i = 0; i < KEY_CNT; i++) {
+        sprintf(keys[i], "k%d", i);
+        ints[i] = msg_wrapper_create_int(keys[i], i);
+        msg_wrapper_add_int_to_obj(&obj, &ints[i]);
+    }
+    msg_wrapper_add_obj_to_msg(&msg, &obj);
+    d = msg_delta_create(msg, slots, KEY_CNT, NULL, 0, PERIOD);
+    st = msg_state_create(entries, KEY_CNT, pool, sizeof(pool));
+
+    printf("Delta mode benchmark (%d int keys, %d messages, keyframe period %d)\n", KEY_CNT, ROUNDS, PERIOD);
+    printf("==================================================================\n\n");
+    run(&d, &st, 1, 1);
+    run(&d, &st, 1, PERIOD);
+    run(&d, &st, 10, PERIOD);
+    run(&d, &st, 100, PERIOD);
+    return 0;
+}
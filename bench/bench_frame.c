@@ -0,0 +1,72 @@
+/**
+ * @file bench_frame.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of framing: CRC32C throughput and finding a message by frame skipping against scanning
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "mcu_msg.h"
+
+#define MSG_CNT     300
+#define ROUNDS      2000
+#define BUFF_SIZE   60000
+
+#if defined(__SSE4_2__)
+#define CRC_IMPL    "sse4.2"
+#else
+#define CRC_IMPL    "table"
+#endif
+
+static char raw[BUFF_SIZE], framed[BUFF_SIZE];
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main()
+{
+    clock_t start;
+    msg_size_t raw_len = 0, framed_len = 0, cursor, len;
+    volatile uint32_t crc = 0;
+    msg_t msg;
+    int r, i, found = 0;
+
+    /*MSG_CNT messages, the searched one is the last*/
+    for(i = 0; i < MSG_CNT; i++) {
+        len = sprintf(framed + framed_len + MSG_FRAME_HDR_SIZE, "#%s%d{@vals($a=%d;$b=%d.25;$s='text \"%d\"')}",
+                                                                i == MSG_CNT - 1 ? "LAST" : "M", i, i, i, i);
+        memcpy(raw + raw_len, framed + framed_len + MSG_FRAME_HDR_SIZE, len);
+        raw_len += len;
+        framed_len += msg_frame_seal(framed + framed_len, BUFF_SIZE - framed_len, len);
+    }
+
+    printf("Framing benchmark (%d messages, %d bytes, %d rounds)\n", MSG_CNT, (int)raw_len, ROUNDS);
+    printf("=================================================\n\n");
+
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) crc += msg_crc32c(0, raw, raw_len);
+    printf("CRC32C (%s): %8.3f s %8.1f MB/s\n", CRC_IMPL, elapsed(start), (double)raw_len * ROUNDS / 1e6 / elapsed(start));
+
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) found += msg_get(raw, "LAST299", raw_len).id.s != NULL;
+    printf("msg_get scan:    %8.3f s\n", elapsed(start));
+
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        cursor = 0;
+        msg = msg_frame_get(framed, framed_len, BUFF_SIZE, "LAST299", &cursor);
+        found += msg.id.s != NULL;
+    }
+    printf("msg_frame_get:   %8.3f s\n", elapsed(start));
+    printf("found: %d of %d\n", found, 2 * ROUNDS);
+    return 0;
+}
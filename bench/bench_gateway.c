@@ -0,0 +1,115 @@
+/**
+ * @file bench_gateway.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Throughput benchmark of the gateway: hundreds of virtual ports (pty pairs) are driven at once
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "gateway.h"
+
+#define PORT_CNT        256
+#define WORKER_CNT      2
+#define MSG_PER_PORT    2000
+
+static gw_t gw;
+static gw_port_t ports[PORT_CNT];
+static gw_worker_t workers[WORKER_CNT];
+static int slaves[PORT_CNT];
+
+/*Handled messages and sequence errors per port (a port is handled by one worker)*/
+static int next_seq[PORT_CNT];
+static int seq_err[PORT_CNT];
+static uint64_t handled, sent_bytes;
+static double start, stop;
+
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void tlm_handler(gw_port_t *port, msg_seg_msg_t msg, msg_ctx_t *out, void *arg)
+{
+    msg_seg_obj_t obj = msg_parser_get_obj_seg(msg, "S");
+    int seq = -1;
+    float T;
+
+    (void)out;
+    (void)arg;
+    msg_parser_get_int_seg(&seq, obj, "seq");
+    msg_parser_get_float_seg(&T, obj, "T");
+    seq_err[port->idx] += seq != next_seq[port->idx];
+    next_seq[port->idx] = seq + 1;
+    __atomic_add_fetch(&handled, 1, __ATOMIC_RELAXED);
+}
+
+/*Boards: every port sends its messages round robin, then the gateway is stopped*/
+static void *driver_fnc(void *arg)
+{
+    char line[128];
+    int i, p, n;
+
+    (void)arg;
+    start = now_s();
+    for(i = 0; i < MSG_PER_PORT; i++) {
+        for(p = 0; p < PORT_CNT; p++) {
+            n = snprintf(line, sizeof(line), "#TLM{@S($seq=%d;$T=%d.%02d;$port=%d;$fw='v1.2.3')}\r\n", i, 20 + p % 10, i % 100, p);
+            if(write(slaves[p], line, n) == n) sent_bytes += n;
+        }
+    }
+    while(__atomic_load_n(&handled, __ATOMIC_RELAXED) < (uint64_t)PORT_CNT * MSG_PER_PORT && now_s() - start < 30) {
+        usleep(200);
+    }
+    stop = now_s();
+    gw_stop(&gw);
+    return NULL;
+}
+
+int main()
+{
+    pthread_t driver;
+    uint64_t dropped = 0;
+    int p, err = 0;
+
+    printf("Gateway throughput (%d pty ports x %d messages, %d workers)\n", PORT_CNT, MSG_PER_PORT, WORKER_CNT);
+    printf("=========================================================\n\n");
+
+    if(gw_init(&gw, ports, PORT_CNT, workers, WORKER_CNT) < 0) {
+        perror("gw_init");
+        return 1;
+    }
+    gw_add_handler(&gw, "TLM", tlm_handler, NULL);
+    for(p = 0; p < PORT_CNT; p++) {
+        if(gw_open_pty(&gw, &slaves[p]) == NULL) {
+            perror("openpty");
+            return 1;
+        }
+    }
+
+    pthread_create(&driver, NULL, driver_fnc, NULL);
+    gw_run(&gw);
+    pthread_join(driver, NULL);
+
+    for(p = 0; p < PORT_CNT; p++) {
+        err += seq_err[p];
+        dropped += ports[p].dropped;
+        close(slaves[p]);
+    }
+    gw_close(&gw);
+
+    printf("handled: %llu of %d messages in %.3f s\n", (unsigned long long)handled, PORT_CNT * MSG_PER_PORT, stop - start);
+    printf("throughput: %.0f msg/s, %.1f MB/s\n", handled / (stop - start), sent_bytes / (stop - start) / 1e6);
+    printf("sequence errors: %d, dropped: %llu\n", err, (unsigned long long)dropped);
+    return 0;
+}
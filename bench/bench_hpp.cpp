@@ -0,0 +1,159 @@
+/**
+ * @file bench_hpp.cpp
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of the C++ view API against the C API: same messages, same lookups
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "mcu_msg.hpp"
+
+#define ROUNDS      20000
+#define MSG_CNT     40
+#define REPEAT      10
+
+/*Loops aren't inlined to main, so they are compiled the same way and can be compared in the disassembly*/
+#define BENCH_LOOP  __attribute__((noinline)) static
+
+static char buff[MSG_CNT * 96];
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*C API: lookup of keys by name*/
+BENCH_LOOP double get_c(msg_size_t len)
+{
+    msg_size_t cursor;
+    msg_t m;
+    msg_obj_t obj;
+    msg_str_t fw;
+    double sum = 0;
+    float T;
+    int r, seq;
+
+    for(r = 0; r < ROUNDS; r++) {
+        cursor = 0;
+        while((m = msg_next(buff, len, &cursor)).content.s != NULL) {
+            obj = msg_parser_get_obj(m, (char *)"S");
+            if(msg_num_ok(msg_parser_get_int(&seq, obj, (char *)"seq")) && msg_num_ok(msg_parser_get_float(&T, obj, (char *)"T"))) sum += seq + T;
+            fw = msg_parser_get_str(obj, (char *)"fw");
+            if(fw.s != NULL) sum += fw.len;
+        }
+    }
+    return sum;
+}
+
+/*C++ views: same lookups*/
+BENCH_LOOP double get_hpp(msg_size_t len)
+{
+    double sum = 0;
+    int r;
+
+    for(r = 0; r < ROUNDS; r++) {
+        for(msg::message m : msg::messages(std::string_view(buff, len))) {
+            msg::object obj = m.obj("S");
+            auto seq = obj.get<int>("seq");
+            auto T = obj.get<float>("T");
+            if(seq && T) sum += *seq + *T;
+            if(auto fw = obj.get<std::string_view>("fw")) sum += fw->size();
+        }
+    }
+    return sum;
+}
+
+/*C API: iteration over objects and keys*/
+BENCH_LOOP double iter_c(msg_size_t len)
+{
+    msg_size_t cursor, obj_cursor, key_cursor;
+    msg_t m;
+    msg_obj_t obj;
+    msg_str_t id, val;
+    double sum = 0, d;
+    int r;
+
+    for(r = 0; r < ROUNDS; r++) {
+        cursor = 0;
+        while((m = msg_next(buff, len, &cursor)).content.s != NULL) {
+            obj_cursor = 0;
+            while((obj = msg_parser_next_obj(m, &obj_cursor)).content.s != NULL) {
+                key_cursor = 0;
+                while((id = msg_parser_next_key(obj, &key_cursor, &val)).s != NULL) {
+                    if(msg_num_ok(msg_val_to_double(&d, val)) && d != 0) sum += d;
+                    else sum += id.len;
+                }
+            }
+        }
+    }
+    return sum;
+}
+
+/*C++ views: same iteration by range-for*/
+BENCH_LOOP double iter_hpp(msg_size_t len)
+{
+    double sum = 0;
+    int r;
+
+    for(r = 0; r < ROUNDS; r++) {
+        for(msg::message m : msg::messages(std::string_view(buff, len))) {
+            for(msg::object obj : m.objects()) {
+                for(msg::key k : obj.keys()) {
+                    auto d = k.as<double>();
+                    if(d && *d != 0) sum += *d;
+                    else sum += k.id().size();
+                }
+            }
+        }
+    }
+    return sum;
+}
+
+/*Time of one run*/
+static double run(double (*loop)(msg_size_t), msg_size_t len, double *sum)
+{
+    clock_t start = clock();
+    *sum = loop(len);
+    return elapsed(start);
+}
+
+/*C and C++ loops are run alternately and the best times are compared, the machine can be shared*/
+static void compare(const char *name, double (*loop_c)(msg_size_t), double (*loop_hpp)(msg_size_t), msg_size_t len)
+{
+    double t, best_c = 0, best_hpp = 0, sum_c = 0, sum_hpp = 0;
+    int i;
+
+    for(i = 0; i < REPEAT; i++) {
+        t = run(loop_c, len, &sum_c);
+        if(!i || t < best_c) best_c = t;
+        t = run(loop_hpp, len, &sum_hpp);
+        if(!i || t < best_hpp) best_hpp = t;
+    }
+    printf("%s\n", name);
+    printf("  C:   %8.3f s (checksum %.2f)\n", best_c, sum_c);
+    printf("  C++: %8.3f s (checksum %.2f) %+.1f%%%s\n\n", best_hpp, sum_hpp, (best_hpp / best_c - 1) * 100,
+           sum_c != sum_hpp ? " CHECKSUM DIFFERS" : "");
+}
+
+int main()
+{
+    msg_size_t len = 0;
+    int i;
+
+    for(i = 0; i < MSG_CNT; i++) {
+        len += sprintf(buff + len, "#TLM{@S($seq=%d;$T=21.%02d;$fw='v1.2.3')@P($V=3.%d;$I=0.%02d)}\r\n", i, i, i % 10, i);
+    }
+
+    printf("C++ view API against C API (%d messages, %d bytes x %d rounds, best of %d)\n", MSG_CNT, (int)len, ROUNDS, REPEAT);
+    printf("=======================================================================\n\n");
+
+    compare("lookup by key (msg_parser_get_... / get<T>)", get_c, get_hpp, len);
+    compare("iteration (next_obj, next_key / range-for)", iter_c, iter_hpp, len);
+    return 0;
+}
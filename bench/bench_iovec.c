@@ -0,0 +1,87 @@
+/**
+ * @file bench_iovec.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of iovec output: print to buffer and write against iovec entries and writev
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "mcu_msg.h"
+
+#define STR_CNT     64
+#define STR_LEN     400
+#define ROUNDS      20000
+#define OUT_SIZE    60000
+
+/*Key strings, contents and wrapper nodes*/
+static char keys[STR_CNT][12];
+static char contents[STR_CNT][STR_LEN + 1];
+static msg_wrap_str_t strs[STR_CNT];
+static msg_wrap_int_t ints[STR_CNT];
+
+static char out[OUT_SIZE], scratch[4096];
+static struct iovec iov[4 * STR_CNT];
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main()
+{
+    clock_t start;
+    msg_ctx_t ctx;
+    msg_wrap_t msg;
+    msg_wrap_obj_t obj;
+    msg_size_t len = 0, cnt = 0;
+    ssize_t written = 0;
+    int fd, r, i;
+
+    if((fd = open("/dev/null", O_WRONLY)) < 0) return 1;
+    msg = msg_wrapper_create_msg("GATEWAY_FORWARD");
+    obj = msg_wrapper_create_obj("payload");
+    for(i = 0; i < STR_CNT; i++) {
+        sprintf(keys[i], "s%d", i);
+        memset(contents[i], 'a' + i % 26, STR_LEN);
+        strs[i] = msg_wrapper_create_str(keys[i], contents[i]);
+        ints[i] = msg_wrapper_create_int(keys[i], i * 1000);
+        msg_wrapper_add_str_to_obj(&obj, &strs[i]);
+        msg_wrapper_add_int_to_obj(&obj, &ints[i]);
+    }
+    msg_wrapper_add_obj_to_msg(&msg, &obj);
+
+    printf("iovec output benchmark (%d strings of %d bytes + %d ints, %d rounds)\n", STR_CNT, STR_LEN, STR_CNT, ROUNDS);
+    printf("=====================================================================\n\n");
+
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_init_str_buff(&ctx, out, OUT_SIZE);
+    msg_ctx_enable_buff(&ctx);
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        msg_ctx_reset_str_buff(&ctx);
+        msg_ctx_print_wrapper_msg(&ctx, msg);
+        len = ctx.p - out;
+        written += write(fd, out, len);
+    }
+    printf("print to buffer + write: %8.3f s (%d bytes)\n", elapsed(start), (int)len);
+
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        cnt = msg_wrap_to_iovec(msg, iov, 4 * STR_CNT, scratch, sizeof(scratch));
+        written += writev(fd, iov, cnt);
+    }
+    printf("iovec + writev:          %8.3f s (%d entries)\n", elapsed(start), (int)cnt);
+    printf("written: %ld bytes\n", (long)written);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file bench_num.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of number parsing: current getters against the previous digit by digit conversion
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mcu_msg.h"
+
+#define VAL_CNT     4096
+#define ROUNDS      200
+
+/*Value strings, every object is "$v=<value>"*/
+static char vals[VAL_CNT][40];
+static msg_obj_t objs[VAL_CNT];
+
+
+/*Previous integer conversion (digits are walked backwards with unsigned multiplier)*/
+static uint8_t legacy_get_int(int *res_val, msg_obj_t obj)
+{
+    char *s = obj.content.s + 3; // skip "$v="
+    char *end = obj.content.s + obj.content.len;
+    unsigned m = 1;
+    int sign = 1, i;
+    uint8_t res = 0;
+
+    if(*s == '-' || *s == '+') sign = *s++ == '-' ? -1 : 1;
+    for(i = 0; s < end && *s != ' ' && *s != ';'; i++, s++) {
+        if(*s < '0' || *s > '9') return 0;
+    }
+    *res_val = 0;
+    --s;
+    while(i--) {
+        *res_val += (*s-- - '0') * m;
+        m *= 10;
+        res++;
+    }
+    *res_val *= sign;
+    return res;
+}
+
+/*Previous float conversion (fraction is built with float division)*/
+static uint8_t legacy_get_float(float *res_val, msg_obj_t obj)
+{
+    char *s = obj.content.s + 3; // skip "$v="
+    char *end = obj.content.s + obj.content.len;
+    char *pf = NULL;
+    unsigned m = 1;
+    float mf = 0.1;
+    int sign = 1, i;
+    uint8_t res = 0;
+
+    if(*s == '-' || *s == '+') sign = *s++ == '-' ? -1 : 1;
+    for(i = 0; s < end && *s != ' ' && *s != ';' && *s != '.'; i++, s++) {
+        if(*s < '0' || *s > '9') return 0;
+    }
+    *res_val = 0.0;
+    if(s < end && *s == '.') {
+        pf = s + 1;
+        res++;
+    }
+    --s;
+    while(i--) {
+        *res_val += (*s-- - '0') * m;
+        m *= 10;
+        res++;
+    }
+    for(; pf != NULL && pf < end; pf++) {
+        if(*pf < '0' || *pf > '9') return 0;
+        *res_val += (*pf - '0') * mf;
+        mf /= 10;
+        res++;
+    }
+    *res_val *= sign;
+    return res;
+}
+
+static void init_vals(uint8_t frac)
+{
+    int i, n;
+    for(i = 0; i < VAL_CNT; i++) {
+        if(frac) {
+            n = sprintf(vals[i], "$v=%s%d.%0*d", rand() % 2 ? "-" : "", rand() % 100000, 1 + rand() % 6, rand() % 1000000);
+        } else {
+            n = sprintf(vals[i], "$v=%d", rand() - RAND_MAX / 2);
+        }
+        objs[i].id.s = NULL;
+        objs[i].id.len = 0;
+        objs[i].content.s = vals[i];
+        objs[i].content.len = n;
+    }
+}
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*Same key search as the getters, whitout conversion*/
+static double search_time(void)
+{
+    clock_t start = clock();
+    volatile long sink = 0;
+    int r, i;
+    for(r = 0; r < ROUNDS; r++) 
+        for(i = 0; i < VAL_CNT; i++) sink += msg_parser_get_str(objs[i], "v").len;
+    return elapsed(start);
+}
+
+int main()
+{
+    clock_t start;
+    volatile long sink = 0;
+    int r, i, ival;
+    float fval, fref;
+    unsigned legacy_err = 0, err = 0;
+
+    srand(1);
+
+    printf("Number parsing benchmark (%d values x %d rounds)\n", VAL_CNT, ROUNDS);
+    printf("===============================================\n\n");
+
+    init_vals(0);
+    printf("int   search:  %8.3f s (included in current)\n", search_time());
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) 
+        for(i = 0; i < VAL_CNT; i++) sink += legacy_get_int(&ival, objs[i]) + ival;
+    printf("int   legacy:  %8.3f s\n", elapsed(start));
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) 
+        for(i = 0; i < VAL_CNT; i++) sink += msg_parser_get_int(&ival, objs[i], "v") + ival;
+    printf("int   current: %8.3f s\n\n", elapsed(start));
+
+    init_vals(1);
+    printf("float search:  %8.3f s (included in current)\n", search_time());
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) 
+        for(i = 0; i < VAL_CNT; i++) sink += legacy_get_float(&fval, objs[i]) + (int)fval;
+    printf("float legacy:  %8.3f s\n", elapsed(start));
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) 
+        for(i = 0; i < VAL_CNT; i++) sink += msg_parser_get_float(&fval, objs[i], "v") + (int)fval;
+    printf("float current: %8.3f s\n\n", elapsed(start));
+
+    for(i = 0; i < VAL_CNT; i++) { // compare with the correctly rounded libc result
+        fref = strtof(vals[i] + 3, NULL);
+        legacy_get_float(&fval, objs[i]);
+        legacy_err += fval != fref;
+        msg_parser_get_float(&fval, objs[i], "v");
+        err += fval != fref;
+    }
+    printf("not correctly rounded floats: legacy %u / %d, current %u / %d\n", legacy_err, VAL_CNT, err, VAL_CNT);
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file bench_ring.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of master - slave round trip latency: shared buffer with mutex and polling
+ * against lock-free rings with futex wakeup
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "mcu_msg.h"
+
+#define POLL_ROUNDS     200
+#define RING_ROUNDS     20000
+#define POLL_US         1000
+#define BUFF_SIZE       256
+
+/*Shared buffers of the polling version, one per direction*/
+typedef struct {
+    char buff[BUFF_SIZE];
+    pthread_mutex_t lock;
+} shared_buff_t;
+
+static shared_buff_t to_slave, to_master;
+
+/*Rings of the lock-free version*/
+static char ring_buff[2][BUFF_SIZE];
+static msg_ring_t ring_to_slave, ring_to_master;
+
+static double rtt[RING_ROUNDS];
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double d = *(const double *)a - *(const double *)b;
+    return (d > 0) - (d < 0);
+}
+
+static void report(const char *name, int rounds)
+{
+    double sum = 0;
+    int i;
+    for(i = 0; i < rounds; i++) sum += rtt[i];
+    qsort(rtt, rounds, sizeof(double), cmp_double);
+    printf("%-16s avg %9.1f us  p50 %9.1f us  p99 %9.1f us  (%d round trips)\n",
+           name, sum / rounds, rtt[rounds / 2], rtt[rounds * 99 / 100], rounds);
+}
+
+/*Message with the round counter*/
+static msg_wrap_t ping_msg(const char *id, msg_wrap_obj_t *obj, msg_wrap_int_t *seq, int i)
+{
+    msg_wrap_t msg = msg_wrapper_create_msg((char *)id);
+    *obj = msg_wrapper_create_obj("Ping");
+    *seq = msg_wrapper_create_int("seq", i);
+    msg_wrapper_add_int_to_obj(obj, seq);
+    msg_wrapper_add_obj_to_msg(&msg, obj);
+    return msg;
+}
+
+/*Polling version: print under lock, poll with msg_get and sleep*/
+static void poll_send(shared_buff_t *sb, msg_ctx_t *ctx, msg_wrap_t msg)
+{
+    pthread_mutex_lock(&sb->lock);
+    msg_ctx_reset_str_buff(ctx);
+    msg_ctx_print_wrapper_msg(ctx, msg);
+    *ctx->p = '\0';
+    pthread_mutex_unlock(&sb->lock);
+}
+
+static int poll_recv(shared_buff_t *sb, const char *id)
+{
+    msg_t msg;
+    msg_obj_t obj;
+    int seq = -1;
+
+    while(1) {
+        pthread_mutex_lock(&sb->lock);
+        msg = msg_get(sb->buff, (char *)id, BUFF_SIZE);
+        if(msg_get_content(msg) != NULL) {
+            obj = msg_parser_get_obj(msg, "Ping");
+            msg_parser_get_int(&seq, obj, "seq");
+            sb->buff[0] = '\0';
+            pthread_mutex_unlock(&sb->lock);
+            return seq;
+        }
+        pthread_mutex_unlock(&sb->lock);
+        usleep(POLL_US);
+    }
+}
+
+static void *poll_slave(void *arg)
+{
+    msg_ctx_t ctx;
+    msg_wrap_obj_t obj;
+    msg_wrap_int_t seq;
+    int i;
+
+    (void)arg;
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_init_str_buff(&ctx, to_master.buff, BUFF_SIZE - 1);
+    msg_ctx_enable_buff(&ctx);
+    for(i = 0; i < POLL_ROUNDS; i++) {
+        poll_send(&to_master, &ctx, ping_msg("SLAVE_MSG", &obj, &seq, poll_recv(&to_slave, "MASTER_MSG")));
+    }
+    return 0;
+}
+
+/*Ring version: print into the ring, commit, sleep on futex*/
+static int ring_recv(msg_ring_t *ring, const char *id, char *buff)
+{
+    msg_t msg;
+    msg_obj_t obj;
+    int seq = -1;
+
+    while(msg_ring_wait(ring, -1)) {
+        msg = msg_get(buff, (char *)id, msg_ring_read(ring, buff, BUFF_SIZE + 1) + 1);
+        if(msg_get_content(msg) != NULL) {
+            obj = msg_parser_get_obj(msg, "Ping");
+            msg_parser_get_int(&seq, obj, "seq");
+            return seq;
+        }
+    }
+    return seq;
+}
+
+static void *ring_slave(void *arg)
+{
+    msg_ctx_t ctx;
+    msg_wrap_obj_t obj;
+    msg_wrap_int_t seq;
+    char buff[BUFF_SIZE + 1];
+    int i;
+
+    (void)arg;
+    msg_ctx_init_ring(&ctx, &ring_to_master);
+    for(i = 0; i < RING_ROUNDS; i++) {
+        msg_ctx_print_wrapper_msg(&ctx, ping_msg("SLAVE_MSG", &obj, &seq, ring_recv(&ring_to_slave, "MASTER_MSG", buff)));
+        msg_ring_commit(&ring_to_master);
+    }
+    return 0;
+}
+
+int main()
+{
+    pthread_t slave;
+    msg_ctx_t ctx;
+    msg_wrap_obj_t obj;
+    msg_wrap_int_t seq;
+    char buff[BUFF_SIZE + 1];
+    double start;
+    int i, lost = 0;
+
+    printf("Master - slave round trip latency\n");
+    printf("=================================\n\n");
+
+    pthread_mutex_init(&to_slave.lock, NULL);
+    pthread_mutex_init(&to_master.lock, NULL);
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_init_str_buff(&ctx, to_slave.buff, BUFF_SIZE - 1);
+    msg_ctx_enable_buff(&ctx);
+    pthread_create(&slave, NULL, poll_slave, NULL);
+    for(i = 0; i < POLL_ROUNDS; i++) {
+        start = now_us();
+        poll_send(&to_slave, &ctx, ping_msg("MASTER_MSG", &obj, &seq, i));
+        lost += poll_recv(&to_master, "SLAVE_MSG") != i;
+        rtt[i] = now_us() - start;
+    }
+    pthread_join(slave, NULL);
+    report("mutex + usleep", POLL_ROUNDS);
+
+    ring_to_slave = msg_ring_create(ring_buff[0], BUFF_SIZE);
+    ring_to_master = msg_ring_create(ring_buff[1], BUFF_SIZE);
+    msg_ctx_init_ring(&ctx, &ring_to_slave);
+    pthread_create(&slave, NULL, ring_slave, NULL);
+    for(i = 0; i < RING_ROUNDS; i++) {
+        start = now_us();
+        msg_ctx_print_wrapper_msg(&ctx, ping_msg("MASTER_MSG", &obj, &seq, i));
+        msg_ring_commit(&ring_to_slave);
+        lost += ring_recv(&ring_to_master, "SLAVE_MSG", buff) != i;
+        rtt[i] = now_us() - start;
+    }
+    pthread_join(slave, NULL);
+    report("ring + futex", RING_ROUNDS);
+    printf("lost or reordered: %d\n", lost);
+    return 0;
+}
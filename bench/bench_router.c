@@ -0,0 +1,109 @@
+/**
+ * @file bench_router.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of message dispatch: chain of msg_get and msg_parser_get_cmd calls against
+ * the router with growing count of registered ids
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "mcu_msg.h"
+
+#define ROUNDS      200000
+#define ID_MAX      64
+#define NODE_SIZE   1024
+
+static char ids[ID_MAX][16];
+static char buff[ID_MAX][128];
+static msg_size_t len[ID_MAX];
+static msg_route_node_t node[NODE_SIZE];
+static msg_route_t route[ID_MAX + 2];
+
+/*Count of registered ids*/
+static const int id_cnt[] = {4, 16, 64};
+
+/*Handled messages and commands*/
+static long handled;
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void msg_handler(msg_t msg, msg_cmd_t cmd, void *arg)
+{
+    (void)msg;
+    (void)cmd;
+    handled += (long)arg;
+}
+
+static void cmd_handler(msg_t msg, msg_cmd_t cmd, void *arg)
+{
+    (void)msg;
+    handled += cmd.cmd.len + (long)arg;
+}
+
+/*Every id is tried by msg_get, the commands are searched in the found message*/
+static void chain(int n, int r)
+{
+    msg_cmd_t cmd;
+    msg_t msg;
+    int k;
+
+    for(k = 0; k < n; k++) {
+        msg = msg_get(buff[r], ids[k], len[r]);
+        if(msg.content.s == NULL) continue;
+        msg_destroy_cmd(&cmd);
+        msg_handler(msg, cmd, (void*)(long)(k + 1));
+        cmd = msg_parser_get_cmd(msg, "Get_Temp");
+        if(cmd.cmd.s != NULL) cmd_handler(msg, cmd, (void*)100L);
+        cmd = msg_parser_get_cmd(msg, "Set_Mode");
+        if(cmd.cmd.s != NULL) cmd_handler(msg, cmd, (void*)200L);
+        break;
+    }
+}
+
+int main()
+{
+    msg_router_t router;
+    msg_size_t cursor;
+    clock_t start;
+    int i, c, n;
+
+    for(i = 0; i < ID_MAX; i++) {
+        sprintf(ids[i], "DEV_%02d", i);
+        len[i] = sprintf(buff[i], "#DEV_%02d{<Get_Temp><Set_Mode>@Cfg($mode=%d;$T=21.5;$name='unit <%d>')}", i, i % 4, i);
+    }
+
+    printf("Message dispatch (%d rounds)\n", ROUNDS);
+    printf("==============================================\n");
+
+    for(c = 0; c < (int)(sizeof(id_cnt) / sizeof(id_cnt[0])); c++) {
+        n = id_cnt[c];
+        printf("\n%d registered ids\n", n);
+
+        handled = 0;
+        start = clock();
+        for(i = 0; i < ROUNDS; i++) chain(n, i % n);
+        printf("msg_get chain:      %8.3f s (checksum %ld)\n", elapsed(start), handled);
+
+        router = msg_router_create(node, NODE_SIZE, route, ID_MAX + 2);
+        for(i = 0; i < n; i++) msg_router_add(&router, ids[i], msg_handler, (void*)(long)(i + 1));
+        msg_router_add_cmd(&router, NULL, "Get_Temp", cmd_handler, (void*)100L);
+        msg_router_add_cmd(&router, NULL, "Set_Mode", cmd_handler, (void*)200L);
+        handled = 0;
+        start = clock();
+        for(i = 0; i < ROUNDS; i++) {
+            cursor = 0;
+            msg_router_dispatch(&router, buff[i % n], len[i % n], &cursor);
+        }
+        printf("msg_router_dispatch:%8.3f s (checksum %ld, %d nodes)\n", elapsed(start), handled, (int)router.cnt);
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file bench_rx.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of the receive loop: re-parsing the buffer from the start, removing the handled
+ * message by shifting and receive buffer with cursor and bulk compaction
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "mcu_msg.h"
+
+#define ROUNDS      20000
+#define BURST_CNT   40
+#define BUFF_SIZE   4096
+
+static char burst[BURST_CNT * 64];
+static char buff[BUFF_SIZE];
+
+/*Size of received chunks (UART interrupt, DMA, read call)*/
+static const msg_size_t chunks[] = {48, 512, 4000};
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*Handle message, returns the value of the key*/
+static int handle(msg_t msg)
+{
+    int v = 0;
+    msg_parser_get_int(&v, msg_parser_get_obj(msg, "S"), "seq");
+    return v;
+}
+
+/*Buffer is kept until the burst is received, every poll parses it from the start and skips the handled messages*/
+static long loop_rescan(msg_size_t burst_len, msg_size_t chunk, int *handled)
+{
+    msg_size_t len, n, cursor;
+    msg_t msg;
+    long sum = 0;
+    int r, i, k, done;
+
+    for(r = 0; r < ROUNDS; r++) {
+        len = 0;
+        done = 0;
+        for(i = 0; i < burst_len; i += chunk) {
+            n = burst_len - i < chunk ? burst_len - i : chunk;
+            memcpy(buff + len, burst + i, n);
+            len += n;
+            buff[len] = '\0';
+            cursor = 0;
+            for(k = 0; (msg = msg_next(buff, len, &cursor)).content.s != NULL; k++) {
+                if(k < done) continue;
+                sum += handle(msg);
+                (*handled)++;
+                done++;
+            }
+        }
+    }
+    return sum;
+}
+
+/*Buffer is parsed from the start after every chunk, handled message is removed by shifting the buffer*/
+static long loop_shift(msg_size_t burst_len, msg_size_t chunk, int *handled)
+{
+    msg_size_t len, n;
+    msg_t msg;
+    long sum = 0;
+    int r, i;
+
+    for(r = 0; r < ROUNDS; r++) {
+        len = 0;
+        for(i = 0; i < burst_len; i += chunk) {
+            n = burst_len - i < chunk ? burst_len - i : chunk;
+            memcpy(buff + len, burst + i, n);
+            len += n;
+            buff[len] = '\0';
+            while(1) {
+                msg = msg_get(buff, "TLM", len);
+                if(msg.content.s == NULL || msg.content.s + msg.content.len >= buff + len) break;
+                sum += handle(msg);
+                (*handled)++;
+                n = msg.content.s + msg.content.len + 1 - buff;
+                memmove(buff, buff + n, len - n + 1);
+                len -= n;
+            }
+        }
+    }
+    return sum;
+}
+
+/*Receive buffer, scans start from the cursor*/
+static long loop_rx(msg_size_t burst_len, msg_size_t chunk, int *handled)
+{
+    msg_rx_t rx;
+    msg_t msg;
+    long sum = 0;
+    int r, i;
+
+    for(r = 0; r < ROUNDS; r++) {
+        rx = msg_rx_create(buff, BUFF_SIZE);
+        for(i = 0; i < burst_len; i += chunk) {
+            msg_rx_write(&rx, burst + i, burst_len - i < chunk ? burst_len - i : chunk);
+            msg = msg_rx_get(&rx, "TLM");
+            while(msg.content.s != NULL) {
+                sum += handle(msg);
+                (*handled)++;
+                msg_consume(&rx, msg);
+                msg = msg_rx_get(&rx, "TLM");
+            }
+        }
+    }
+    return sum;
+}
+
+int main()
+{
+    clock_t start;
+    msg_size_t burst_len = 0;
+    long sum;
+    int i, c, handled;
+
+    for(i = 0; i < BURST_CNT; i++) {
+        burst_len += sprintf(burst + burst_len, "#TLM{@S($seq=%d;$T=21.%02d;$fw='v1.2.3')}\r\n", i, i);
+    }
+
+    printf("Receive loop (%d messages, %d bytes x %d rounds)\n", BURST_CNT, (int)burst_len, ROUNDS);
+    printf("==============================================\n");
+
+    for(c = 0; c < (int)(sizeof(chunks) / sizeof(chunks[0])); c++) {
+        printf("\n%d byte chunks\n", (int)chunks[c]);
+        handled = 0;
+        start = clock();
+        sum = loop_rescan(burst_len, chunks[c], &handled);
+        printf("msg_next rescan:   %8.3f s (%d handled, checksum %ld)\n", elapsed(start), handled, sum);
+        handled = 0;
+        start = clock();
+        sum = loop_shift(burst_len, chunks[c], &handled);
+        printf("msg_get + shift:   %8.3f s (%d handled, checksum %ld)\n", elapsed(start), handled, sum);
+        handled = 0;
+        start = clock();
+        sum = loop_rx(burst_len, chunks[c], &handled);
+        printf("msg_rx + consume:  %8.3f s (%d handled, checksum %ld)\n", elapsed(start), handled, sum);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file bench_seg.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Benchmark of the receive path of a ring: copy to linear buffer and parse against
+ * parsing the two-segment view in place
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "mcu_msg.h"
+
+#define ROUNDS      1000000
+#define RING_SIZE   4096
+
+static char ring_buff[RING_SIZE], lin[RING_SIZE + 1];
+static char text[] = "#SENSOR{@Temp($T1=32.45;$T2=-29.34;$cnt=123456;$name='outdoor unit')"
+                     "@Status($up=86400;$err=0;$fw='v1.2.3-rc4')"
+                     "@Log($last='boot ok, sensor calibrated, link up, 3 retries on the first frame, "
+                     "reference voltage 3.298 V, humidity sensor missing, fallback to the internal sensor, "
+                     "uptime counter restored from backup register, watchdog enabled with 2 s period')}";
+
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main()
+{
+    msg_ring_t ring = msg_ring_create(ring_buff, RING_SIZE);
+    msg_str_t src = {text, sizeof(text) - 1};
+    msg_ctx_t ctx;
+    msg_seg_t view;
+    msg_seg_msg_t smsg;
+    msg_seg_obj_t sobj;
+    msg_t msg;
+    msg_obj_t obj;
+    clock_t start;
+    float T1, T2;
+    int cnt, r, wraps = 0;
+    double sum;
+
+    msg_ctx_init_ring(&ctx, &ring);
+
+    printf("Ring receive path (%d bytes message x %d rounds)\n", (int)src.len, ROUNDS);
+    printf("==============================================\n\n");
+
+    sum = 0;
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        msg_ctx_print_str(&ctx, src);
+        msg_ring_commit(&ring);
+        msg = msg_get(lin, "SENSOR", msg_ring_read(&ring, lin, sizeof(lin)) + 1);
+        obj = msg_parser_get_obj(msg, "Temp");
+        msg_parser_get_float(&T1, obj, "T1");
+        msg_parser_get_float(&T2, obj, "T2");
+        msg_parser_get_int(&cnt, obj, "cnt");
+        sum += T1 + T2 + cnt;
+    }
+    printf("copy + msg_get:     %8.3f s (checksum %.2f)\n", elapsed(start), sum);
+
+    sum = 0;
+    start = clock();
+    for(r = 0; r < ROUNDS; r++) {
+        msg_ctx_print_str(&ctx, src);
+        msg_ring_commit(&ring);
+        msg_ring_peek(&ring, view.part);
+        wraps += view.part[1].len != 0;
+        smsg = msg_get_seg(view, "SENSOR");
+        sobj = msg_parser_get_obj_seg(smsg, "Temp");
+        msg_parser_get_float_seg(&T1, sobj, "T1");
+        msg_parser_get_float_seg(&T2, sobj, "T2");
+        msg_parser_get_int_seg(&cnt, sobj, "cnt");
+        msg_ring_consume(&ring, msg_seg_len(view));
+        sum += T1 + T2 + cnt;
+    }
+    printf("in place msg_get_seg:%7.3f s (checksum %.2f, %d%% wrapped)\n", elapsed(start), sum, wraps * 100 / ROUNDS);
+    return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file cap_main.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Capture extractor: the fields of the messages are listed from a capture file as CSV lines
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "capture.h"
+
+static cap_t cap;
+
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-t threads] [-c chunk_kb] capture_file MSG_ID[.obj.key] ...\n", name);
+}
+
+/*Split field spec MSG_ID.obj.key (the ids are kept until the end)*/
+static int add_field(const char *arg)
+{
+    char *spec = strdup(arg), *obj, *key = NULL;
+
+    if(spec == NULL) return -1;
+    if((obj = strchr(spec, '.')) != NULL) {
+        *obj++ = '\0';
+        if((key = strchr(obj, '.')) == NULL) return -1;
+        *key++ = '\0';
+    }
+    return cap_add_field(&cap, spec, obj, key);
+}
+
+int main(int argc, char **argv)
+{
+    struct timespec t0, t1;
+    struct stat st;
+    const char *base;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN), chunk_kb = 0;
+    int opt, fd, i;
+
+    while((opt = getopt(argc, argv, "t:c:h")) != -1) {
+        switch(opt) {
+            case 't': threads = atoi(optarg); break;
+            case 'c': chunk_kb = atoi(optarg); break;
+            default:  usage(argv[0]); return 1;
+        }
+    }
+    if(threads < 1 || threads > CAP_THREAD_MAX || chunk_kb < 0 || optind + 2 > argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if((fd = open(argv[optind], O_RDONLY)) < 0 || fstat(fd, &st) < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    base = st.st_size ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : "";
+    if(base == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    cap_init(&cap, base, st.st_size);
+    for(i = optind + 1; i < argc; i++) {
+        if(add_field(argv[i]) < 0) {
+            fprintf(stderr, "invalid field: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if(cap_run(&cap, threads, (size_t)chunk_kb * 1024) < 0) {
+        perror("capture");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if(cap_write(&cap, stdout) < 0) perror("write");
+
+    fprintf(stderr, "%zu bytes, %llu messages, %llu lines, %u chunks (%u resynced), %d threads, %.3f s\n",
+            cap.len, (unsigned long long)cap.msgs, (unsigned long long)cap.lines, cap.chunk_cnt, cap.resync,
+            threads, t1.tv_sec - t0.tv_sec + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    cap_free(&cap);
+    if(st.st_size) munmap((void *)base, st.st_size);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,400 @@
+/**
+ * @file capture.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Parallel parser of large capture files (chunk split, work-stealing pool, ordered merge)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "capture.h"
+
+/*Max. length of one msg_next call, longer messages are skipped*/
+#define __CAP_WINDOW            ((msg_size_t)~0)
+
+/*Message flag at the start of a line, where chunks are split*/
+#define __CAP_FLAG              '#'
+
+/*Size of the first out buffer of a chunk*/
+#define __CAP_OUT_SIZE          4096
+
+/*Empty chunk range of a worker*/
+#define __CAP_RANGE_EMPTY       ((uint32_t)~0)
+
+
+static msg_t        __cap_next(const cap_t *cap, size_t *pos);
+static char*        __cap_reserve(cap_chunk_t *ch, size_t n);
+static void         __cap_put(cap_chunk_t *ch, const char *p, size_t n);
+static void         __cap_put_val(cap_chunk_t *ch, msg_obj_t obj, char *key);
+static void         __cap_extract(cap_t *cap, cap_chunk_t *ch, msg_t msg, size_t offset);
+static void         __cap_parse(cap_t *cap, cap_chunk_t *ch, size_t start);
+static size_t       __cap_boundary(const cap_t *cap, size_t pos);
+static uint32_t     __cap_take(cap_worker_t *w);
+static uint32_t     __cap_steal(cap_worker_t *w);
+static void*        __cap_worker_fnc(void *arg);
+
+
+/**
+ * @brief Get the next complete message, the capture is scanned in windows of msg_size_t
+ * Zero bytes (line noise) and messages longer than the window are skipped
+ *
+ * @param cap capture
+ * @param pos scan position, it's set after the message
+ * @return msg_t message or destroyed message at the end of the capture
+ */
+static msg_t __cap_next(const cap_t *cap, size_t *pos)
+{
+    msg_size_t n, c;
+    msg_t msg;
+
+    while(*pos < cap->len) {
+        n = cap->len - *pos < __CAP_WINDOW ? (msg_size_t)(cap->len - *pos) : __CAP_WINDOW;
+        c = 0;
+        msg = msg_next((char *)cap->base + *pos, n, &c);
+        if(msg.content.s != NULL) {
+            *pos += c;
+            return msg;
+        }
+        if(c < n && cap->base[*pos + c] == '\0') { // scan stopped at zero byte
+            c++;
+        } else if(c == 0) { // incomplete message at the start of the window
+            if(*pos + n >= cap->len && memchr(cap->base + *pos, 0, n) == NULL) break;
+            c = 1; // too long or broken by zero byte, resync after its flag
+        }
+        *pos += c;
+    }
+    msg_destroy(&msg);
+    return msg;
+}
+
+/**
+ * @brief Reserve space in the out buffer of the chunk
+ *
+ * @param ch chunk
+ * @param n count of bytes
+ * @return char* free space or NULL if the memory is out (err is set)
+ */
+static char *__cap_reserve(cap_chunk_t *ch, size_t n)
+{
+    size_t size = ch->out_size ? ch->out_size : __CAP_OUT_SIZE;
+    char *p;
+
+    if(ch->err) return NULL;
+    while(size < ch->out_len + n) size *= 2;
+    if(size != ch->out_size) {
+        if((p = realloc(ch->out, size)) == NULL) {
+            ch->err = 1;
+            return NULL;
+        }
+        ch->out = p;
+        ch->out_size = size;
+    }
+    return ch->out + ch->out_len;
+}
+
+/**
+ * @brief Append bytes to the out buffer of the chunk
+ *
+ * @param ch chunk
+ * @param p bytes
+ * @param n count of bytes
+ */
+static void __cap_put(cap_chunk_t *ch, const char *p, size_t n)
+{
+    char *dst = __cap_reserve(ch, n);
+
+    if(dst == NULL) return;
+    memcpy(dst, p, n);
+    ch->out_len += n;
+}
+
+/**
+ * @brief Append value of the key, strings are quoted if they contain separator or quote
+ * Numbers are copied as raw text of the capture, they aren't formatted again
+ *
+ * @param ch chunk
+ * @param obj object
+ * @param key key
+ */
+static void __cap_put_val(cap_chunk_t *ch, msg_obj_t obj, char *key)
+{
+    msg_str_t id, val, str;
+    msg_size_t i, cursor = 0;
+    double d;
+
+    while((id = msg_parser_next_key(obj, &cursor, &val)).s != NULL) { // first occurrence, like the getters
+        if(strncmp(id.s, key, id.len) == 0 && key[id.len] == '\0') break;
+    }
+    if(id.s == NULL) return;
+
+    str = msg_val_to_str(val);
+    if(str.s != NULL) {
+        if(memchr(str.s, ',', str.len) == NULL && memchr(str.s, '"', str.len) == NULL && memchr(str.s, '\n', str.len) == NULL) {
+            __cap_put(ch, str.s, str.len);
+            return;
+        }
+        __cap_put(ch, "\"", 1);
+        for(i = 0; i < str.len; i++) {
+            if(str.s[i] == '"') __cap_put(ch, "\"", 1);
+            __cap_put(ch, str.s + i, 1);
+        }
+        __cap_put(ch, "\"", 1);
+    } else if(msg_num_ok(msg_val_to_double(&d, val))) {
+        __cap_put(ch, val.s, val.len);
+    }
+}
+
+/**
+ * @brief Extract the fields of the message to the out buffer of the chunk
+ *
+ * @param cap capture
+ * @param ch chunk
+ * @param msg message
+ * @param offset offset of the message in the capture
+ */
+static void __cap_extract(cap_t *cap, cap_chunk_t *ch, msg_t msg, size_t offset)
+{
+    msg_size_t route = msg_router_find(&cap->router, msg.id);
+    char head[32];
+    uint16_t i;
+
+    if(route == MSG_ROUTE_NONE) return;
+    __cap_put(ch, head, snprintf(head, sizeof(head), "%zu,", offset));
+    __cap_put(ch, msg.id.s, msg.id.len);
+    for(i = 0; i < cap->field_cnt; i++) {
+        if(cap->field[i].route != route || cap->field[i].key == NULL) continue;
+        __cap_put(ch, ",", 1);
+        __cap_put_val(ch, msg_parser_get_obj(msg, cap->field[i].obj), cap->field[i].key);
+    }
+    __cap_put(ch, "\n", 1);
+    ch->lines++;
+}
+
+/**
+ * @brief Parse the messages of the chunk from start
+ * The message which starts before end is completed, the scan stops at the first message after end
+ *
+ * @param cap capture
+ * @param ch chunk
+ * @param start start of the scan (start of the chunk or the first message after the previous chunk)
+ */
+static void __cap_parse(cap_t *cap, cap_chunk_t *ch, size_t start)
+{
+    size_t pos = start, offset;
+    msg_t msg;
+
+    ch->first = ch->next = cap->len;
+    ch->out_len = 0;
+    ch->msgs = ch->lines = 0;
+    while((msg = __cap_next(cap, &pos)).content.s != NULL) {
+        offset = msg.id.s - 1 - cap->base; // position of the message flag
+        if(ch->first == cap->len) ch->first = offset;
+        if(offset >= ch->end) {
+            ch->next = offset;
+            break;
+        }
+        ch->msgs++;
+        __cap_extract(cap, ch, msg, offset);
+    }
+}
+
+/**
+ * @brief Find chunk boundary: the next message flag at the start of a line
+ * It's only a guess, the flag can be in an internal string, the merge checks it
+ *
+ * @param cap capture
+ * @param pos nominal position
+ * @return size_t boundary or the capture length
+ */
+static size_t __cap_boundary(const cap_t *cap, size_t pos)
+{
+    const char *p = cap->base + pos, *end = cap->base + cap->len;
+
+    while(p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+        if(++p < end && *p == __CAP_FLAG) return p - cap->base;
+    }
+    return cap->len;
+}
+
+/**
+ * @brief Take chunk from the front of the own range
+ *
+ * @param w worker
+ * @return uint32_t chunk index or __CAP_RANGE_EMPTY
+ */
+static uint32_t __cap_take(cap_worker_t *w)
+{
+    uint64_t r = __atomic_load_n(&w->range, __ATOMIC_ACQUIRE);
+    uint32_t first, end;
+
+    do {
+        first = (uint32_t)r;
+        end = (uint32_t)(r >> 32);
+        if(first >= end) return __CAP_RANGE_EMPTY;
+    } while(!__atomic_compare_exchange_n(&w->range, &r, r + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    return first;
+}
+
+/**
+ * @brief Steal chunk from the back of the range of other workers
+ *
+ * @param w thief worker
+ * @return uint32_t chunk index or __CAP_RANGE_EMPTY if every range is empty
+ */
+static uint32_t __cap_steal(cap_worker_t *w)
+{
+    cap_t *cap = w->cap;
+    cap_worker_t *v;
+    uint64_t r;
+    uint32_t first, end;
+    uint16_t k;
+
+    for(k = 1; k < cap->worker_cnt; k++) {
+        v = &cap->worker[(w->idx + k) % cap->worker_cnt];
+        r = __atomic_load_n(&v->range, __ATOMIC_ACQUIRE);
+        do {
+            first = (uint32_t)r;
+            end = (uint32_t)(r >> 32);
+            if(first >= end) break;
+        } while(!__atomic_compare_exchange_n(&v->range, &r, ((uint64_t)(end - 1) << 32) | first, 0,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+        if(first < end) {
+            w->stolen++;
+            return end - 1;
+        }
+    }
+    return __CAP_RANGE_EMPTY;
+}
+
+/**
+ * @brief Worker thread: own chunks are parsed from the front, then chunks are stolen
+ *
+ * @param arg worker
+ * @return void* NULL
+ */
+static void *__cap_worker_fnc(void *arg)
+{
+    cap_worker_t *w = (cap_worker_t *)arg;
+    cap_chunk_t *ch;
+    uint32_t i;
+
+    while((i = __cap_take(w)) != __CAP_RANGE_EMPTY || (i = __cap_steal(w)) != __CAP_RANGE_EMPTY) {
+        ch = &w->cap->chunk[i];
+        __cap_parse(w->cap, ch, ch->start);
+        w->parsed++;
+    }
+    return NULL;
+}
+
+/*Init capture*/
+void cap_init(cap_t *cap, const char *base, size_t len)
+{
+    memset(cap, 0, sizeof(*cap));
+    cap->base = base;
+    cap->len = len;
+    cap->router = msg_router_create(cap->route_node, CAP_ROUTE_NODE_SIZE, cap->route, CAP_FIELD_MAX);
+}
+
+/*Add extracted field*/
+int cap_add_field(cap_t *cap, char *id, char *obj, char *key)
+{
+    cap_field_t *f;
+    msg_size_t route;
+
+    if(cap->field_cnt >= CAP_FIELD_MAX || (route = msg_router_add(&cap->router, id, NULL, NULL)) == MSG_ROUTE_NONE) return -1;
+    f = &cap->field[cap->field_cnt++];
+    f->id = id;
+    f->obj = obj;
+    f->key = obj != NULL ? key : NULL;
+    f->route = route;
+    return 0;
+}
+
+/*Split and parse capture*/
+int cap_run(cap_t *cap, uint16_t threads, size_t chunk_size)
+{
+    uint32_t i, per;
+    size_t start = 0;
+    uint16_t t;
+    int err = 0;
+
+    cap_free(cap);
+    if(!chunk_size) chunk_size = CAP_CHUNK_SIZE;
+    if(!threads) threads = 1;
+    if(threads > CAP_THREAD_MAX) threads = CAP_THREAD_MAX;
+    cap->chunk_cnt = cap->len / chunk_size + 1;
+    cap->chunk = calloc(cap->chunk_cnt, sizeof(cap_chunk_t));
+    cap->worker = calloc(threads, sizeof(cap_worker_t));
+    if(cap->chunk == NULL || cap->worker == NULL) {
+        cap_free(cap);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    /*Chunks start at message flags after the nominal positions*/
+    for(i = 0; i < cap->chunk_cnt; i++) {
+        cap->chunk[i].start = start;
+        start = i + 1 < cap->chunk_cnt ? __cap_boundary(cap, (i + 1) * chunk_size) : cap->len;
+        if(start < cap->chunk[i].start) start = cap->chunk[i].start;
+        cap->chunk[i].end = start;
+    }
+
+    /*Every worker owns a contiguous range of chunks*/
+    cap->worker_cnt = threads;
+    per = cap->chunk_cnt / threads;
+    for(t = 0, i = 0; t < threads; t++) {
+        cap->worker[t].idx = t;
+        cap->worker[t].cap = cap;
+        cap->worker[t].range = ((uint64_t)(i + per + (t < cap->chunk_cnt % threads)) << 32) | i;
+        i += per + (t < cap->chunk_cnt % threads);
+    }
+    for(t = 1; t < threads; t++) {
+        if(pthread_create(&cap->worker[t].thr, NULL, __cap_worker_fnc, &cap->worker[t]) != 0) break;
+    }
+    __cap_worker_fnc(&cap->worker[0]); // the caller is the first worker
+    while(--t > 0) pthread_join(cap->worker[t].thr, NULL);
+
+    /*Merge: a chunk is valid if its first message is the one where the previous chunk stopped*/
+    for(i = 0; i < cap->chunk_cnt; i++) {
+        if(i && cap->chunk[i].first != cap->chunk[i - 1].next) {
+            __cap_parse(cap, &cap->chunk[i], cap->chunk[i - 1].next);
+            cap->resync++;
+        }
+        cap->msgs += cap->chunk[i].msgs;
+        cap->lines += cap->chunk[i].lines;
+        err |= cap->chunk[i].err;
+    }
+    if(err) errno = ENOMEM;
+    return err ? -1 : 0;
+}
+
+/*Write extracted lines*/
+int cap_write(cap_t *cap, FILE *f)
+{
+    uint32_t i;
+
+    for(i = 0; i < cap->chunk_cnt; i++) {
+        if(cap->chunk[i].out_len && fwrite(cap->chunk[i].out, 1, cap->chunk[i].out_len, f) != cap->chunk[i].out_len) return -1;
+    }
+    return 0;
+}
+
+/*Release chunks and workers*/
+void cap_free(cap_t *cap)
+{
+    uint32_t i;
+
+    for(i = 0; cap->chunk != NULL && i < cap->chunk_cnt; i++) free(cap->chunk[i].out);
+    free(cap->chunk);
+    free(cap->worker);
+    cap->chunk = NULL;
+    cap->worker = NULL;
+    cap->chunk_cnt = cap->worker_cnt = 0;
+    cap->resync = 0;
+    cap->msgs = cap->lines = 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file capture.h
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Parallel parser of large capture files: the capture is split at message boundaries,
+ * the chunks are parsed on a work-stealing thread pool and the extracted fields are merged in order
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __MCU_MSG_CAPTURE__
+#define __MCU_MSG_CAPTURE__
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "mcu_msg.h"
+
+#if !MCU_MSG_USE_ROUTER
+#error "capture needs MCU_MSG_USE_ROUTER"
+#endif
+
+
+/*Default size of a chunk*/
+#define CAP_CHUNK_SIZE          (1024 * 1024)
+
+/*Max. count of extracted fields*/
+#define CAP_FIELD_MAX           64
+
+/*Size of the id trie of the field message ids*/
+#define CAP_ROUTE_NODE_SIZE     512
+
+/*Max. count of threads*/
+#define CAP_THREAD_MAX          64
+
+
+struct cap;
+
+/*Extracted field, key is NULL if only the message is listed*/
+typedef struct cap_field {
+    char           *id;                        /* message id                            */
+    char           *obj;                       /* object id                             */
+    char           *key;                       /* key                                   */
+    msg_size_t      route;                     /* route of the message id               */
+} cap_field_t;
+
+/*
+Chunk of the capture
+Messages which start in [start, end) belong to the chunk, the last one may end after end
+*/
+typedef struct cap_chunk {
+    size_t          start;                     /* first byte                            */
+    size_t          end;                       /* end of the range                      */
+    size_t          first;                     /* start of the first found message      */
+    size_t          next;                      /* start of the first message after end  */
+    char           *out;                       /* extracted lines                       */
+    size_t          out_len;                   /* length of the lines                   */
+    size_t          out_size;                  /* size of the out buffer                */
+    uint64_t        msgs;                      /* count of messages                     */
+    uint64_t        lines;                     /* count of extracted lines              */
+    uint8_t         err;                       /* out of memory                         */
+} cap_chunk_t;
+
+/*Worker thread of the pool*/
+typedef struct cap_worker {
+    pthread_t       thr;                       /* thread                                */
+    uint64_t        range;                     /* own chunks: first (low 32 bits), end (high 32 bits) */
+    uint32_t        parsed;                    /* count of parsed chunks                */
+    uint32_t        stolen;                    /* count of chunks stolen from others    */
+    uint16_t        idx;                       /* index in the worker array             */
+    struct cap     *cap;                       /* capture                               */
+} cap_worker_t;
+
+/*Capture*/
+typedef struct cap {
+    const char     *base;                      /* capture bytes                         */
+    size_t          len;                       /* capture length                        */
+    cap_field_t     field[CAP_FIELD_MAX];      /* extracted fields                      */
+    uint16_t        field_cnt;                 /* count of fields                       */
+    msg_router_t    router;                    /* id trie of the message ids            */
+    msg_route_node_t route_node[CAP_ROUTE_NODE_SIZE]; /* nodes of the id trie          */
+    msg_route_t     route[CAP_FIELD_MAX];      /* routes of the id trie                 */
+    cap_chunk_t    *chunk;                     /* chunks (allocated by cap_run)         */
+    uint32_t        chunk_cnt;                 /* count of chunks                       */
+    cap_worker_t   *worker;                    /* workers (allocated by cap_run)        */
+    uint16_t        worker_cnt;                /* count of workers                      */
+    uint32_t        resync;                    /* chunks parsed again (boundary in a string) */
+    uint64_t        msgs;                      /* count of messages                     */
+    uint64_t        lines;                     /* count of extracted lines              */
+} cap_t;
+
+
+/**
+ * @brief Init capture
+ *
+ * @param cap capture
+ * @param base capture bytes (e.g. mapped file), it's not modified
+ * @param len capture length
+ */
+void        cap_init (cap_t *cap, const char *base, size_t len);
+
+/**
+ * @brief Add extracted field, every message with the id is listed with its fields in the order of adding
+ *
+ * @param cap capture
+ * @param id message id
+ * @param obj object id, NULL to list the message only
+ * @param key key
+ * @return int 0 or -1 if the id is invalid or the table is full
+ */
+int         cap_add_field (cap_t *cap, char *id, char *obj, char *key);
+
+/**
+ * @brief Split the capture and parse the chunks on the thread pool
+ *
+ * @param cap capture
+ * @param threads count of threads
+ * @param chunk_size nominal size of the chunks, CAP_CHUNK_SIZE if it's 0
+ * @return int 0 or -1 on error (errno is set)
+ */
+int         cap_run (cap_t *cap, uint16_t threads, size_t chunk_size);
+
+/**
+ * @brief Write the extracted lines in the order of the capture
+ * Line: byte offset of the message, message id, values of the fields (separated by comma)
+ * @param cap capture
+ * @param f output file
+ * @return int 0 or -1 on error
+ */
+int         cap_write (cap_t *cap, FILE *f);
+
+/**
+ * @brief Release the chunks and workers
+ *
+ * @param cap capture
+ */
+void        cap_free (cap_t *cap);
+
+#endif /*EOF*/
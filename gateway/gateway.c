@@ -0,0 +1,487 @@
+/**
+ * @file gateway.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Multi-port serial gateway on linux (epoll, stream parser per port, worker pool)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pty.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "gateway.h"
+
+/*epoll tag of the stop eventfd*/
+#define __GW_STOP_TAG           0xFFFFFFFFUL
+
+/*Max. count of events of one epoll_wait*/
+#define __GW_MAX_EVENTS         64
+
+
+static int          __gw_port_write(void *arg, const char *p, msg_size_t n);
+static void         __gw_port_events(gw_t *gw, gw_port_t *port, uint32_t events);
+static void         __gw_port_close(gw_t *gw, gw_port_t *port);
+static void         __gw_flush_port(gw_t *gw, gw_port_t *port);
+static gw_port_t*   __gw_port_add(gw_t *gw, int fd, const char *name);
+static speed_t      __gw_speed(int baud);
+static uint16_t     __gw_find_handler(gw_t *gw, msg_str_t id);
+static void         __gw_put16(char *p, uint16_t v);
+static uint16_t     __gw_get16(const char *p);
+static void         __gw_dispatch(gw_t *gw, gw_port_t *port);
+static int          __gw_read_port(gw_t *gw, gw_port_t *port);
+static void*        __gw_worker_fnc(void *arg);
+
+
+/**
+ * @brief Sink write of the port output (worker of the port). It's written directly while the output
+ * queue is empty, the rest is queued and sent by the epoll loop when the device is writable
+ *
+ * @param arg port
+ * @param p span
+ * @param n span length
+ * @return int written or queued bytes
+ */
+static int __gw_port_write(void *arg, const char *p, msg_size_t n)
+{
+    gw_port_t *port = (gw_port_t *)arg;
+    msg_sink_t sink = msg_ring_sink(&port->tx);
+    msg_size_t done = 0;
+    ssize_t r;
+
+    if(port->closed || port->fd < 0) return 0;
+    while(done < n && msg_ring_space(&port->tx) == GW_PORT_TX_SIZE) { // nothing is queued, the order is kept
+        r = write(port->fd, p + done, n - done);
+        if(r > 0) {
+            done += r;
+        } else if(r < 0 && errno == EAGAIN) {
+            break;
+        } else if(r < 0 && errno != EINTR) {
+            return done; // device is closed, the epoll loop closes the port
+        }
+    }
+    if(done == n) return n;
+    if(msg_ring_space(&port->tx) < n - done) {
+        port->tx_dropped += n - done;
+        return done;
+    }
+    sink.write(sink.arg, p + done, n - done);
+    msg_ring_commit(&port->tx);
+    __gw_port_events(port->gw, port, EPOLLIN | EPOLLOUT);
+    return n;
+}
+
+/**
+ * @brief Set the epoll events of the port
+ *
+ * @param gw gateway
+ * @param port port
+ * @param events epoll events
+ */
+static void __gw_port_events(gw_t *gw, gw_port_t *port, uint32_t events)
+{
+    struct epoll_event ev;
+
+    ev.events = events;
+    ev.data.u32 = port->idx;
+    epoll_ctl(gw->epfd, EPOLL_CTL_MOD, port->fd, &ev);
+}
+
+/**
+ * @brief Remove the port from epoll after EOF or error (epoll thread). The file descriptor is
+ * closed by the worker of the port after its queued messages (close record)
+ *
+ * @param gw gateway
+ * @param port port
+ */
+static void __gw_port_close(gw_t *gw, gw_port_t *port)
+{
+    gw_worker_t *w = &gw->worker[port->idx % gw->worker_cnt];
+    msg_sink_t sink = msg_ring_sink(&w->ring);
+    char hdr[GW_HDR_SIZE] = {0};
+
+    epoll_ctl(gw->epfd, EPOLL_CTL_DEL, port->fd, NULL);
+    port->closed = 1;
+    __gw_put16(hdr, port->idx);
+    __gw_put16(hdr + 2, GW_HND_CLOSE);
+    sink.write(sink.arg, hdr, GW_HDR_SIZE);
+    msg_ring_commit(&w->ring); // if the ring is full, gw_close closes the descriptor
+}
+
+/**
+ * @brief Send the queued output of the port (epoll thread, the device is writable)
+ *
+ * @param gw gateway
+ * @param port port
+ */
+static void __gw_flush_port(gw_t *gw, gw_port_t *port)
+{
+    msg_str_t seg[2];
+    ssize_t r = 0;
+
+    while(msg_ring_peek(&port->tx, seg) && (r = write(port->fd, seg[0].s, seg[0].len)) > 0) {
+        msg_ring_consume(&port->tx, r);
+    }
+    if(r < 0 && errno != EAGAIN && errno != EINTR) {
+        __gw_port_close(gw, port);
+    } else if(!msg_ring_avail(&port->tx)) {
+        __gw_port_events(gw, port, EPOLLIN);
+        if(msg_ring_avail(&port->tx)) __gw_port_events(gw, port, EPOLLIN | EPOLLOUT); // queued meanwhile
+    }
+}
+
+/**
+ * @brief Add file descriptor to the port array and epoll
+ *
+ * @param gw gateway
+ * @param fd file descriptor
+ * @param name port name
+ * @return gw_port_t* port or NULL if the array is full or epoll failed
+ */
+static gw_port_t *__gw_port_add(gw_t *gw, int fd, const char *name)
+{
+    gw_port_t *port;
+    struct epoll_event ev;
+    msg_sink_t sink;
+
+    if(gw->port_cnt >= gw->port_size) {
+        errno = ENOSPC;
+        return NULL;
+    }
+    port = &gw->port[gw->port_cnt];
+    port->fd = fd;
+    port->idx = gw->port_cnt;
+    snprintf(port->name, GW_NAME_SIZE, "%s", name);
+    msg_stream_init(&port->st, port->buff, GW_PORT_BUFF_SIZE);
+    sink.write = __gw_port_write;
+    sink.arg = port;
+    msg_ctx_init_sink(&port->out, sink);
+    port->tx = msg_ring_create(port->tx_buff, GW_PORT_TX_SIZE);
+    port->closed = 0;
+    port->rx_bytes = port->rx_msgs = port->dropped = port->tx_dropped = 0;
+    port->gw = gw;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ev.events = EPOLLIN;
+    ev.data.u32 = port->idx;
+    if(epoll_ctl(gw->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) return NULL;
+    gw->port_cnt++;
+    return port;
+}
+
+/**
+ * @brief Convert baud rate to termios speed
+ *
+ * @param baud baud rate
+ * @return speed_t speed or B0 if it's not supported
+ */
+static speed_t __gw_speed(int baud)
+{
+    switch(baud) {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default:      return B0;
+    }
+}
+
+/**
+ * @brief Find registered handler by message id
+ *
+ * @param gw gateway
+ * @param id message id
+ * @return uint16_t handler index or GW_HND_DEFAULT
+ */
+static uint16_t __gw_find_handler(gw_t *gw, msg_str_t id)
+{
+    msg_size_t i = msg_router_find(&gw->router, id);
+    return i != MSG_ROUTE_NONE ? (uint16_t)i : GW_HND_DEFAULT;
+}
+
+/**
+ * @brief Write 16 bit little endian value of record header
+ *
+ * @param p destination
+ * @param v value
+ */
+static void __gw_put16(char *p, uint16_t v)
+{
+    p[0] = (char)(v & 0xFF);
+    p[1] = (char)(v >> 8);
+}
+
+/**
+ * @brief Read 16 bit little endian value of record header
+ *
+ * @param p source
+ * @return uint16_t value
+ */
+static uint16_t __gw_get16(const char *p)
+{
+    return (uint16_t)((uint8_t)p[0] | (uint8_t)p[1] << 8);
+}
+
+/**
+ * @brief Pass the completed message of the port to its worker. The message text is copied
+ * to the ring of the worker after the record header, the worker of a port is fixed
+ *
+ * @param gw gateway
+ * @param port port with completed message
+ */
+static void __gw_dispatch(gw_t *gw, gw_port_t *port)
+{
+    gw_worker_t *w = &gw->worker[port->idx % gw->worker_cnt];
+    msg_t msg = port->st.msg;
+    char *start = msg.id.s - 1; // message flag
+    msg_size_t len = msg.content.s + msg.content.len + 1 - start;
+    msg_sink_t sink = msg_ring_sink(&w->ring);
+    char hdr[GW_HDR_SIZE];
+
+    __gw_put16(hdr, port->idx);
+    __gw_put16(hdr + 2, __gw_find_handler(gw, msg.id));
+    __gw_put16(hdr + 4, len);
+    __gw_put16(hdr + 6, msg.id.len);
+    __gw_put16(hdr + 8, msg.content.s - start);
+    sink.write(sink.arg, hdr, GW_HDR_SIZE);
+    sink.write(sink.arg, start, len);
+    if(msg_ring_commit(&w->ring)) {
+        port->rx_msgs++;
+    } else {
+        port->dropped++;
+    }
+}
+
+/**
+ * @brief Read the available bytes of the port and feed its parser
+ *
+ * @param gw gateway
+ * @param port readable port
+ * @return int 0 or -1 on EOF or error (the device is hung up)
+ */
+static int __gw_read_port(gw_t *gw, gw_port_t *port)
+{
+    char chunk[GW_READ_CHUNK];
+    msg_size_t n;
+    char *p;
+    ssize_t r;
+
+    while((r = read(port->fd, chunk, sizeof(chunk))) > 0) {
+        port->rx_bytes += r;
+        for(p = chunk; r > 0; p += n, r -= n) {
+            n = msg_stream_feed(&port->st, p, r);
+            if(msg_stream_ready(&port->st)) __gw_dispatch(gw, port);
+        }
+    }
+    return (r < 0 && (errno == EAGAIN || errno == EINTR)) ? 0 : -1;
+}
+
+/**
+ * @brief Worker thread, records of the ring are handled in place
+ *
+ * @param arg worker
+ * @return void* NULL
+ */
+static void *__gw_worker_fnc(void *arg)
+{
+    gw_worker_t *w = (gw_worker_t *)arg;
+    gw_t *gw = w->gw;
+    gw_handler_t *h;
+    gw_port_t *port;
+    msg_seg_t view, rec;
+    msg_seg_msg_t msg;
+    msg_size_t avail, pos, len;
+    char hdr[GW_HDR_SIZE + 1];
+    uint16_t hnd;
+
+    while(1) {
+        avail = msg_ring_wait(&w->ring, -1);
+        msg_ring_peek(&w->ring, view.part);
+        for(pos = 0; avail - pos >= GW_HDR_SIZE; pos += GW_HDR_SIZE + len) {
+            msg_seg_copy(hdr, sizeof(hdr), msg_seg_sub(view, pos, GW_HDR_SIZE)); // header can straddle the boundary
+            if(__gw_get16(hdr) == GW_PORT_STOP) return NULL;
+            port = &gw->port[__gw_get16(hdr)];
+            hnd = __gw_get16(hdr + 2);
+            len = __gw_get16(hdr + 4);
+            rec = msg_seg_sub(view, pos + GW_HDR_SIZE, len);
+            msg.id = msg_seg_sub(rec, 1, __gw_get16(hdr + 6));
+            msg.content = msg_seg_sub(rec, __gw_get16(hdr + 8), len - __gw_get16(hdr + 8) - 1);
+            if(hnd == GW_HND_CLOSE) { // after the last message of the port
+                close(port->fd);
+                port->fd = -1;
+                continue;
+            }
+            h = hnd == GW_HND_DEFAULT ? &gw->def : &gw->hnd[hnd];
+            if(h->fn != NULL) h->fn(port, msg, &port->out, h->arg);
+            w->handled++;
+        }
+        msg_ring_consume(&w->ring, pos);
+    }
+}
+
+/*Init gateway*/
+int gw_init(gw_t *gw, gw_port_t *port, uint16_t port_size, gw_worker_t *worker, uint8_t worker_cnt)
+{
+    struct epoll_event ev;
+    uint8_t i;
+
+    memset(gw, 0, sizeof(*gw));
+    gw->port = port;
+    gw->port_size = port_size;
+    gw->worker = worker;
+    gw->worker_cnt = worker_cnt ? worker_cnt : 1;
+    for(i = 0; i < gw->worker_cnt; i++) {
+        worker[i].ring = msg_ring_create(worker[i].ring_buff, GW_RING_SIZE);
+        worker[i].handled = 0;
+        worker[i].gw = gw;
+    }
+    gw->router = msg_router_create(gw->route_node, GW_ROUTE_NODE_SIZE, gw->route, GW_HND_MAX);
+
+    gw->epfd = epoll_create1(EPOLL_CLOEXEC);
+    gw->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(gw->epfd < 0 || gw->stop_fd < 0) return -1;
+    ev.events = EPOLLIN;
+    ev.data.u32 = __GW_STOP_TAG;
+    return epoll_ctl(gw->epfd, EPOLL_CTL_ADD, gw->stop_fd, &ev);
+}
+
+/*Register message handler*/
+int gw_add_handler(gw_t *gw, char *id, gw_handler_fn fn, void *arg)
+{
+    gw_handler_t *h;
+    msg_size_t i;
+
+    if(id == NULL) {
+        h = &gw->def;
+    } else if((i = msg_router_add(&gw->router, id, NULL, NULL)) != MSG_ROUTE_NONE) { // route number is the handler index
+        h = &gw->hnd[i];
+        if(i >= gw->hnd_cnt) gw->hnd_cnt = i + 1;
+    } else {
+        return -1;
+    }
+    h->id = id;
+    h->fn = fn;
+    h->arg = arg;
+    return 0;
+}
+
+/*Open serial device*/
+gw_port_t *gw_open_port(gw_t *gw, const char *path, int baud)
+{
+    struct termios tio;
+    gw_port_t *port;
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+    if(fd < 0) return NULL;
+    if(tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        if(__gw_speed(baud) != B0) {
+            cfsetispeed(&tio, __gw_speed(baud));
+            cfsetospeed(&tio, __gw_speed(baud));
+        }
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    port = __gw_port_add(gw, fd, path);
+    if(port == NULL) close(fd);
+    return port;
+}
+
+/*Add opened file descriptor*/
+gw_port_t *gw_add_fd(gw_t *gw, int fd, const char *name)
+{
+    return __gw_port_add(gw, fd, name);
+}
+
+/*Create pty pair*/
+gw_port_t *gw_open_pty(gw_t *gw, int *slave_fd)
+{
+    struct termios tio;
+    char name[64];
+    gw_port_t *port;
+    int master;
+
+    cfmakeraw(&tio);
+    if(openpty(&master, slave_fd, name, &tio, NULL) < 0) return NULL;
+    port = __gw_port_add(gw, master, name);
+    if(port == NULL) {
+        close(master);
+        close(*slave_fd);
+    }
+    return port;
+}
+
+/*Run the epoll loop*/
+int gw_run(gw_t *gw)
+{
+    struct epoll_event ev[__GW_MAX_EVENTS];
+    msg_sink_t sink;
+    char hdr[GW_HDR_SIZE] = {0};
+    gw_port_t *port;
+    int i, n;
+    uint8_t k;
+
+    for(k = 0; k < gw->worker_cnt; k++) {
+        if(pthread_create(&gw->worker[k].thr, NULL, __gw_worker_fnc, &gw->worker[k])) return -1;
+    }
+
+    while(!gw->stop) {
+        n = epoll_wait(gw->epfd, ev, __GW_MAX_EVENTS, -1);
+        if(n < 0 && errno != EINTR) break;
+        for(i = 0; i < n; i++) {
+            if(ev[i].data.u32 == __GW_STOP_TAG) continue; // gw->stop is set
+            port = &gw->port[ev[i].data.u32];
+            if(port->closed) continue; // closed by an earlier event of the batch
+            if((ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && __gw_read_port(gw, port) < 0) {
+                __gw_port_close(gw, port); // EOF or hangup, the level triggered event would spin
+            } else if(ev[i].events & EPOLLOUT) {
+                __gw_flush_port(gw, port);
+            }
+        }
+    }
+
+    __gw_put16(hdr, GW_PORT_STOP); // workers exit at the stop record
+    for(k = 0; k < gw->worker_cnt; k++) {
+        sink = msg_ring_sink(&gw->worker[k].ring);
+        sink.write(sink.arg, hdr, GW_HDR_SIZE);
+        msg_ring_commit(&gw->worker[k].ring);
+        pthread_join(gw->worker[k].thr, NULL);
+    }
+    return 0;
+}
+
+/*Request stop*/
+void gw_stop(gw_t *gw)
+{
+    gw->stop = 1;
+    eventfd_write(gw->stop_fd, 1);
+}
+
+/*Close ports*/
+void gw_close(gw_t *gw)
+{
+    uint16_t i;
+
+    for(i = 0; i < gw->port_cnt; i++) {
+        if(gw->port[i].fd >= 0) close(gw->port[i].fd);
+    }
+    gw->port_cnt = 0;
+    close(gw->stop_fd);
+    close(gw->epfd);
+}
+/*EOF*/
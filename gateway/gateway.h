@@ -0,0 +1,195 @@
+/**
+ * @file gateway.h
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Multi-port serial gateway on linux: serial devices (or pty pairs) are multiplexed by epoll,
+ * every port has its own stream parser, complete messages are dispatched to handlers on a small
+ * thread pool through lock-free rings
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __MCU_MSG_GATEWAY__
+#define __MCU_MSG_GATEWAY__
+
+#include <pthread.h>
+#include "mcu_msg.h"
+
+#if !MCU_MSG_USE_RING || !MCU_MSG_USE_SEG || !MCU_MSG_USE_ROUTER
+#error "gateway needs MCU_MSG_USE_RING, MCU_MSG_USE_SEG and MCU_MSG_USE_ROUTER"
+#endif
+
+
+/*Size of the stream buffer of a port (max. message length)*/
+#define GW_PORT_BUFF_SIZE       1024
+
+/*Size of the output queue of a port (bytes which can't be written whitout blocking the worker)*/
+#define GW_PORT_TX_SIZE         1024
+
+/*Size of the ring of a worker*/
+#define GW_RING_SIZE            32768
+
+/*Size of one read call*/
+#define GW_READ_CHUNK           4096
+
+/*Max. count of registered handlers*/
+#define GW_HND_MAX              32
+
+/*Size of the id trie of handlers (one node per char of the registered ids)*/
+#define GW_ROUTE_NODE_SIZE      512
+
+/*Max. length of port name*/
+#define GW_NAME_SIZE            32
+
+/*Record header in the ring of a worker: port, handler, message length, id length, content offset*/
+#define GW_HDR_SIZE             10
+
+/*Port index of the stop record*/
+#define GW_PORT_STOP            0xFFFF
+
+/*Handler index of messages whitout registered handler*/
+#define GW_HND_DEFAULT          0xFFFF
+
+/*Handler index of the close record, the worker closes the port after its last message*/
+#define GW_HND_CLOSE            0xFFFE
+
+
+struct gw;
+struct gw_port;
+
+/*
+Message handler
+Handlers of a port are called on the same worker in the order of arrival, out prints to the port
+*/
+typedef void (*gw_handler_fn)(struct gw_port *port, msg_seg_msg_t msg, msg_ctx_t *out, void *arg);
+
+/*Registered handler*/
+typedef struct gw_handler {
+    char           *id;                        /* message id                            */
+    gw_handler_fn   fn;                        /* handler function                      */
+    void           *arg;                       /* user argument                         */
+} gw_handler_t;
+
+/*Serial port*/
+typedef struct gw_port {
+    int             fd;                        /* file descriptor (non-blocking), -1 if closed */
+    uint16_t        idx;                       /* index in the port array               */
+    char            name[GW_NAME_SIZE];        /* device name                           */
+    msg_stream_t    st;                        /* incremental parser                    */
+    char            buff[GW_PORT_BUFF_SIZE];   /* buffer of the stream parser           */
+    msg_ctx_t       out;                       /* output to the port (used by its worker) */
+    msg_ring_t      tx;                        /* queued output, sent when the device is writable */
+    char            tx_buff[GW_PORT_TX_SIZE];  /* storage of the output queue           */
+    volatile int    closed;                    /* EOF or error, port is removed from epoll */
+    uint64_t        rx_bytes;                  /* received bytes                        */
+    uint64_t        rx_msgs;                   /* received messages                     */
+    uint64_t        dropped;                   /* messages dropped (larger than the ring) */
+    uint64_t        tx_dropped;                /* output bytes dropped (the queue is full) */
+    struct gw      *gw;                        /* gateway                               */
+} gw_port_t;
+
+/*Worker thread of the pool*/
+typedef struct gw_worker {
+    pthread_t       thr;                       /* thread                                */
+    msg_ring_t      ring;                      /* records from the epoll thread         */
+    char            ring_buff[GW_RING_SIZE];   /* storage of the ring                   */
+    uint64_t        handled;                   /* count of handled messages             */
+    struct gw      *gw;                        /* gateway                               */
+} gw_worker_t;
+
+/*Gateway*/
+typedef struct gw {
+    int             epfd;                      /* epoll instance                        */
+    int             stop_fd;                   /* eventfd to stop the epoll loop        */
+    volatile int    stop;                      /* stop is requested                     */
+    gw_port_t      *port;                      /* user declared port array              */
+    uint16_t        port_size;                 /* size of the port array                */
+    uint16_t        port_cnt;                  /* count of opened ports                 */
+    gw_worker_t    *worker;                    /* user declared worker array            */
+    uint8_t         worker_cnt;                /* count of workers                      */
+    gw_handler_t    hnd[GW_HND_MAX];           /* registered handlers (index is the route) */
+    uint16_t        hnd_cnt;                   /* count of registered handlers          */
+    msg_router_t    router;                    /* id trie of handlers                   */
+    msg_route_node_t route_node[GW_ROUTE_NODE_SIZE]; /* nodes of the id trie          */
+    msg_route_t     route[GW_HND_MAX];         /* routes of the id trie                 */
+    gw_handler_t    def;                       /* handler of other messages             */
+} gw_t;
+
+
+/**
+ * @brief Init gateway
+ *
+ * @param gw gateway
+ * @param port port array
+ * @param port_size size of the port array
+ * @param worker worker array
+ * @param worker_cnt count of workers
+ * @return int 0 or -1 on error (errno is set)
+ */
+int         gw_init (gw_t *gw, gw_port_t *port, uint16_t port_size, gw_worker_t *worker, uint8_t worker_cnt);
+
+/**
+ * @brief Register message handler
+ *
+ * @param gw gateway
+ * @param id message id, NULL for the default handler (handler of a registered id is replaced)
+ * @param fn handler function
+ * @param arg user argument
+ * @return int 0 or -1 if the id is invalid or the table is full
+ */
+int         gw_add_handler (gw_t *gw, char *id, gw_handler_fn fn, void *arg);
+
+/**
+ * @brief Open serial device in raw mode and add it to the gateway
+ *
+ * @param gw gateway
+ * @param path device path
+ * @param baud baud rate (e.g. 115200)
+ * @return gw_port_t* port or NULL on error
+ */
+gw_port_t*  gw_open_port (gw_t *gw, const char *path, int baud);
+
+/**
+ * @brief Add opened file descriptor (e.g. pty master) to the gateway, it's set non-blocking
+ *
+ * @param gw gateway
+ * @param fd file descriptor
+ * @param name port name
+ * @return gw_port_t* port or NULL on error
+ */
+gw_port_t*  gw_add_fd (gw_t *gw, int fd, const char *name);
+
+/**
+ * @brief Create pty pair, the master is added to the gateway, the slave is the virtual device
+ *
+ * @param gw gateway
+ * @param slave_fd opened slave (raw mode), keep it open while the port is used
+ * @return gw_port_t* port (name is the slave path) or NULL on error
+ */
+gw_port_t*  gw_open_pty (gw_t *gw, int *slave_fd);
+
+/**
+ * @brief Start worker threads and run the epoll loop until gw_stop
+ *
+ * @param gw gateway
+ * @return int 0 or -1 on error
+ */
+int         gw_run (gw_t *gw);
+
+/**
+ * @brief Request stop, it can be called from other threads or signal handler
+ *
+ * @param gw gateway
+ */
+void        gw_stop (gw_t *gw);
+
+/**
+ * @brief Close ports and release the epoll instance
+ *
+ * @param gw gateway
+ */
+void        gw_close (gw_t *gw);
+
+#endif /*EOF*/
@@ -0,0 +1,131 @@
+/**
+ * @file gw_main.c
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief Reference gateway daemon: every received message is logged to stdout with the port name,
+ * PING messages are answered with PONG
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "gateway.h"
+
+#define LOG_LINE_SIZE   (GW_NAME_SIZE + GW_PORT_BUFF_SIZE + 8)
+
+static gw_t gw;
+
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    gw_stop(&gw);
+}
+
+/*Log message with the port name, one write call per line*/
+static void log_handler(gw_port_t *port, msg_seg_msg_t msg, msg_ctx_t *out, void *arg)
+{
+    char line[LOG_LINE_SIZE];
+    int n;
+
+    (void)out;
+    (void)arg;
+    n = snprintf(line, sizeof(line), "[%s] #", port->name);
+    n += msg_seg_copy(line + n, sizeof(line) - n, msg.id);
+    line[n++] = '{';
+    n += msg_seg_copy(line + n, sizeof(line) - n - 2, msg.content);
+    line[n++] = '}';
+    line[n++] = '\n';
+    if(write(STDOUT_FILENO, line, n) < 0) return;
+}
+
+/*Answer PING with PONG, the sequence number is sent back*/
+static void ping_handler(gw_port_t *port, msg_seg_msg_t msg, msg_ctx_t *out, void *arg)
+{
+    msg_wrap_t pong = msg_wrapper_create_msg("PONG");
+    msg_wrap_obj_t obj = msg_wrapper_create_obj("Ping");
+    msg_wrap_int_t seq = msg_wrapper_create_int("seq", 0);
+
+    log_handler(port, msg, out, arg);
+    msg_parser_get_int_seg(&seq.val, msg_parser_get_obj_seg(msg, "Ping"), "seq");
+    msg_wrapper_add_int_to_obj(&obj, &seq);
+    msg_wrapper_add_obj_to_msg(&pong, &obj);
+    msg_ctx_print_wrapper_msg(out, pong);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-w workers] [-b baud] [-p pty_count] [device ...]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    gw_port_t *port, *ports;
+    gw_worker_t *workers;
+    int workers_cnt = 2, baud = 115200, pty_cnt = 0;
+    int *slaves;
+    int opt, i;
+    uint64_t msgs = 0, bytes = 0, dropped = 0, tx_dropped = 0;
+
+    while((opt = getopt(argc, argv, "w:b:p:h")) != -1) {
+        switch(opt) {
+            case 'w': workers_cnt = atoi(optarg); break;
+            case 'b': baud = atoi(optarg); break;
+            case 'p': pty_cnt = atoi(optarg); break;
+            default:  usage(argv[0]); return 1;
+        }
+    }
+    if(workers_cnt < 1 || workers_cnt > 64 || pty_cnt < 0 || (pty_cnt == 0 && optind >= argc)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ports = calloc(pty_cnt + argc - optind, sizeof(gw_port_t));
+    workers = calloc(workers_cnt, sizeof(gw_worker_t));
+    slaves = calloc(pty_cnt + 1, sizeof(int));
+    if(ports == NULL || workers == NULL || slaves == NULL ||
+       gw_init(&gw, ports, pty_cnt + argc - optind, workers, workers_cnt) < 0) {
+        perror("gateway init");
+        return 1;
+    }
+    gw_add_handler(&gw, "PING", ping_handler, NULL);
+    gw_add_handler(&gw, NULL, log_handler, NULL);
+
+    for(i = optind; i < argc; i++) {
+        if(gw_open_port(&gw, argv[i], baud) == NULL) perror(argv[i]);
+    }
+    for(i = 0; i < pty_cnt; i++) {
+        port = gw_open_pty(&gw, &slaves[i]);
+        if(port == NULL) {
+            perror("openpty");
+            break;
+        }
+        printf("virtual port: %s\n", port->name);
+    }
+    fflush(stdout);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    gw_run(&gw);
+
+    for(i = 0; i < gw.port_cnt; i++) {
+        msgs += ports[i].rx_msgs;
+        bytes += ports[i].rx_bytes;
+        dropped += ports[i].dropped;
+        tx_dropped += ports[i].tx_dropped;
+    }
+    fprintf(stderr, "%d ports, %llu bytes, %llu messages, %llu dropped, %llu output bytes dropped\n", gw.port_cnt,
+            (unsigned long long)bytes, (unsigned long long)msgs, (unsigned long long)dropped, (unsigned long long)tx_dropped);
+    gw_close(&gw);
+    for(i = 0; i < pty_cnt; i++) close(slaves[i]);
+    free(slaves);
+    free(workers);
+    free(ports);
+    return 0;
+}
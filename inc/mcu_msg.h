@@ -20,11 +20,25 @@
 #include <inttypes.h>
 #include "mcu_msg_cfg.h"
 
+/*iovec output needs sys/uio.h*/
+#if MCU_MSG_USE_IOVEC && !(defined(__unix__) || defined(__APPLE__))
+#undef MCU_MSG_USE_IOVEC
+#define MCU_MSG_USE_IOVEC           0
+#endif
+
+#if MCU_MSG_USE_IOVEC
+#include <sys/uio.h>
+#endif
+
 
 #ifndef NULL
 #define NULL    ((void *)0)
 #endif
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,6 +56,30 @@ typedef struct msg_str {
     msg_size_t len;       /* string length */
 } msg_str_t;
 
+/*Number getters return with this value if the number doesn't fit to the result type*/
+#define MSG_NUM_OVERFLOW       0xFF
+
+/*
+Result of a number getter is usable: the key is found and the value fits to the result
+(MSG_NUM_OVERFLOW isn't 0, the result isn't written in this case)
+*/
+static inline uint8_t msg_num_ok(uint8_t r)
+{
+    return r != 0 && r != MSG_NUM_OVERFLOW;
+}
+
+/*Precision of float formatting for the shortest round trip representation*/
+#define MSG_FMT_SHORTEST       0xFF
+
+/*Max. count of fraction digits in float formatting*/
+#define MSG_FMT_MAX_PREC       19
+
+/*
+Buffer size which is enough for every formatted int and float (sign, "0.", 44 zeros and the digit of
+the smallest subnormal float). Shortest doubles can be longer (up to 327 chars)
+*/
+#define MSG_FMT_BUFF_SIZE      48
+
 /*Getting string ponter*/
 #define msg_str_p(str)        (str.s)
 
@@ -58,8 +96,12 @@ typedef struct msg_cmd {
 /*Get content for checking NULL pointers or content*/
 #define msg_get_content(mobj)           msg_str_p(mobj.content)
 
-/*message type for parser*/
+/*message type for parser (C++ sees other tag, "msg" is the namespace of mcu_msg.hpp)*/
+#ifdef __cplusplus
+typedef struct msg_msg {
+#else
 typedef struct msg {
+#endif
     msg_str_t id;        /* id string */
     msg_str_t content;   /* content string */
 } msg_t;
@@ -71,6 +113,184 @@ typedef struct msg_obj {
     msg_str_t content;   /* content string */
 } msg_obj_t;
 
+#if MCU_MSG_USE_SEG
+/*
+Two-segment view of a wrapped ring buffer
+The view continues with the second part, part[1].len is 0 if the span is contiguous
+*/
+typedef struct msg_seg {
+    msg_str_t part[2];   /* first and second part */
+} msg_seg_t;
+
+/*Message type of segmented parser*/
+typedef struct msg_seg_msg {
+    msg_seg_t id;        /* id view */
+    msg_seg_t content;   /* content view */
+} msg_seg_msg_t;
+
+/*Object type of segmented parser*/
+typedef struct msg_seg_obj {
+    msg_seg_t id;        /* id view */
+    msg_seg_t content;   /* content view */
+} msg_seg_obj_t;
+
+/*Length of the view*/
+#define msg_seg_len(v)                  ((v).part[0].len + (v).part[1].len)
+
+/*Getting first part pointer for checking NULL pointers*/
+#define msg_seg_p(v)                    ((v).part[0].s)
+#endif
+
+#if MCU_MSG_USE_RX
+/*
+Receive buffer
+Received bytes are appended after len, bytes before the cursor are handled
+*/
+typedef struct msg_rx {
+    char*       buff;       /* user declared buffer */
+    msg_size_t  size;       /* buffer size */
+    msg_size_t  len;        /* count of stored bytes */
+    msg_size_t  cursor;     /* start of unhandled bytes */
+    uint8_t     overflow;   /* buffer was full, unhandled bytes were dropped */
+} msg_rx_t;
+
+/*Count of unhandled bytes*/
+#define msg_rx_pending(rx)              ((rx)->len - (rx)->cursor)
+#endif
+
+#if MCU_MSG_USE_ROUTER
+/*Not registered id or full router*/
+#define MSG_ROUTE_NONE         ((msg_size_t)~0)
+
+/*
+Route handler
+cmd is empty (NULL) for message and default routes, it's the matched command for command routes
+*/
+typedef void (*msg_route_fn)(msg_t msg, msg_cmd_t cmd, void *arg);
+
+/*Registered handler*/
+typedef struct msg_route {
+    msg_route_fn fn;        /* handler function */
+    void*        arg;       /* user argument */
+} msg_route_t;
+
+/*
+Node of the id trie
+Children are linked by next, an id ends in the node if route is set
+*/
+typedef struct msg_route_node {
+    msg_size_t  child;      /* first child */
+    msg_size_t  next;       /* next sibling */
+    msg_size_t  route;      /* route of the id which ends here */
+    msg_size_t  cmd;        /* root of the command trie of the message id */
+    char        c;          /* char of the id */
+} msg_route_node_t;
+
+/*
+Message router
+Node 0 is the root of message ids, node 1 is the root of commands of every message
+*/
+typedef struct msg_router {
+    msg_route_node_t*  node;        /* user declared node array */
+    msg_size_t         size;        /* size of the node array */
+    msg_size_t         cnt;         /* count of used nodes */
+    msg_route_t*       route;       /* user declared route array */
+    msg_size_t         route_size;  /* size of the route array */
+    msg_size_t         route_cnt;   /* count of routes */
+    msg_route_t        def;         /* handler of messages whitout route (fn is NULL if not set) */
+} msg_router_t;
+#endif
+
+#if MCU_MSG_USE_FILE
+/*
+Capture file mapped read-only
+Messages point into the mapping, they are valid until the file is closed
+*/
+typedef struct msg_file {
+    char*       base;       /* mapping (NULL if the file is empty) */
+    msg_size_t  len;        /* file size */
+    msg_size_t  cursor;     /* scan position */
+} msg_file_t;
+#endif
+
+
+/*Scanner states*/
+#define MSG_SCAN_IDLE          0    /* waiting for message flag */
+#define MSG_SCAN_ID            1    /* reading message id */
+#define MSG_SCAN_START         2    /* waiting for start char after id */
+#define MSG_SCAN_CONTENT       3    /* reading message content */
+#define MSG_SCAN_STR           4    /* reading internal string of content */
+#define MSG_SCAN_READY         5    /* stop char arrived, message is completed */
+
+/*
+Resumable message scanner
+It inspects every char once and keeps the quote and bracket state between calls
+*/
+typedef struct msg_scan {
+    uint8_t    state;      /* scanner state (MSG_SCAN_...) */
+    char       qmark;      /* qmark of the current internal string */
+    uint8_t    depth;      /* object bracket depth */
+    msg_size_t id_len;     /* length of message id */
+} msg_scan_t;
+
+/*
+Stream parser type
+Incoming chunks are copied from the message flag into the user declared buffer
+*/
+typedef struct msg_stream {
+    msg_scan_t scan;       /* scanner state */
+    msg_str_t  buff;       /* user declared buffer */
+    msg_size_t pos;        /* count of stored chars */
+    msg_size_t content;    /* start position of content in the buffer */
+    msg_t      msg;        /* completed message (valid until the next feeding) */
+} msg_stream_t;
+
+/*Stream has a completed message*/
+#define msg_stream_ready(st)            ((st)->scan.state == MSG_SCAN_READY)
+
+/*Expected value types of batch getter*/
+#define MSG_KEY_INT            0    /* dst is int*       */
+#define MSG_KEY_FLOAT          1    /* dst is float*     */
+#define MSG_KEY_STR            2    /* dst is msg_str_t* */
+#define MSG_KEY_CMD            3    /* dst is msg_cmd_t*, key is a command string */
+
+/*Key descriptor for batch getter*/
+typedef struct msg_key_desc {
+    char*   key;       /* key or command string */
+    uint8_t type;      /* expected type (MSG_KEY_...) */
+    void*   dst;       /* destination pointer */
+} msg_key_desc_t;
+
+/*Token kinds of the structural index*/
+#define MSG_TOK_NONE           0
+#define MSG_TOK_OBJ            1
+#define MSG_TOK_CMD            2
+#define MSG_TOK_KEY            3
+
+/*Invalid record position*/
+#define MSG_INDEX_NONE         ((msg_size_t)~0)
+
+/*Record of the structural index*/
+typedef struct msg_index_rec {
+    uint8_t    kind;      /* token kind (MSG_TOK_...) */
+    msg_size_t n;         /* count of records inside the object (object only) */
+    msg_str_t  id;        /* id string */
+    msg_str_t  val;       /* object content or raw value of the key (with qmarks) */
+} msg_index_rec_t;
+
+/*
+Structural index of a message
+Records are stored in the order of the message content in a user declared array,
+object records are followed by the records of their content
+*/
+typedef struct msg_index {
+    msg_t            msg;        /* indexed message */
+    msg_index_rec_t* rec;        /* record array */
+    msg_size_t       cnt;        /* count of records */
+    msg_size_t       size;       /* size of record array */
+    uint8_t          overflow;   /* record array was too small, getters fall back to the parser */
+} msg_index_t;
+
 
 
 
@@ -130,15 +350,216 @@ typedef struct msg_wrap {
     msg_wrap_cmd_t* cmd_queue;  /* wrap cmd queue */
 } msg_wrap_t;
 
+
+/*Entry types of message builder*/
+#define MSG_BLD_INT            0
+#define MSG_BLD_FLOAT          1
+#define MSG_BLD_STR            2
+#define MSG_BLD_CMD            3
+#define MSG_BLD_OBJ            4
+#define MSG_BLD_REMOVED        5
+
+/*Invalid entry index*/
+#define MSG_BLD_NONE           ((msg_size_t)~0)
+
+/*Entry of message builder, entries of a list are linked with arena indexes*/
+typedef struct msg_bld_entry {
+    msg_str_t  id;                  /* key, object id or command string */
+    union {
+        int        i;               /* int value */
+        float      f;               /* float value */
+        msg_str_t  s;               /* string content */
+        struct {
+            msg_size_t head[3];     /* first int, float and string entry */
+            msg_size_t tail[3];     /* last int, float and string entry */
+        } obj;
+    } val;
+    msg_size_t next;                /* next entry of the list */
+    uint8_t    type;                /* entry type (MSG_BLD_...) */
+    uint8_t    prec;                /* precision of float printing */
+} msg_bld_entry_t;
+
+/*
+Message builder
+Commands, objects and key-value pairs are stored in one user declared entry array (arena)
+*/
+typedef struct msg_builder {
+    msg_str_t        id;        /* message id */
+    msg_bld_entry_t* arena;     /* entry array */
+    msg_size_t       size;      /* size of entry array */
+    msg_size_t       cnt;       /* count of used entries */
+    msg_size_t       head[2];   /* first command and object entry */
+    msg_size_t       tail[2];   /* last command and object entry */
+} msg_builder_t;
+
+
+/*Value slot of message template*/
+typedef struct msg_tpl_slot {
+    const void* src;        /* wrapper value (msg_wrap_int_t, msg_wrap_float_t or msg_wrap_str_t) */
+    msg_size_t  pos;        /* position of the slot in the template buffer */
+    msg_size_t  width;      /* width of the slot */
+    uint8_t     type;       /* value type (MSG_BLD_INT, MSG_BLD_FLOAT or MSG_BLD_STR) */
+    union {
+        int     i;          /* last rendered int */
+        float   f;          /* last rendered float */
+    } last;
+} msg_tpl_slot_t;
+
+/*
+Message template
+Constant parts of a wrapper message are rendered once, only the value slots are updated
+*/
+typedef struct msg_template {
+    msg_wrap_t      msg;        /* source message wrapper */
+    msg_str_t       buff;       /* rendered message, s is NULL if the compilation failed */
+    msg_tpl_slot_t* slot;       /* slot array */
+    msg_size_t      slot_cnt;   /* count of slots */
+} msg_template_t;
+
+ #if MCU_MSG_USE_DELTA
+/*Last transmitted value of a wrapper key*/
+typedef struct msg_delta_slot {
+    const void* src;        /* source wrapper (msg_wrap_int_t, msg_wrap_float_t or msg_wrap_str_t) */
+    uint8_t     type;       /* value type (MSG_BLD_INT, MSG_BLD_FLOAT or MSG_BLD_STR) */
+    union {
+        int      i;         /* last sent int */
+        float    f;         /* last sent float */
+        struct {
+            uint32_t   h;   /* hash of last sent string (pre-check of the compare) */
+            msg_str_t  s;   /* copy of last sent string in the pool, NULL if it didn't fit */
+            msg_size_t cap; /* reserved size of the copy */
+        } str;
+    } last;
+} msg_delta_slot_t;
+
+/*
+Delta stream of a message wrapper
+Only the changed keys are sent, every period-th message is a full keyframe
+*/
+typedef struct msg_delta {
+    msg_wrap_t        msg;        /* source message wrapper */
+    msg_delta_slot_t* slot;       /* user declared slot array */
+    msg_size_t        slot_size;  /* size of the slot array */
+    msg_size_t        slot_cnt;   /* count of bound slots, 0 if the wrapper has more keys than slots */
+    char*             pool;       /* storage of the last sent strings */
+    msg_size_t        pool_size;  /* size of the pool */
+    msg_size_t        pool_len;   /* used bytes of the pool */
+    uint16_t          period;     /* keyframe period (0: only the first message) */
+    uint16_t          frame;      /* messages since the last keyframe */
+    uint8_t           key;        /* the next message is a keyframe */
+} msg_delta_t;
+ #endif
+
+#endif
+
+
+/*
+Output sink
+write gets whole spans of the output, arg is passed back unchanged
+*/
+typedef struct msg_sink {
+    int  (*write)(void *arg, const char *p, msg_size_t n);  /* span write interface */
+    void  *arg;                                             /* user argument        */
+} msg_sink_t;
+
+#if MCU_MSG_USE_DICT
+/*
+Session dictionary
+Registered ids are sent as tokens, the token number is the index of the id in the array
+*/
+typedef struct msg_dict {
+    msg_str_t*  ids;        /* user declared array of registered ids */
+    msg_size_t  size;       /* size of the id array */
+    msg_size_t  cnt;        /* count of registered ids */
+    char*       pool;       /* storage of learned ids (NULL if ids are only registered) */
+    msg_size_t  pool_size;  /* size of the pool */
+    msg_size_t  pool_len;   /* used bytes of the pool */
+} msg_dict_t;
+#endif
+
+#if MCU_MSG_USE_DELTA
+/*Key value of the state store*/
+typedef struct msg_state_entry {
+    msg_str_t   obj;        /* object id */
+    msg_str_t   key;        /* key id */
+    msg_str_t   val;        /* current raw value (strings with qmarks) */
+    msg_size_t  cap;        /* reserved size of the value */
+    msg_size_t  next;       /* next entry in the hash bucket */
+} msg_state_entry_t;
+
+/*
+State store of delta messages
+Keyframes replace the whole state, delta messages update the received keys
+*/
+typedef struct msg_state {
+    msg_state_entry_t* entry;                         /* user declared entry array */
+    msg_size_t         size;                          /* size of the entry array */
+    msg_size_t         cnt;                           /* count of entries */
+    char*              pool;                          /* storage of ids and values */
+    msg_size_t         pool_size;                     /* size of the pool */
+    msg_size_t         pool_len;                      /* used bytes of the pool */
+    msg_size_t*        head;                          /* first entries of the hash buckets (start of the pool) */
+    msg_size_t         hash_mask;                     /* count of hash buckets - 1 */
+    uint8_t            overflow;                      /* entries or pool was full, keys are lost */
+} msg_state_t;
+#endif
+
+#if MCU_MSG_USE_RING
+/*
+SPSC byte ring
+Indexes are free running, the producer owns pend and head, the consumer owns tail.
+Printed bytes are pending until they are committed, the consumer sees only whole messages
+*/
+typedef struct msg_ring {
+    char*       buff;                               /* user declared storage */
+    uint32_t    mask;                               /* size - 1, size is power of 2 */
+    int         efd;                                /* eventfd of the consumer or -1 */
+    uint32_t    head;                               /* committed write index */
+    uint32_t    pend;                               /* pending write index (producer) */
+    uint32_t    rd_wait;                            /* consumer is waiting for data */
+    uint8_t     drop;                               /* pending message didn't fit, it's dropped */
+    uint8_t     pad0[MCU_MSG_CACHE_LINE];           /* producer and consumer are on separate lines */
+    uint32_t    tail;                               /* read index (consumer) */
+    uint32_t    wr_wait;                            /* producer is waiting for space */
+    uint8_t     pad1[MCU_MSG_CACHE_LINE];
+} msg_ring_t;
 #endif
 
 
+/*
+Output context
+Contains every state of printing, contexts are independent so threads and serial ports
+can print concurrently with their own context
+*/
+typedef struct msg_ctx {
+    msg_str_t   buff;                          /* string buffer                         */
+    char*       p;                             /* next position in string buffer        */
+    uint8_t     redir;                         /* output mode (redirected to string buffer) */
+    uint8_t     overflow;                      /* string buffer was full, output is lost */
+    uint32_t    cnt;                           /* count of output chars in measure mode */
+    int       (*putc)(char c);                 /* putchar interface                     */
+    msg_sink_t  sink;                          /* span output, used instead of putchar  */
+    msg_size_t  stage_len;                     /* staged output length                  */
+    char        stage[MCU_MSG_STAGE_SIZE];     /* output staging buffer                 */
+ #if MCU_MSG_USE_DICT
+    const msg_dict_t *dict;                    /* ids are printed as tokens if it is set */
+ #endif
+ #if MCU_MSG_USE_IOVEC
+    struct iovec *iov;                         /* iovec entries in iovec mode           */
+    msg_size_t  iov_size;                      /* size of the iovec array               */
+    msg_size_t  iov_cnt;                       /* count of used iovec entries           */
+ #endif
+} msg_ctx_t;
+
+
 /*
 Handler type
 Handler containes the basic functions to print std out or internal string buffer
 */
 typedef struct msg_hnd{
+    msg_ctx_t *ctx;                                                 /* default context         */
     int  (*putc)              (char c);                             /* putchar interface       */
+    void (*flush)             (void);                               /* flush staged output     */
     void (*print_msg)         (msg_t msg);                          /* print message interface */
     void (*print_str)         (msg_str_t str);                      /* print str interface     */
     void (*print_int)         (int i);                              /* print int interface     */
@@ -149,6 +570,11 @@ typedef struct msg_hnd{
     void (*reset_str_buff)    (void);                               /* reset string buffer     */
  #if MCU_MSG_USE_WRAPPER
     void (*print_wrapper_msg) (msg_wrap_t);
+    void (*print_builder)     (const msg_builder_t *b);             /* print message builder   */
+    void (*print_template)    (msg_template_t *tpl);                /* print message template  */
+  #if MCU_MSG_USE_DELTA
+    void (*print_delta)       (msg_delta_t *d);                     /* print delta message     */
+  #endif
  #endif
 } msg_hnd_t;
 
@@ -198,6 +624,17 @@ void                msg_destroy_str (msg_str_t *str);
  */
 msg_t               msg_get (char *raw_str, char *id, msg_size_t len);
 
+/**
+ * @brief Get the next message from buffer
+ * Call it repeatedly to walk all of the messages in order
+ * @param buff string buffer (char array)
+ * @param len size of buffer
+ * @param cursor start position, it's set to the end of the message (after the stop char),
+ * to the start of an incomplete message or to the end of the scanned chars if not found
+ * @return msg_t message (empty if there is no more completed message)
+ */
+msg_t               msg_next (char *buff, msg_size_t len, msg_size_t *cursor);
+
 /**
  * @brief Get object from message
  * 
@@ -222,7 +659,7 @@ msg_cmd_t           msg_parser_get_cmd (msg_t msg, char *cmd_id);
  * @param res result integer pointer
  * @param obj object
  * @param key key
- * @return uint8_t 0 if not found, digit count if found 
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if found 
  */
 uint8_t             msg_parser_get_int (int *res, msg_obj_t obj, char *key);
 
@@ -232,10 +669,40 @@ uint8_t             msg_parser_get_int (int *res, msg_obj_t obj, char *key);
  * @param res_val result float pointer
  * @param obj object
  * @param key key
- * @return uint8_t 0 if not found, digit count if found 
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value is out of range, digit count if found 
  */
 uint8_t             msg_parser_get_float (float *res_val, msg_obj_t obj, char *key);
 
+/**
+ * @brief Get double from object
+ * 
+ * @param res_val result double pointer
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value is out of range, digit count if found 
+ */
+uint8_t             msg_parser_get_double (double *res_val, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get 64 bit integer from object
+ * 
+ * @param res_val result integer pointer
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if found 
+ */
+uint8_t             msg_parser_get_int64 (int64_t *res_val, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get unsigned 64 bit integer from object
+ * 
+ * @param res_val result integer pointer
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value doesn't fit (or negative), digit count if found 
+ */
+uint8_t             msg_parser_get_uint64 (uint64_t *res_val, msg_obj_t obj, char *key);
+
 /**
  * @brief Get string from object
  * 
@@ -246,196 +713,1698 @@ uint8_t             msg_parser_get_float (float *res_val, msg_obj_t obj, char *k
 msg_str_t           msg_parser_get_str (msg_obj_t obj, char *key);
 
 /**
- * @brief Create string handler for printing and copying
+ * @brief Get more values from object with one scan
+ * The first occurance is used for every key, like in the single getters
+ * @param obj object
+ * @param descs key descriptors
+ * @param n count of descriptors (max. 32)
+ * @return uint32_t bitmask of found values, bit i is set if descs[i] is found and converted
+ */
+uint32_t            msg_parser_get_many (msg_obj_t obj, const msg_key_desc_t *descs, uint8_t n);
+
+/**
+ * @brief Get the next object of message
+ * Call it repeatedly to walk all of the objects in order
+ * @param msg message
+ * @param cursor position in the content (start with 0), it's set after the object
+ * @return msg_obj_t object (empty if there is no more)
+ */
+msg_obj_t           msg_parser_next_obj (msg_t msg, msg_size_t *cursor);
+
+/**
+ * @brief Get the next command of message (commands inside of objects are skipped)
  * 
- * @param putc putchar function depends on architecture
- * @return msg_string_hnd_t result handler
+ * @param msg message
+ * @param cursor position in the content (start with 0), it's set after the command
+ * @return msg_cmd_t command (empty if there is no more)
  */
-msg_hnd_t    msg_hnd_create (int (*putc)(char));
+msg_cmd_t           msg_parser_next_cmd (msg_t msg, msg_size_t *cursor);
 
+/**
+ * @brief Get the next key of object
+ * 
+ * @param obj object
+ * @param cursor position in the content (start with 0), it's set after the value
+ * @param val raw value of the key (strings with qmarks), convert it by msg_val_to_...
+ * @return msg_str_t key id (empty if there is no more)
+ */
+msg_str_t           msg_parser_next_key (msg_obj_t obj, msg_size_t *cursor, msg_str_t *val);
 
-/////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                         //
-//                                     Wrapper functions                                   //
-//                                                                                         //
-/////////////////////////////////////////////////////////////////////////////////////////////
-#if MCU_MSG_USE_WRAPPER
+/**
+ * @brief Convert raw value (got by msg_parser_next_key) to integer
+ * 
+ * @param res_val result integer pointer
+ * @param val raw value
+ * @return uint8_t 0 if it's not a number, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if converted
+ */
+uint8_t             msg_val_to_int (int *res_val, msg_str_t val);
 
+/**
+ * @brief Convert raw value to int64
+ * 
+ * @param res_val result int64 pointer
+ * @param val raw value
+ * @return uint8_t 0 if it's not a number, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if converted
+ */
+uint8_t             msg_val_to_int64 (int64_t *res_val, msg_str_t val);
 
 /**
- * @brief Ddestroy message wrapper
+ * @brief Convert raw value to uint64
  * 
- * @param msg message wrapper pointer
+ * @param res_val result uint64 pointer
+ * @param val raw value
+ * @return uint8_t 0 if it's not a number, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if converted
  */
-void                msg_wrap_destroy (msg_wrap_t *msg);
+uint8_t             msg_val_to_uint64 (uint64_t *res_val, msg_str_t val);
 
 /**
- * @brief Destroy object wrapper
+ * @brief Convert raw value to float
  * 
- * @param obj object wrapper pointer
+ * @param res_val result float pointer
+ * @param val raw value
+ * @return uint8_t 0 if it's not a number, MSG_NUM_OVERFLOW if the value is out of range, digit count if converted
  */
-void                msg_wrap_destroy_obj (msg_wrap_obj_t *obj);
+uint8_t             msg_val_to_float (float *res_val, msg_str_t val);
 
 /**
- * @brief Destroy command wrapper
+ * @brief Convert raw value to double
  * 
- * @param cmd command wrapper pointer
+ * @param res_val result double pointer
+ * @param val raw value
+ * @return uint8_t 0 if it's not a number, MSG_NUM_OVERFLOW if the value is out of range, digit count if converted
  */
-void                msg_wrap_destroy_cmd (msg_wrap_cmd_t *cmd);
+uint8_t             msg_val_to_double (double *res_val, msg_str_t val);
 
 /**
- * @brief Destroy string wrapper
+ * @brief Convert raw value to string
  * 
- * @param str string wrapper pointer
+ * @param val raw value
+ * @return msg_str_t content of the string whitout qmarks, NULL if it's not a string
  */
-void                msg_wrap_destroy_str (msg_wrap_str_t *str);
+msg_str_t           msg_val_to_str (msg_str_t val);
 
 /**
- * @brief Destroy integer wrapper
+ * @brief Init stream parser
  * 
- * @param i integer wrapper pointer
+ * @param st stream pointer
+ * @param buff buffer for the incoming message
+ * @param size size of buffer (messages longer than buffer are dropped)
  */
-void                msg_wrap_destroy_int (msg_wrap_int_t *i);
+void                msg_stream_init (msg_stream_t *st, char *buff, msg_size_t size);
 
 /**
- * @brief Destroy float wrapper
+ * @brief Feed stream parser with received chars
+ * Feeding stops after a completed message, it's available in st->msg until the next feeding
+ * @param st stream pointer
+ * @param chunk received chars
+ * @param len length of chunk
+ * @return msg_size_t count of consumed chars
+ */
+msg_size_t          msg_stream_feed (msg_stream_t *st, char *chunk, msg_size_t len);
+
+/**
+ * @brief Build the structural index of the message with one scan of the content
  * 
- * @param f float wrapper pointer
+ * @param msg message
+ * @param rec record array
+ * @param size size of record array
+ * @return msg_index_t index (records are valid while the message buffer is unchanged)
  */
-void                msg_wrap_destroy_float (msg_wrap_float_t *f);
+msg_index_t         msg_index_build (msg_t msg, msg_index_rec_t *rec, msg_size_t size);
 
 /**
- * @brief Create message wrapper
+ * @brief Get object from indexed message
  * 
- * @param msg_id Expected message ID
- * @return msg_wrap_t message wrapper
+ * @param idx index pointer
+ * @param id object id
+ * @return msg_obj_t result object
  */
-msg_wrap_t          msg_wrapper_create_msg (char *msg_id);
+msg_obj_t           msg_index_get_obj (msg_index_t *idx, char *id);
 
 /**
- * @brief Create command wrapper
+ * @brief Get command from indexed message
  * 
- * @param cmd Expected command string
- * @return msg_wrap_cmd_t command wrapper
+ * @param idx index pointer
+ * @param cmd_id command string
+ * @return msg_cmd_t result command
  */
-msg_wrap_cmd_t      msg_wrapper_create_cmd (char *cmd);
+msg_cmd_t           msg_index_get_cmd (msg_index_t *idx, char *cmd_id);
 
 /**
- * @brief Create object wrapper
+ * @brief Get integer from object of indexed message
  * 
- * @param obj_id Expected object ID
- * @return msg_wrap_obj_t object wrapper
+ * @param res result integer pointer
+ * @param idx index pointer
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, digit count if found 
  */
-msg_wrap_obj_t      msg_wrapper_create_obj (char *obj_id);
+uint8_t             msg_index_get_int (int *res, msg_index_t *idx, msg_obj_t obj, char *key);
 
 /**
- * @brief Create string wrapper
+ * @brief Get float from object of indexed message
  * 
- * @param id Expected string ID
- * @param content Init content
- * @return msg_wrap_str_t string wrapper
+ * @param res_val result float pointer
+ * @param idx index pointer
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, digit count if found 
  */
-msg_wrap_str_t      msg_wrapper_create_str (char *id, char *content);
+uint8_t             msg_index_get_float (float *res_val, msg_index_t *idx, msg_obj_t obj, char *key);
 
 /**
- * @brief Create integer wrapper
+ * @brief Get string from object of indexed message
  * 
- * @param id Expected ID
- * @param val Init value
- * @return msg_wrap_int_t integer wrapper
+ * @param idx index pointer
+ * @param obj object
+ * @param key key
+ * @return msg_str_t string location if found, NULL if not found
  */
-msg_wrap_int_t      msg_wrapper_create_int (char *id, int val);
+msg_str_t           msg_index_get_str (msg_index_t *idx, msg_obj_t obj, char *key);
 
 /**
- * @brief Create float wrapper
+ * @brief Format integer to the destination
  * 
- * @param id Expected ID
- * @param val Init value
- * @param prec precision of printing
- * @return msg_wrap_float_t float wrapper
+ * @param dst destination (pointer and available length)
+ * @param i integer value
+ * @return msg_size_t written length or 0 if it doesn't fit
  */
-msg_wrap_float_t    msg_wrapper_create_float (char *id, float val, uint8_t prec);
+msg_size_t          msg_fmt_int (msg_str_t dst, int i);
 
 /**
- * @brief Add string wrapper to string queue of object wrapper
+ * @brief Format float in fixed point notation to the destination
  * 
- * @param obj object wrapper pointer
- * @param str string wrapper pointer
+ * @param dst destination (pointer and available length)
+ * @param f float value, values beyond 2^64 are formatted as integer (significant digits and zeros)
+ * @param prec count of fraction digits, or MSG_FMT_SHORTEST for the shortest round trip representation
+ * (with as many leading or trailing zeros as needed, it fits to MSG_FMT_BUFF_SIZE)
+ * @return msg_size_t written length or 0 if it doesn't fit or the value is infinite or NaN
  */
-void                msg_wrapper_add_str_to_obj (msg_wrap_obj_t *obj, msg_wrap_str_t *str);
+msg_size_t          msg_fmt_float (msg_str_t dst, float f, uint8_t prec);
 
 /**
- * @brief Add integer wrapper to integer queue of object wrapper
+ * @brief Format double in fixed point notation to the destination
  * 
- * @param obj object wrapper pointer
- * @param int_val integer wrapper pointer
+ * @param dst destination (pointer and available length)
+ * @param d double value, values beyond 2^64 are formatted as integer (significant digits and zeros)
+ * @param prec count of fraction digits, or MSG_FMT_SHORTEST for the shortest round trip representation
+ * (with as many leading or trailing zeros as needed, up to 327 chars)
+ * @return msg_size_t written length or 0 if it doesn't fit or the value is infinite or NaN
  */
-void                msg_wrapper_add_int_to_obj (msg_wrap_obj_t *obj, msg_wrap_int_t *int_val);
+msg_size_t          msg_fmt_double (msg_str_t dst, double d, uint8_t prec);
 
 /**
- * @brief Add float wrapper to float queue of object wrapper
+ * @brief Create string handler for printing and copying. The handler uses the default context
+ * of the library, use msg_ctx_* functions with own contexts for concurrent printing
  * 
- * @param obj object wrapper pointer
- * @param float_val float wrapper pointer
+ * @param putc putchar function depends on architecture
+ * @return msg_string_hnd_t result handler
  */
-void                msg_wrapper_add_float_to_obj (msg_wrap_obj_t *obj, msg_wrap_float_t *float_val);
+msg_hnd_t    msg_hnd_create (int (*putc)(char));
 
 /**
- * @brief Add object wrapper to object queue of message wrapper
+ * @brief Create string handler with span output sink. Output is staged and passed to sink.write
+ * in chunks, every print function of the handler flushes before return
  * 
- * @param msg message wrapper pointer
- * @param obj object wrapper pointer
+ * @param sink output sink
+ * @return msg_hnd_t result handler
  */
-void                msg_wrapper_add_obj_to_msg (msg_wrap_t *msg, msg_wrap_obj_t *obj);
+msg_hnd_t    msg_hnd_create_sink (msg_sink_t sink);
 
 /**
- * @brief Add command wrapper to command queue of message wrapper
+ * @brief Init output context with putchar output
  * 
- * @param msg message wrappar pointer
- * @param cmd command wrapper pointer
+ * @param ctx context
+ * @param putc putchar function, set to NULL if you don't need the print feature
  */
-void                msg_wrapper_add_cmd_to_msg (msg_wrap_t *msg, msg_wrap_cmd_t *cmd);
+void         msg_ctx_init (msg_ctx_t *ctx, int (*putc)(char));
 
 /**
- * @brief Remove string wrapper from string queue of object wrapper
+ * @brief Init output context with span output sink
  * 
- * @param obj object wrapper pointer
- * @param str string wrapper pointer
+ * @param ctx context
+ * @param sink output sink
  */
-void                msg_wrapper_rm_string_from_obj (msg_wrap_obj_t *obj, msg_wrap_str_t *str);
+void         msg_ctx_init_sink (msg_ctx_t *ctx, msg_sink_t sink);
 
 /**
- * @brief Remove integer wrapper from integer queue of object wrapper
+ * @brief Set string buffer of the context
  * 
- * @param obj object wrapper pointer
- * @param i interge wrapper pointer
+ * @param ctx context
+ * @param buff buffer pointer
+ * @param buff_size buffer size
  */
-void                msg_wrapper_rm_int_from_obj (msg_wrap_obj_t *obj, msg_wrap_int_t *i);
+void         msg_ctx_init_str_buff (msg_ctx_t *ctx, char *buff, msg_size_t buff_size);
 
 /**
- * @brief Remove float wrapper from float queue of object wrapper
+ * @brief Set the string buffer position to the start of the buffer
  * 
- * @param obj object wrapper pointer
- * @param f float wrapper pointer
+ * @param ctx context
  */
-void                msg_wrapper_rm_float_from_obj (msg_wrap_obj_t *obj, msg_wrap_float_t *f);
+void         msg_ctx_reset_str_buff (msg_ctx_t *ctx);
 
 /**
- * @brief Remove object wrapper from object queue of message wrapper
+ * @brief Redirect output of the context to its string buffer
  * 
- * @param msg message wrapper pointer
- * @param obj object wrapper pointer
+ * @param ctx context
  */
-void                msg_wrapper_rm_obj_from_msg (msg_wrap_t *msg, msg_wrap_obj_t *obj);
+void         msg_ctx_enable_buff (msg_ctx_t *ctx);
 
 /**
- * @brief Remove command wrapper from command queue of message wrapper
+ * @brief Set back the putchar or sink output of the context
  * 
- * @param msg message wrapper pointer
- * @param cmd command wrapper pointer
+ * @param ctx context
  */
-void                msg_wrapper_rm_cmd_from_msg (msg_wrap_t *msg, msg_wrap_cmd_t *cmd);
-#endif
+void         msg_ctx_disable_buff (msg_ctx_t *ctx);
 
+/**
+ * @brief Pass the staged output to the sink or putchar
+ * 
+ * @param ctx context
+ */
+void         msg_ctx_flush (msg_ctx_t *ctx);
+
+/**
+ * @brief Print message
+ * 
+ * @param ctx context
+ * @param msg message
+ */
+void         msg_ctx_print_msg (msg_ctx_t *ctx, msg_t msg);
+
+/**
+ * @brief Print string
+ * 
+ * @param ctx context
+ * @param str string
+ */
+void         msg_ctx_print_str (msg_ctx_t *ctx, msg_str_t str);
+
+/**
+ * @brief Print integer
+ * 
+ * @param ctx context
+ * @param i integer value
+ */
+void         msg_ctx_print_int (msg_ctx_t *ctx, int i);
+
+/**
+ * @brief Print float
+ * 
+ * @param ctx context
+ * @param f float value
+ * @param prec precision of printing (MSG_FMT_SHORTEST for shortest round trip)
+ */
+void         msg_ctx_print_float (msg_ctx_t *ctx, float f, uint8_t prec);
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                     Wrapper functions                                   //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_WRAPPER
+
+
+/**
+ * @brief Ddestroy message wrapper
+ * 
+ * @param msg message wrapper pointer
+ */
+void                msg_wrap_destroy (msg_wrap_t *msg);
+
+/**
+ * @brief Destroy object wrapper
+ * 
+ * @param obj object wrapper pointer
+ */
+void                msg_wrap_destroy_obj (msg_wrap_obj_t *obj);
+
+/**
+ * @brief Destroy command wrapper
+ * 
+ * @param cmd command wrapper pointer
+ */
+void                msg_wrap_destroy_cmd (msg_wrap_cmd_t *cmd);
+
+/**
+ * @brief Destroy string wrapper
+ * 
+ * @param str string wrapper pointer
+ */
+void                msg_wrap_destroy_str (msg_wrap_str_t *str);
+
+/**
+ * @brief Destroy integer wrapper
+ * 
+ * @param i integer wrapper pointer
+ */
+void                msg_wrap_destroy_int (msg_wrap_int_t *i);
+
+/**
+ * @brief Destroy float wrapper
+ * 
+ * @param f float wrapper pointer
+ */
+void                msg_wrap_destroy_float (msg_wrap_float_t *f);
+
+/**
+ * @brief Create message wrapper
+ * 
+ * @param msg_id Expected message ID
+ * @return msg_wrap_t message wrapper
+ */
+msg_wrap_t          msg_wrapper_create_msg (char *msg_id);
+
+/**
+ * @brief Create command wrapper
+ * 
+ * @param cmd Expected command string
+ * @return msg_wrap_cmd_t command wrapper
+ */
+msg_wrap_cmd_t      msg_wrapper_create_cmd (char *cmd);
+
+/**
+ * @brief Create object wrapper
+ * 
+ * @param obj_id Expected object ID
+ * @return msg_wrap_obj_t object wrapper
+ */
+msg_wrap_obj_t      msg_wrapper_create_obj (char *obj_id);
+
+/**
+ * @brief Create string wrapper
+ * 
+ * @param id Expected string ID
+ * @param content Init content
+ * @return msg_wrap_str_t string wrapper
+ */
+msg_wrap_str_t      msg_wrapper_create_str (char *id, char *content);
+
+/**
+ * @brief Create integer wrapper
+ * 
+ * @param id Expected ID
+ * @param val Init value
+ * @return msg_wrap_int_t integer wrapper
+ */
+msg_wrap_int_t      msg_wrapper_create_int (char *id, int val);
+
+/**
+ * @brief Create float wrapper
+ * 
+ * @param id Expected ID
+ * @param val Init value
+ * @param prec precision of printing
+ * @return msg_wrap_float_t float wrapper
+ */
+msg_wrap_float_t    msg_wrapper_create_float (char *id, float val, uint8_t prec);
+
+/**
+ * @brief Add string wrapper to string queue of object wrapper
+ * 
+ * @param obj object wrapper pointer
+ * @param str string wrapper pointer
+ */
+void                msg_wrapper_add_str_to_obj (msg_wrap_obj_t *obj, msg_wrap_str_t *str);
+
+/**
+ * @brief Add integer wrapper to integer queue of object wrapper
+ * 
+ * @param obj object wrapper pointer
+ * @param int_val integer wrapper pointer
+ */
+void                msg_wrapper_add_int_to_obj (msg_wrap_obj_t *obj, msg_wrap_int_t *int_val);
+
+/**
+ * @brief Add float wrapper to float queue of object wrapper
+ * 
+ * @param obj object wrapper pointer
+ * @param float_val float wrapper pointer
+ */
+void                msg_wrapper_add_float_to_obj (msg_wrap_obj_t *obj, msg_wrap_float_t *float_val);
+
+/**
+ * @brief Add object wrapper to object queue of message wrapper
+ * 
+ * @param msg message wrapper pointer
+ * @param obj object wrapper pointer
+ */
+void                msg_wrapper_add_obj_to_msg (msg_wrap_t *msg, msg_wrap_obj_t *obj);
+
+/**
+ * @brief Add command wrapper to command queue of message wrapper
+ * 
+ * @param msg message wrappar pointer
+ * @param cmd command wrapper pointer
+ */
+void                msg_wrapper_add_cmd_to_msg (msg_wrap_t *msg, msg_wrap_cmd_t *cmd);
+
+/**
+ * @brief Remove string wrapper from string queue of object wrapper
+ * 
+ * @param obj object wrapper pointer
+ * @param str string wrapper pointer
+ */
+void                msg_wrapper_rm_string_from_obj (msg_wrap_obj_t *obj, msg_wrap_str_t *str);
+
+/**
+ * @brief Remove integer wrapper from integer queue of object wrapper
+ * 
+ * @param obj object wrapper pointer
+ * @param i interge wrapper pointer
+ */
+void                msg_wrapper_rm_int_from_obj (msg_wrap_obj_t *obj, msg_wrap_int_t *i);
+
+/**
+ * @brief Remove float wrapper from float queue of object wrapper
+ * 
+ * @param obj object wrapper pointer
+ * @param f float wrapper pointer
+ */
+void                msg_wrapper_rm_float_from_obj (msg_wrap_obj_t *obj, msg_wrap_float_t *f);
+
+/**
+ * @brief Remove object wrapper from object queue of message wrapper
+ * 
+ * @param msg message wrapper pointer
+ * @param obj object wrapper pointer
+ */
+void                msg_wrapper_rm_obj_from_msg (msg_wrap_t *msg, msg_wrap_obj_t *obj);
+
+/**
+ * @brief Remove command wrapper from command queue of message wrapper
+ * 
+ * @param msg message wrapper pointer
+ * @param cmd command wrapper pointer
+ */
+void                msg_wrapper_rm_cmd_from_msg (msg_wrap_t *msg, msg_wrap_cmd_t *cmd);
+
+/**
+ * @brief Print message wrapper with the given context
+ * 
+ * @param ctx output context
+ * @param msg message wrapper
+ */
+void                msg_ctx_print_wrapper_msg (msg_ctx_t *ctx, msg_wrap_t msg);
+
+/**
+ * @brief Create message builder on a user declared entry array
+ * 
+ * @param msg_id message id string
+ * @param arena entry array
+ * @param size size of entry array
+ * @return msg_builder_t empty message builder
+ */
+msg_builder_t       msg_builder_create (char *msg_id, msg_bld_entry_t *arena, msg_size_t size);
+
+/**
+ * @brief Remove every entry of the builder, the message id and the arena are kept
+ * 
+ * @param b builder pointer
+ */
+void                msg_builder_reset (msg_builder_t *b);
+
+/**
+ * @brief Add command to the end of the command list
+ * 
+ * @param b builder pointer
+ * @param cmd command string
+ * @return msg_size_t entry index or MSG_BLD_NONE if the arena is full
+ */
+msg_size_t          msg_builder_add_cmd (msg_builder_t *b, char *cmd);
+
+/**
+ * @brief Add object to the end of the object list
+ * 
+ * @param b builder pointer
+ * @param obj_id object id string
+ * @return msg_size_t entry index of the object or MSG_BLD_NONE if the arena is full
+ */
+msg_size_t          msg_builder_add_obj (msg_builder_t *b, char *obj_id);
+
+/**
+ * @brief Add integer to object
+ * 
+ * @param b builder pointer
+ * @param obj entry index of the object
+ * @param key key string
+ * @param val value
+ * @return msg_size_t entry index or MSG_BLD_NONE if the arena is full or obj is not an object
+ */
+msg_size_t          msg_builder_add_int (msg_builder_t *b, msg_size_t obj, char *key, int val);
+
+/**
+ * @brief Add float to object
+ * 
+ * @param b builder pointer
+ * @param obj entry index of the object
+ * @param key key string
+ * @param val value
+ * @param prec precision of printing (MSG_FMT_SHORTEST for shortest round trip)
+ * @return msg_size_t entry index or MSG_BLD_NONE if the arena is full or obj is not an object
+ */
+msg_size_t          msg_builder_add_float (msg_builder_t *b, msg_size_t obj, char *key, float val, uint8_t prec);
+
+/**
+ * @brief Add string to object
+ * 
+ * @param b builder pointer
+ * @param obj entry index of the object
+ * @param key key string
+ * @param content string content
+ * @return msg_size_t entry index or MSG_BLD_NONE if the arena is full or obj is not an object
+ */
+msg_size_t          msg_builder_add_str (msg_builder_t *b, msg_size_t obj, char *key, char *content);
+
+/**
+ * @brief Set value of integer entry
+ * 
+ * @param b builder pointer
+ * @param i entry index
+ * @param val new value
+ */
+void                msg_builder_set_int (msg_builder_t *b, msg_size_t i, int val);
+
+/**
+ * @brief Set value of float entry
+ * 
+ * @param b builder pointer
+ * @param i entry index
+ * @param val new value
+ */
+void                msg_builder_set_float (msg_builder_t *b, msg_size_t i, float val);
+
+/**
+ * @brief Set content of string entry
+ * 
+ * @param b builder pointer
+ * @param i entry index
+ * @param content new content
+ */
+void                msg_builder_set_str (msg_builder_t *b, msg_size_t i, char *content);
+
+/**
+ * @brief Remove entry (command, object or key-value pair). The entry is marked as removed,
+ * its place in the arena is freed only by msg_builder_reset
+ * 
+ * @param b builder pointer
+ * @param i entry index
+ */
+void                msg_builder_rm (msg_builder_t *b, msg_size_t i);
+
+/**
+ * @brief Print message builder with the given context, the output is the same as the wrapper's
+ * 
+ * @param ctx output context
+ * @param b builder pointer
+ */
+void                msg_ctx_print_builder (msg_ctx_t *ctx, const msg_builder_t *b);
+
+/**
+ * @brief Compile message template from message wrapper. Every value gets a slot padded with spaces
+ * to at least MCU_MSG_TPL_SLOT_WIDTH chars, the wrapper must be kept and recompiled if its shape changes
+ * 
+ * @param msg message wrapper
+ * @param buff buffer of the rendered message
+ * @param size buffer size
+ * @param slot slot array, one slot per value
+ * @param slot_size size of slot array
+ * @return msg_template_t template, buff.s is NULL if buffer or slot array is too small
+ */
+msg_template_t      msg_template_compile (msg_wrap_t msg, char *buff, msg_size_t size, msg_tpl_slot_t *slot, msg_size_t slot_size);
+
+/**
+ * @brief Render the current values of the wrapper into the template. Only the changed number slots are formatted
+ * 
+ * @param tpl template pointer
+ * @return msg_str_t rendered message or empty string if a value doesn't fit in its slot
+ */
+msg_str_t           msg_template_render (msg_template_t *tpl);
+
+/**
+ * @brief Render template and print it with one write. Falls back to the wrapper printer
+ * if a value doesn't fit in its slot
+ * 
+ * @param ctx output context
+ * @param tpl template pointer
+ */
+void                msg_ctx_print_template (msg_ctx_t *ctx, msg_template_t *tpl);
+
+/**
+ * @brief Compute the printed length of message wrapper without printing it
+ * 
+ * @param msg message wrapper
+ * @return uint32_t exact length of the printed message
+ */
+uint32_t            msg_wrap_measure (msg_wrap_t msg);
+
+/**
+ * @brief Compute the printed length of message builder without printing it
+ * 
+ * @param b builder pointer
+ * @return uint32_t exact length of the printed message
+ */
+uint32_t            msg_builder_measure (const msg_builder_t *b);
+
+/**
+ * @brief Print message wrapper to buffer if it fits
+ * 
+ * @param msg message wrapper
+ * @param buff destination buffer
+ * @param size buffer size
+ * @param required required buffer size (can be NULL)
+ * @return msg_size_t written length or 0 if the message doesn't fit (nothing is written) or a float
+ * value is infinite or NaN
+ */
+msg_size_t          msg_wrap_print_to_buff (msg_wrap_t msg, char *buff, msg_size_t size, uint32_t *required);
+
+/**
+ * @brief Print message builder to buffer if it fits
+ * 
+ * @param b builder pointer
+ * @param buff destination buffer
+ * @param size buffer size
+ * @param required required buffer size (can be NULL)
+ * @return msg_size_t written length or 0 if the message doesn't fit (nothing is written) or a float
+ * value is infinite or NaN
+ */
+msg_size_t          msg_builder_print_to_buff (const msg_builder_t *b, char *buff, msg_size_t size, uint32_t *required);
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                     Binary encoding                                     //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_BIN
+
+/*
+Element tags of binary encoding
+Every element is a tag byte and an id (varint length and bytes), followed by the value:
+MSG, OBJ, STR, STR_SQ, RAW: varint length and bytes; INT: zigzag varint; FLOAT: 4 byte IEEE 754 (little endian);
+DEC: zigzag varint mantissa and 1 byte count of fraction digits; CMD: no value
+*/
+#define MSG_BIN_MSG            0x01    /* message, value is the content */
+#define MSG_BIN_CMD            0x02    /* command */
+#define MSG_BIN_OBJ            0x03    /* object, value is the content */
+#define MSG_BIN_INT            0x04    /* integer key */
+#define MSG_BIN_FLOAT          0x05    /* float key */
+#define MSG_BIN_DEC            0x06    /* decimal fraction key (exact text form) */
+#define MSG_BIN_STR            0x07    /* string key ("" in text) */
+#define MSG_BIN_STR_SQ         0x08    /* string key ('' in text) */
+#define MSG_BIN_RAW            0x09    /* key with other value, text is kept as is */
+
+/**
+ * @brief Get binary message from buffer by ID
+ * 
+ * @param buff buffer of binary messages
+ * @param id message id
+ * @param len buffer length
+ * @return msg_t message view, content is binary, destroyed if not found
+ */
+msg_t               msg_bin_get (char *buff, char *id, msg_size_t len);
+
+/**
+ * @brief Get the next binary message of the buffer
+ * 
+ * @param buff buffer of binary messages
+ * @param len buffer length
+ * @param cursor position in buffer, set to the end of the returned message
+ * @return msg_t message view, destroyed if there is no more message
+ */
+msg_t               msg_bin_next (char *buff, msg_size_t len, msg_size_t *cursor);
+
+/**
+ * @brief Get object from binary message
+ * 
+ * @param msg binary message
+ * @param id object id
+ * @return msg_obj_t object view, destroyed if not found
+ */
+msg_obj_t           msg_bin_get_obj (msg_t msg, char *id);
+
+/**
+ * @brief Get command from binary message
+ * 
+ * @param msg binary message
+ * @param cmd command
+ * @return msg_cmd_t command view, destroyed if not found
+ */
+msg_cmd_t           msg_bin_get_cmd (msg_t msg, char *cmd);
+
+/**
+ * @brief Get integer from binary object
+ * 
+ * @param res result pointer
+ * @param obj binary object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW or length of the value
+ * Decimal and float values are converted if they have integer value (e.g. 21.00), 0 is returned
+ * for values with fraction (the text parser rejects every value with decimal separator)
+ */
+uint8_t             msg_bin_get_int (int *res, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get 64 bit integer from binary object
+ * 
+ * @param res result pointer
+ * @param obj binary object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW or length of the value
+ * Decimal and float values are converted if they have integer value (e.g. 21.00), 0 is returned
+ * for values with fraction (the text parser rejects every value with decimal separator)
+ */
+uint8_t             msg_bin_get_int64 (int64_t *res, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get float from binary object (integer and decimal values are converted like the text parser)
+ * 
+ * @param res result pointer
+ * @param obj binary object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW or length of the value
+ */
+uint8_t             msg_bin_get_float (float *res, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get double from binary object (integer and decimal values are converted like the text parser)
+ * 
+ * @param res result pointer
+ * @param obj binary object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW or length of the value
+ */
+uint8_t             msg_bin_get_double (double *res, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get string from binary object
+ * 
+ * @param obj binary object
+ * @param key key
+ * @return msg_str_t string content, destroyed if not found or not a string
+ */
+msg_str_t           msg_bin_get_str (msg_obj_t obj, char *key);
+
+/**
+ * @brief Transcode text message to binary. Numbers keep their exact text form, other values
+ * which are not strings or canonical numbers are stored as raw text
+ * 
+ * @param msg text message
+ * @param buff destination buffer
+ * @param size buffer size
+ * @return msg_size_t length of binary message or 0 if it doesn't fit
+ */
+msg_size_t          msg_bin_from_text (msg_t msg, char *buff, msg_size_t size);
+
+/**
+ * @brief Transcode binary message to text
+ * 
+ * @param msg binary message
+ * @param buff destination buffer
+ * @param size buffer size
+ * @return msg_size_t length of text message or 0 if it doesn't fit or the binary message is broken
+ */
+msg_size_t          msg_bin_to_text (msg_t msg, char *buff, msg_size_t size);
+
+ #if MCU_MSG_USE_WRAPPER
+/**
+ * @brief Encode message wrapper to binary
+ * 
+ * @param msg message wrapper
+ * @param buff destination buffer
+ * @param size buffer size
+ * @return msg_size_t length of binary message or 0 if it doesn't fit
+ */
+msg_size_t          msg_bin_wrap (msg_wrap_t msg, char *buff, msg_size_t size);
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                   Session dictionary                                    //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_DICT
+
+#define MSG_DICT_TOKEN         '%'                 /* flag char of id tokens (%N) */
+#define MSG_DICT_NONE          ((msg_size_t)~0)    /* id is not registered */
+#define MSG_DICT_MSG_ID        "MSG_DICT"          /* id of the announce message */
+
+/**
+ * @brief Create session dictionary
+ * 
+ * @param ids user declared id array
+ * @param size size of the array
+ * @param pool storage of learned ids, NULL if the ids are registered on both sides
+ * @param pool_size size of the pool
+ * @return msg_dict_t empty dictionary
+ */
+msg_dict_t          msg_dict_create (msg_str_t *ids, msg_size_t size, char *pool, msg_size_t pool_size);
+
+/**
+ * @brief Register id (the string is not copied, it has to be static)
+ * 
+ * @param dict dictionary
+ * @param id message, object, key or command id
+ * @return msg_size_t token number or MSG_DICT_NONE if the dictionary is full
+ */
+msg_size_t          msg_dict_add (msg_dict_t *dict, char *id);
+
+/**
+ * @brief Resolve received id
+ * 
+ * @param dict dictionary
+ * @param id received id (token or literal)
+ * @return msg_str_t registered id if id is a known token, id otherwise
+ */
+msg_str_t           msg_dict_resolve (const msg_dict_t *dict, msg_str_t id);
+
+/**
+ * @brief Set dictionary of the context, registered ids are printed as tokens
+ * 
+ * @param ctx context
+ * @param dict dictionary or NULL to print literal ids
+ */
+void                msg_ctx_set_dict (msg_ctx_t *ctx, const msg_dict_t *dict);
+
+/**
+ * @brief Print announce message of the dictionary (#MSG_DICT{<id0><id1>...}), ids are in token order
+ * 
+ * @param ctx context
+ * @param dict dictionary
+ */
+void                msg_ctx_print_dict (msg_ctx_t *ctx, const msg_dict_t *dict);
+
+/**
+ * @brief Learn dictionary from announce message
+ * Dictionary with pool copies the announced ids, whitout pool the registered ids are checked
+ * @param dict dictionary
+ * @param msg announce message
+ * @return msg_size_t count of ids, 0 if the message is invalid, the pool is full or the ids are different
+ */
+msg_size_t          msg_dict_learn (msg_dict_t *dict, msg_t msg);
+
+/**
+ * @brief Get message by id, token of the id is searched first
+ * 
+ * @param dict dictionary
+ * @param raw_str string buffer
+ * @param id id string
+ * @param len size of buffer
+ * @return msg_t message (empty if not found), id is the registered id
+ */
+msg_t               msg_dict_get (const msg_dict_t *dict, char *raw_str, char *id, msg_size_t len);
+
+/**
+ * @brief Get object from message, token of the id is searched first
+ * 
+ * @param dict dictionary
+ * @param msg message
+ * @param id object id
+ * @return msg_obj_t result object, id is the registered id
+ */
+msg_obj_t           msg_dict_get_obj (const msg_dict_t *dict, msg_t msg, char *id);
+
+/**
+ * @brief Get command from message, token of the command is searched first
+ * 
+ * @param dict dictionary
+ * @param msg message
+ * @param cmd_id command string
+ * @return msg_cmd_t result command, it is the registered command
+ */
+msg_cmd_t           msg_dict_get_cmd (const msg_dict_t *dict, msg_t msg, char *cmd_id);
+
+/**
+ * @brief Get integer from object, token of the key is searched first
+ * 
+ * @param res result integer pointer
+ * @param dict dictionary
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if found
+ */
+uint8_t             msg_dict_get_int (int *res, const msg_dict_t *dict, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get 64 bit integer from object, token of the key is searched first
+ * 
+ * @param res result integer pointer
+ * @param dict dictionary
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if found
+ */
+uint8_t             msg_dict_get_int64 (int64_t *res, const msg_dict_t *dict, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get float from object, token of the key is searched first
+ * 
+ * @param res result float pointer
+ * @param dict dictionary
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value is out of range, digit count if found
+ */
+uint8_t             msg_dict_get_float (float *res, const msg_dict_t *dict, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get double from object, token of the key is searched first
+ * 
+ * @param res result double pointer
+ * @param dict dictionary
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value is out of range, digit count if found
+ */
+uint8_t             msg_dict_get_double (double *res, const msg_dict_t *dict, msg_obj_t obj, char *key);
+
+/**
+ * @brief Get string from object, token of the key is searched first
+ * 
+ * @param dict dictionary
+ * @param obj object
+ * @param key key
+ * @return msg_str_t string location if found, NULL if not found
+ */
+msg_str_t           msg_dict_get_str (const msg_dict_t *dict, msg_obj_t obj, char *key);
+
+ #if MCU_MSG_USE_WRAPPER
+/**
+ * @brief Measure bytes saved by the dictionary on a message wrapper
+ * 
+ * @param dict dictionary
+ * @param msg message wrapper
+ * @return uint32_t printed length whitout dictionary minus printed length with dictionary
+ */
+uint32_t            msg_dict_wrap_saved (const msg_dict_t *dict, msg_wrap_t msg);
+
+/**
+ * @brief Measure bytes saved by the dictionary on a message builder
+ * 
+ * @param dict dictionary
+ * @param b message builder
+ * @return uint32_t printed length whitout dictionary minus printed length with dictionary
+ */
+uint32_t            msg_dict_builder_saved (const msg_dict_t *dict, const msg_builder_t *b);
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                       Delta mode                                        //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_DELTA
+
+#define MSG_DELTA_CMD          "DELTA"         /* command of delta messages (keyframes are plain messages) */
+
+ #if MCU_MSG_USE_WRAPPER
+/**
+ * @brief Create delta stream of message wrapper, the first message is a keyframe
+ * If keys are added to or removed from the wrapper, the slots are bound again and a keyframe is sent
+ * @param msg message wrapper
+ * @param slot user declared slot array (one slot per key)
+ * @param slot_size size of the slot array
+ * @param pool storage of the last sent strings (strings which don't fit are sent in every message)
+ * @param pool_size size of the pool
+ * @param period keyframe period (every period-th message is a keyframe), 0 for the first message only
+ * @return msg_delta_t delta stream, slot_cnt is 0 if the wrapper has more keys than slots (every message is a keyframe)
+ */
+msg_delta_t         msg_delta_create (msg_wrap_t msg, msg_delta_slot_t *slot, msg_size_t slot_size, char *pool,
+                                      msg_size_t pool_size, uint16_t period);
+
+/**
+ * @brief Send a keyframe next time (e.g. when the receiver restarted)
+ * 
+ * @param d delta stream
+ */
+void                msg_delta_keyframe (msg_delta_t *d);
+
+/**
+ * @brief Print the next message of delta stream (keyframe or the changed keys with <DELTA> command)
+ * 
+ * @param ctx output context
+ * @param d delta stream
+ */
+void                msg_ctx_print_delta (msg_ctx_t *ctx, msg_delta_t *d);
+ #endif
+
+/**
+ * @brief Create state store
+ * 
+ * @param entry user declared entry array
+ * @param size size of the entry array
+ * @param pool storage of ids and values, the hash buckets (power of 2 >= size, one msg_size_t each)
+ * are taken from its start
+ * @param pool_size size of the pool
+ * @return msg_state_t empty state
+ */
+msg_state_t         msg_state_create (msg_state_entry_t *entry, msg_size_t size, char *pool, msg_size_t pool_size);
+
+/**
+ * @brief Merge received message, keyframe replaces the state, delta message updates the keys
+ * 
+ * @param st state store
+ * @param msg received message
+ * @return msg_size_t count of updated keys (overflow flag is set if keys are lost)
+ */
+msg_size_t          msg_state_merge (msg_state_t *st, msg_t msg);
+
+/**
+ * @brief Get current integer value
+ * 
+ * @param res result integer pointer
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if found
+ */
+uint8_t             msg_state_get_int (int *res, const msg_state_t *st, char *obj, char *key);
+
+/**
+ * @brief Get current 64 bit integer value
+ * 
+ * @param res result integer pointer
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value doesn't fit, digit count if found
+ */
+uint8_t             msg_state_get_int64 (int64_t *res, const msg_state_t *st, char *obj, char *key);
+
+/**
+ * @brief Get current float value
+ * 
+ * @param res result float pointer
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value is out of range, digit count if found
+ */
+uint8_t             msg_state_get_float (float *res, const msg_state_t *st, char *obj, char *key);
+
+/**
+ * @brief Get current double value
+ * 
+ * @param res result double pointer
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @return uint8_t 0 if not found, MSG_NUM_OVERFLOW if the value is out of range, digit count if found
+ */
+uint8_t             msg_state_get_double (double *res, const msg_state_t *st, char *obj, char *key);
+
+/**
+ * @brief Get current string value
+ * 
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @return msg_str_t string content whitout qmarks, NULL if not found
+ */
+msg_str_t           msg_state_get_str (const msg_state_t *st, char *obj, char *key);
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                         Framing                                         //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_FRAME
+
+/*
+Frame header
+magic (2 bytes), payload length (4 bytes, little endian), header check (low 16 bits of CRC32C of
+the length, little endian), CRC32C of the payload (4 bytes, little endian), followed by the payload
+(#id{...}). Payload length is max. MCU_MSG_FRAME_MAX_LEN
+*/
+#define MSG_FRAME_MAGIC0       ((char)0xA5)    /* first magic byte */
+#define MSG_FRAME_MAGIC1       ((char)0x5A)    /* second magic byte */
+#define MSG_FRAME_HDR_SIZE     12              /* size of frame header */
+
+/**
+ * @brief Calculate CRC32C (Castagnoli), SSE4.2 crc32 instruction is used if the target supports it
+ * 
+ * @param crc CRC of the previous data or 0
+ * @param p data
+ * @param n data length
+ * @return uint32_t CRC
+ */
+uint32_t            msg_crc32c (uint32_t crc, const char *p, msg_size_t n);
+
+/**
+ * @brief Write frame header before payload
+ * 
+ * @param buff buffer, payload is at buff + MSG_FRAME_HDR_SIZE
+ * @param size buffer size
+ * @param len payload length
+ * @return msg_size_t frame length or 0 if it doesn't fit or the payload is longer than MCU_MSG_FRAME_MAX_LEN
+ */
+msg_size_t          msg_frame_seal (char *buff, msg_size_t size, msg_size_t len);
+
+/**
+ * @brief Print frame (header and payload), payloads longer than MCU_MSG_FRAME_MAX_LEN aren't
+ * printed and the overflow flag of the context is set
+ * 
+ * @param ctx output context
+ * @param payload payload (printed message)
+ * @param len payload length
+ */
+void                msg_ctx_print_frame (msg_ctx_t *ctx, const char *payload, msg_size_t len);
+
+/**
+ * @brief Get payload of the next valid frame, corrupted frames and other bytes are skipped
+ * 
+ * @param buff receive buffer
+ * @param len length of the received data
+ * @param size buffer size, headers of frames which can't fit in the buffer are treated as corrupted
+ * @param cursor start position, it's set to the end of the frame, to the start of an incomplete
+ * frame or to the end of the buffer if there is no more frame
+ * @return msg_str_t payload, destroyed if there is no more valid frame
+ */
+msg_str_t           msg_frame_next (char *buff, msg_size_t len, msg_size_t size, msg_size_t *cursor);
+
+/**
+ * @brief Get message from the next valid frame with id, other frames are skipped whitout CRC check
+ * 
+ * @param buff receive buffer
+ * @param len length of the received data
+ * @param size buffer size, like by msg_frame_next
+ * @param id message id
+ * @param cursor start position, it is set like by msg_frame_next
+ * @return msg_t message, destroyed if not found
+ */
+msg_t               msg_frame_get (char *buff, msg_size_t len, msg_size_t size, char *id, msg_size_t *cursor);
+
+ #if MCU_MSG_USE_WRAPPER
+/**
+ * @brief Print message wrapper as frame to buffer
+ * 
+ * @param msg message wrapper
+ * @param buff buffer
+ * @param size buffer size
+ * @param required required size of the frame if it's not NULL
+ * @return msg_size_t frame length or 0 if it doesn't fit
+ */
+msg_size_t          msg_wrap_print_frame (msg_wrap_t msg, char *buff, msg_size_t size, uint32_t *required);
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                      iovec output                                       //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_IOVEC
+
+/**
+ * @brief Init context in iovec mode, printed ids and strings are referenced by the entries,
+ * flags and formatted numbers are copied to the scratch
+ * 
+ * @param ctx context
+ * @param iov iovec array
+ * @param n size of the iovec array
+ * @param scratch scratch buffer
+ * @param scratch_size size of the scratch buffer
+ */
+void                msg_ctx_init_iovec (msg_ctx_t *ctx, struct iovec *iov, msg_size_t n, char *scratch, msg_size_t scratch_size);
+
+/**
+ * @brief Reset iovec entries and scratch of the context
+ * 
+ * @param ctx context in iovec mode
+ */
+void                msg_ctx_reset_iovec (msg_ctx_t *ctx);
+
+ #if MCU_MSG_USE_WRAPPER
+/**
+ * @brief Serialize message wrapper to iovec entries for one writev call
+ * 
+ * @param msg message wrapper
+ * @param iov iovec array
+ * @param n size of the iovec array
+ * @param scratch scratch buffer of flags and formatted numbers
+ * @param scratch_size size of the scratch buffer
+ * @return msg_size_t count of used entries, 0 if the entries or the scratch are not enough
+ */
+msg_size_t          msg_wrap_to_iovec (msg_wrap_t msg, struct iovec *iov, msg_size_t n, char *scratch, msg_size_t scratch_size);
+
+/**
+ * @brief Serialize message builder to iovec entries for one writev call
+ * 
+ * @param b message builder
+ * @param iov iovec array
+ * @param n size of the iovec array
+ * @param scratch scratch buffer of flags and formatted numbers
+ * @param scratch_size size of the scratch buffer
+ * @return msg_size_t count of used entries, 0 if the entries or the scratch are not enough
+ */
+msg_size_t          msg_builder_to_iovec (const msg_builder_t *b, struct iovec *iov, msg_size_t n, char *scratch, msg_size_t scratch_size);
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                       SPSC ring                                         //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_RING
+
+/**
+ * @brief Create ring on user declared buffer
+ * 
+ * @param buff buffer
+ * @param size buffer size, it's rounded down to power of 2 (max. 2^31, the indexes are 32 bit)
+ * @return msg_ring_t ring (buff is NULL if the buffer is too small)
+ */
+msg_ring_t          msg_ring_create (char *buff, msg_size_t size);
+
+/**
+ * @brief Sink of the producer, written spans are pending until msg_ring_commit. If the ring is full
+ * the producer waits for the consumer (on linux), a message larger than the ring is dropped
+ * 
+ * @param ring ring
+ * @return msg_sink_t sink for msg_ctx_init_sink or msg_hnd_create_sink
+ */
+msg_sink_t          msg_ring_sink (msg_ring_t *ring);
+
+/**
+ * @brief Init context to print into the ring
+ * 
+ * @param ctx context
+ * @param ring ring
+ */
+void                msg_ctx_init_ring (msg_ctx_t *ctx, msg_ring_t *ring);
+
+/**
+ * @brief Publish pending bytes to the consumer and wake it if it's waiting.
+ * The staged output of the context has to be flushed before (print functions do it)
+ * 
+ * @param ring ring
+ * @return msg_size_t count of published bytes, 0 if the message was dropped
+ */
+msg_size_t          msg_ring_commit (msg_ring_t *ring);
+
+/**
+ * @brief Count of committed bytes which are not read yet
+ * 
+ * @param ring ring
+ * @return msg_size_t available bytes
+ */
+msg_size_t          msg_ring_avail (msg_ring_t *ring);
+
+/**
+ * @brief Free space for the producer (size of the ring if the consumer read everything),
+ * a pending message which is not larger than this can be written whitout waiting
+ * 
+ * @param ring ring
+ * @return msg_size_t free bytes
+ */
+msg_size_t          msg_ring_space (msg_ring_t *ring);
+
+/**
+ * @brief Wait for committed bytes. On linux the consumer sleeps on futex, on other targets
+ * it returns immediately (polling)
+ * 
+ * @param ring ring
+ * @param timeout_ms timeout in ms, negative for infinite
+ * @return msg_size_t available bytes, 0 on timeout
+ */
+msg_size_t          msg_ring_wait (msg_ring_t *ring, int timeout_ms);
+
+/**
+ * @brief Get committed bytes whitout copy, the second segment is used if the data wraps around
+ * 
+ * @param ring ring
+ * @param seg two segments
+ * @return msg_size_t available bytes
+ */
+msg_size_t          msg_ring_peek (msg_ring_t *ring, msg_str_t seg[2]);
+
+/**
+ * @brief Release read bytes and wake the producer if it's waiting for space
+ * 
+ * @param ring ring
+ * @param n count of bytes
+ */
+void                msg_ring_consume (msg_ring_t *ring, msg_size_t n);
+
+/**
+ * @brief Copy committed bytes to linear buffer and release them. The buffer is NUL terminated,
+ * it can be parsed by msg_get. Use a buffer larger than the ring to get whole messages
+ * 
+ * @param ring ring
+ * @param buff buffer
+ * @param size buffer size
+ * @return msg_size_t count of copied bytes
+ */
+msg_size_t          msg_ring_read (msg_ring_t *ring, char *buff, msg_size_t size);
+
+/**
+ * @brief Set eventfd of the consumer, it's signaled instead of futex if the consumer is armed
+ * (consumer waits in epoll/poll/select), linux only
+ * 
+ * @param ring ring
+ * @param efd eventfd or -1
+ */
+void                msg_ring_set_eventfd (msg_ring_t *ring, int efd);
+
+/**
+ * @brief Arm consumer before waiting for the eventfd. The next commit signals the eventfd
+ * 
+ * @param ring ring
+ * @return msg_size_t available bytes, don't wait if it's not 0
+ */
+msg_size_t          msg_ring_arm (msg_ring_t *ring);
+#endif
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                    Segmented parser                                     //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_SEG
+
+/**
+ * @brief Make view of a contiguous string
+ * 
+ * @param str string
+ * @return msg_seg_t view whitout second part
+ */
+msg_seg_t           msg_seg_from_str (msg_str_t str);
+
+/**
+ * @brief Sub view of a view
+ * 
+ * @param v view
+ * @param off start position
+ * @param len length, it must be in the view
+ * @return msg_seg_t sub view
+ */
+msg_seg_t           msg_seg_sub (msg_seg_t v, msg_size_t off, msg_size_t len);
+
+/**
+ * @brief Copy view to linear buffer (e.g. string value which straddles the end of the ring)
+ * 
+ * @param buff buffer, it's NUL terminated
+ * @param size buffer size
+ * @param v view
+ * @return msg_size_t count of copied chars
+ */
+msg_size_t          msg_seg_copy (char *buff, msg_size_t size, msg_seg_t v);
+
+/**
+ * @brief Get message by ID from two-segment view, it's the same as msg_get
+ * 
+ * @param buff view of the buffer (e.g. msg_ring_peek(&ring, buff.part))
+ * @param id message id
+ * @return msg_seg_msg_t message, id and content views are destroyed if the message is not found
+ */
+msg_seg_msg_t       msg_get_seg (msg_seg_t buff, char *id);
+
+/**
+ * @brief Get object from segmented message by ID
+ * 
+ * @param msg message
+ * @param id object id
+ * @return msg_seg_obj_t object, views are destroyed if the object is not found
+ */
+msg_seg_obj_t       msg_parser_get_obj_seg (msg_seg_msg_t msg, char *id);
+
+/**
+ * @brief Get command from segmented message
+ * 
+ * @param msg message
+ * @param cmd_id command id
+ * @return msg_seg_t command view or destroyed view if it's not found
+ */
+msg_seg_t           msg_parser_get_cmd_seg (msg_seg_msg_t msg, char *cmd_id);
+
+/**
+ * @brief Get integer value from segmented object by key. A value which straddles the boundary
+ * is copied to a small local buffer before conversion
+ * 
+ * @param res_val result
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if the key is not found or invalid, MSG_NUM_OVERFLOW or digit count
+ */
+uint8_t             msg_parser_get_int_seg (int *res_val, msg_seg_obj_t obj, char *key);
+
+/**
+ * @brief Get 64 bit integer value from segmented object by key
+ * 
+ * @param res_val result
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if the key is not found or invalid, MSG_NUM_OVERFLOW or digit count
+ */
+uint8_t             msg_parser_get_int64_seg (int64_t *res_val, msg_seg_obj_t obj, char *key);
+
+/**
+ * @brief Get unsigned 64 bit integer value from segmented object by key
+ * 
+ * @param res_val result
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if the key is not found or invalid, MSG_NUM_OVERFLOW or digit count
+ */
+uint8_t             msg_parser_get_uint64_seg (uint64_t *res_val, msg_seg_obj_t obj, char *key);
+
+/**
+ * @brief Get float value from segmented object by key
+ * 
+ * @param res_val result
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if the key is not found or invalid, MSG_NUM_OVERFLOW or digit count
+ */
+uint8_t             msg_parser_get_float_seg (float *res_val, msg_seg_obj_t obj, char *key);
+
+/**
+ * @brief Get double value from segmented object by key
+ * 
+ * @param res_val result
+ * @param obj object
+ * @param key key
+ * @return uint8_t 0 if the key is not found or invalid, MSG_NUM_OVERFLOW or digit count
+ */
+uint8_t             msg_parser_get_double_seg (double *res_val, msg_seg_obj_t obj, char *key);
+
+/**
+ * @brief Get string value from segmented object by key
+ * 
+ * @param obj object
+ * @param key key
+ * @return msg_seg_t string content, it has two parts if it straddles the boundary (destroyed if not found)
+ */
+msg_seg_t           msg_parser_get_str_seg (msg_seg_obj_t obj, char *key);
+#endif
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                     Receive buffer                                      //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_RX
+
+/**
+ * @brief Create receive buffer
+ * 
+ * @param buff buffer (one byte is reserved for the zero terminator)
+ * @param size buffer size
+ * @return msg_rx_t receive buffer
+ */
+msg_rx_t            msg_rx_create (char *buff, msg_size_t size);
+
+/**
+ * @brief Append received bytes. The handled prefix is dropped by compaction if there is no
+ * space at the end, if it's still full, the unhandled bytes are dropped too (overflow is set).
+ * Compaction moves the stored bytes, messages got before are invalid after writing
+ * 
+ * @param rx receive buffer
+ * @param p received bytes
+ * @param n count of bytes
+ * @return msg_size_t count of stored bytes
+ */
+msg_size_t          msg_rx_write (msg_rx_t *rx, const char *p, msg_size_t n);
+
+/**
+ * @brief Get complete message by ID after the cursor
+ * 
+ * @param rx receive buffer
+ * @param id message id
+ * @return msg_t message or destroyed message if it's not arrived (or not completed)
+ */
+msg_t               msg_rx_get (msg_rx_t *rx, char *id);
+
+/**
+ * @brief Get the next complete message after the cursor
+ * 
+ * @param rx receive buffer
+ * @return msg_t message or destroyed message if there is no complete message
+ */
+msg_t               msg_rx_next (msg_rx_t *rx);
+
+/**
+ * @brief Mark message as handled, the cursor is moved after the message.
+ * Unhandled messages before it are dropped as well
+ * 
+ * @param rx receive buffer
+ * @param msg message got from the receive buffer
+ */
+void                msg_consume (msg_rx_t *rx, msg_t msg);
+
+/**
+ * @brief Move the unhandled bytes to the start of the buffer
+ * 
+ * @param rx receive buffer
+ */
+void                msg_rx_compact (msg_rx_t *rx);
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                      Message router                                     //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_ROUTER
+
+/**
+ * @brief Create router
+ * 
+ * @param node node array (one node per char of the registered ids, 2 nodes are reserved for the roots)
+ * @param size size of the node array
+ * @param route route array (one route per registered handler)
+ * @param route_size size of the route array
+ * @return msg_router_t empty router
+ */
+msg_router_t        msg_router_create (msg_route_node_t *node, msg_size_t size, msg_route_t *route, msg_size_t route_size);
+
+/**
+ * @brief Register handler of a message id (the handler of a registered id is replaced)
+ * 
+ * @param r router
+ * @param id message id
+ * @param fn handler function, NULL if the route is only looked up by msg_router_find
+ * @param arg user argument
+ * @return msg_size_t route number or MSG_ROUTE_NONE if the id is invalid or the router is full
+ */
+msg_size_t          msg_router_add (msg_router_t *r, char *id, msg_route_fn fn, void *arg);
+
+/**
+ * @brief Register handler of a command
+ * 
+ * @param r router
+ * @param id message id, NULL for the command of every message
+ * @param cmd command
+ * @param fn handler function (NULL to register whitout handler)
+ * @param arg user argument
+ * @return msg_size_t route number or MSG_ROUTE_NONE if an id is invalid or the router is full
+ */
+msg_size_t          msg_router_add_cmd (msg_router_t *r, char *id, char *cmd, msg_route_fn fn, void *arg);
+
+/**
+ * @brief Set handler of messages whitout message and command route
+ * 
+ * @param r router
+ * @param fn handler function, NULL to drop these messages
+ * @param arg user argument
+ */
+void                msg_router_set_default (msg_router_t *r, msg_route_fn fn, void *arg);
+
+/**
+ * @brief Find route of a message id
+ * 
+ * @param r router
+ * @param id message id
+ * @return msg_size_t route number or MSG_ROUTE_NONE if the id is not registered
+ */
+msg_size_t          msg_router_find (const msg_router_t *r, msg_str_t id);
+
+/**
+ * @brief Dispatch the complete messages of the buffer. Ids and commands are matched on the trie
+ * during the scan, the message handler is called first, then the command handlers in order
+ * 
+ * @param r router
+ * @param buff string buffer (char array)
+ * @param len size of buffer
+ * @param cursor start position, it's set like msg_next does: to the start of an incomplete message
+ * or to the end of the scanned chars
+ * @return msg_size_t count of dispatched messages
+ */
+msg_size_t          msg_router_dispatch (msg_router_t *r, char *buff, msg_size_t len, msg_size_t *cursor);
+
+#if MCU_MSG_USE_RX
+/**
+ * @brief Dispatch the complete messages after the cursor of the receive buffer and consume them
+ * 
+ * @param r router
+ * @param rx receive buffer
+ * @return msg_size_t count of dispatched messages
+ */
+msg_size_t          msg_router_dispatch_rx (msg_router_t *r, msg_rx_t *rx);
+#endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                      Capture file                                       //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_FILE
+
+/**
+ * @brief Map capture file read-only for sequential reading (madvise MADV_SEQUENTIAL)
+ * 
+ * @param f file
+ * @param path file path
+ * @return int 0 or -1 on error (errno is set, EFBIG if the file is larger than the max. of msg_size_t,
+ * ENOSYS if the target has no mmap)
+ */
+int                 msg_file_open (msg_file_t *f, const char *path);
+
+/**
+ * @brief Get the next complete message from the mapping
+ * Zero bytes (line noise) between the messages are skipped, a message broken by zero byte is dropped
+ * @param f file
+ * @return msg_t message in the mapping or destroyed message at the end of the file
+ */
+msg_t               msg_file_next (msg_file_t *f);
+
+/**
+ * @brief Get the next message by ID from the mapping
+ * 
+ * @param f file
+ * @param id message id
+ * @return msg_t message in the mapping or destroyed message at the end of the file
+ */
+msg_t               msg_file_get (msg_file_t *f, char *id);
+
+/**
+ * @brief Unmap the file, messages got from it are invalid
+ * 
+ * @param f file
+ */
+void                msg_file_close (msg_file_t *f);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
 
-#endif /*EOF*/
\ No newline at end of file
+#endif /*EOF*/
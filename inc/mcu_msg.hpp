@@ -0,0 +1,294 @@
+/**
+ * @file mcu_msg.hpp
+ * @author Istvan Milak (istvan.milak@gmail.com)
+ * @brief C++17 view API of mcu-msg, header only
+ * The classes are thin views over the C parser (std::string_view instead of msg_str_t), nothing is
+ * allocated and nothing is copied: every call is inlined to the same C function as the C API uses.
+ * The viewed buffer must be kept while the views are used.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __MCU_MSG_PARSER_HPP__
+#define __MCU_MSG_PARSER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include "mcu_msg.h"
+
+namespace msg {
+
+namespace detail {
+
+/*msg_str_t to string_view, NULL is the empty view*/
+inline std::string_view to_sv(msg_str_t s) noexcept
+{
+    return s.s != nullptr ? std::string_view(s.s, s.len) : std::string_view();
+}
+
+/*The C parser doesn't write the buffer and the keys, only the prototypes aren't const*/
+inline char *mut(const char *s) noexcept
+{
+    return const_cast<char *>(s);
+}
+
+template<class T> struct always_false : std::false_type {};
+
+/*Buffer length fits to msg_size_t (16 bits by default), a longer buffer would be scanned only partly*/
+inline bool fits(std::string_view buff) noexcept
+{
+    return buff.size() <= static_cast<std::size_t>(std::numeric_limits<msg_size_t>::max());
+}
+
+/*Get typed value of key, the parser is selected by the type at compile time*/
+template<class T>
+inline std::optional<T> get(msg_obj_t obj, char *key) noexcept
+{
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        msg_str_t s = msg_parser_get_str(obj, key);
+        if(s.s == nullptr) return std::nullopt;
+        return std::string_view(s.s, s.len);
+    } else {
+        T v;
+        uint8_t r;
+        if constexpr (std::is_same_v<T, int>) r = msg_parser_get_int(&v, obj, key);
+        else if constexpr (std::is_same_v<T, int64_t>) r = msg_parser_get_int64(&v, obj, key);
+        else if constexpr (std::is_same_v<T, uint64_t>) r = msg_parser_get_uint64(&v, obj, key);
+        else if constexpr (std::is_same_v<T, float>) r = msg_parser_get_float(&v, obj, key);
+        else if constexpr (std::is_same_v<T, double>) r = msg_parser_get_double(&v, obj, key);
+        else static_assert(always_false<T>::value, "type of get<T> must be int, int64_t, uint64_t, float, double or std::string_view");
+        if(!msg_num_ok(r)) return std::nullopt;
+        return v;
+    }
+}
+
+/*Convert raw value of key, same dispatch as get*/
+template<class T>
+inline std::optional<T> as(msg_str_t val) noexcept
+{
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        msg_str_t s = msg_val_to_str(val);
+        if(s.s == nullptr) return std::nullopt;
+        return std::string_view(s.s, s.len);
+    } else {
+        T v;
+        uint8_t r;
+        if constexpr (std::is_same_v<T, int>) r = msg_val_to_int(&v, val);
+        else if constexpr (std::is_same_v<T, int64_t>) r = msg_val_to_int64(&v, val);
+        else if constexpr (std::is_same_v<T, uint64_t>) r = msg_val_to_uint64(&v, val);
+        else if constexpr (std::is_same_v<T, float>) r = msg_val_to_float(&v, val);
+        else if constexpr (std::is_same_v<T, double>) r = msg_val_to_double(&v, val);
+        else static_assert(always_false<T>::value, "type of as<T> must be int, int64_t, uint64_t, float, double or std::string_view");
+        if(!msg_num_ok(r)) return std::nullopt;
+        return v;
+    }
+}
+
+/*End of the ranges, iterators are empty at the end*/
+struct sentinel {};
+
+/*
+Input iterator over a C "next" function
+Next(src, &cursor) returns the next element, Valid(element) is false at the end
+*/
+template<class Src, class Elem, class View, Elem (*Next)(const Src &, msg_size_t *), bool (*Valid)(const Elem &)>
+class iterator {
+public:
+    using value_type = View;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::input_iterator_tag;
+
+    iterator(const Src &src) noexcept : src_(src), cursor_(0) { next(); }
+
+    View operator*() const noexcept { return View(cur_); }
+    iterator &operator++() noexcept { next(); return *this; }
+    bool operator==(sentinel) const noexcept { return !Valid(cur_); }
+    bool operator!=(sentinel) const noexcept { return Valid(cur_); }
+
+private:
+    /*The cursor is passed to C as a local, so the element is returned into cur_ whitout a temporary copy*/
+    void next() noexcept
+    {
+        msg_size_t cursor = cursor_;
+        cur_ = Next(src_, &cursor);
+        cursor_ = cursor;
+    }
+
+    Src         src_;
+    msg_size_t  cursor_;
+    Elem        cur_;
+};
+
+template<class It, class Src>
+class range {
+public:
+    explicit range(const Src &src) noexcept : src_(src) {}
+    It begin() const noexcept { return It(src_); }
+    sentinel end() const noexcept { return {}; }
+
+private:
+    Src src_;
+};
+
+/*Key with raw value, the C iterator returns the value by pointer*/
+struct key_rec {
+    msg_str_t id;
+    msg_str_t val;
+};
+
+inline key_rec next_key(const msg_obj_t &obj, msg_size_t *cursor) noexcept
+{
+    key_rec k;
+    k.id = msg_parser_next_key(obj, cursor, &k.val);
+    return k;
+}
+
+inline msg_obj_t next_obj(const msg_t &m, msg_size_t *cursor) noexcept
+{
+    return msg_parser_next_obj(m, cursor);
+}
+
+inline msg_cmd_t next_cmd(const msg_t &m, msg_size_t *cursor) noexcept
+{
+    return msg_parser_next_cmd(m, cursor);
+}
+
+/*Raw buffer of messages*/
+struct buff_rec {
+    char       *s;
+    msg_size_t  len;
+};
+
+inline msg_t next_msg(const buff_rec &b, msg_size_t *cursor) noexcept
+{
+    return msg_next(b.s, b.len, cursor);
+}
+
+inline bool valid_obj(const msg_obj_t &o) noexcept { return o.content.s != nullptr; }
+inline bool valid_cmd(const msg_cmd_t &c) noexcept { return c.cmd.s != nullptr; }
+inline bool valid_msg(const msg_t &m) noexcept { return m.content.s != nullptr; }
+inline bool valid_key(const key_rec &k) noexcept { return k.id.s != nullptr; }
+
+} /*namespace detail*/
+
+
+/*Key of object with its raw value*/
+class key {
+public:
+    explicit key(detail::key_rec k) noexcept : k_(k) {}
+
+    /*Key id*/
+    std::string_view id() const noexcept { return detail::to_sv(k_.id); }
+
+    /*Raw value (strings with qmarks)*/
+    std::string_view raw() const noexcept { return detail::to_sv(k_.val); }
+
+    /*Typed value: int, int64_t, uint64_t, float, double or std::string_view*/
+    template<class T>
+    std::optional<T> as() const noexcept { return detail::as<T>(k_.val); }
+
+private:
+    detail::key_rec k_;
+};
+
+/*Object of message*/
+class object {
+public:
+    object() noexcept { msg_destroy_obj(&o_); }
+    explicit object(msg_obj_t o) noexcept : o_(o) {}
+
+    explicit operator bool() const noexcept { return o_.content.s != nullptr; }
+    std::string_view id() const noexcept { return detail::to_sv(o_.id); }
+    std::string_view content() const noexcept { return detail::to_sv(o_.content); }
+    const msg_obj_t &c_obj() const noexcept { return o_; }
+
+    /*Typed value of key: int, int64_t, uint64_t, float, double or std::string_view, empty if not found*/
+    template<class T>
+    std::optional<T> get(const char *key) const noexcept { return detail::get<T>(o_, detail::mut(key)); }
+
+    /*Keys in order*/
+    auto keys() const noexcept
+    {
+        using it = detail::iterator<msg_obj_t, detail::key_rec, key, detail::next_key, detail::valid_key>;
+        return detail::range<it, msg_obj_t>(o_);
+    }
+
+private:
+    msg_obj_t o_;
+};
+
+/*Command of message*/
+class command {
+public:
+    command() noexcept { msg_destroy_cmd(&c_); }
+    explicit command(msg_cmd_t c) noexcept : c_(c) {}
+
+    explicit operator bool() const noexcept { return c_.cmd.s != nullptr; }
+    std::string_view id() const noexcept { return detail::to_sv(c_.cmd); }
+    const msg_cmd_t &c_cmd() const noexcept { return c_; }
+
+private:
+    msg_cmd_t c_;
+};
+
+/*Message*/
+class message {
+public:
+    message() noexcept { msg_destroy(&m_); }
+    explicit message(msg_t m) noexcept : m_(m) {}
+
+    /*Find message by id in the buffer, it's empty if not found or the buffer is longer than the max. of msg_size_t*/
+    static message find(std::string_view buff, const char *id) noexcept
+    {
+        if(!detail::fits(buff)) return message();
+        return message(msg_get(detail::mut(buff.data()), detail::mut(id), static_cast<msg_size_t>(buff.size())));
+    }
+
+    explicit operator bool() const noexcept { return m_.content.s != nullptr; }
+    std::string_view id() const noexcept { return detail::to_sv(m_.id); }
+    std::string_view content() const noexcept { return detail::to_sv(m_.content); }
+    const msg_t &c_msg() const noexcept { return m_; }
+
+    /*Object by id, it's empty if not found*/
+    object obj(const char *id) const noexcept { return object(msg_parser_get_obj(m_, detail::mut(id))); }
+
+    /*Command by id, it's empty if not found*/
+    command cmd(const char *id) const noexcept { return command(msg_parser_get_cmd(m_, detail::mut(id))); }
+
+    /*Objects in order*/
+    auto objects() const noexcept
+    {
+        using it = detail::iterator<msg_t, msg_obj_t, object, detail::next_obj, detail::valid_obj>;
+        return detail::range<it, msg_t>(m_);
+    }
+
+    /*Commands in order (commands of objects are skipped)*/
+    auto commands() const noexcept
+    {
+        using it = detail::iterator<msg_t, msg_cmd_t, command, detail::next_cmd, detail::valid_cmd>;
+        return detail::range<it, msg_t>(m_);
+    }
+
+private:
+    msg_t m_;
+};
+
+/*Messages of the buffer in order (same as msg_next), the range is empty if the buffer is longer than the max. of msg_size_t*/
+inline auto messages(std::string_view buff) noexcept
+{
+    using it = detail::iterator<detail::buff_rec, msg_t, message, detail::next_msg, detail::valid_msg>;
+    if(!detail::fits(buff)) return detail::range<it, detail::buff_rec>(detail::buff_rec{nullptr, 0});
+    return detail::range<it, detail::buff_rec>(detail::buff_rec{detail::mut(buff.data()), static_cast<msg_size_t>(buff.size())});
+}
+
+} /*namespace msg*/
+
+#endif /*EOF*/
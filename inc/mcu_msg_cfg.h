@@ -14,10 +14,26 @@
 
 #include <inttypes.h>
 
+/*
+Width of the size type in bits (16, 32 or 64). Buffers and messages are limited to 64 KiB with 16 bits,
+host tools which scan large captures use 32 or 64 bits (e.g. make SIZE_BITS=64)
+*/
+#ifndef MCU_MSG_SIZE_BITS
+#define MCU_MSG_SIZE_BITS           16
+#endif
+
 /*
 define the size of message type
 */
+#if MCU_MSG_SIZE_BITS == 16
 typedef uint16_t msg_size_t;
+#elif MCU_MSG_SIZE_BITS == 32
+typedef uint32_t msg_size_t;
+#elif MCU_MSG_SIZE_BITS == 64
+typedef uint64_t msg_size_t;
+#else
+#error "MCU_MSG_SIZE_BITS must be 16, 32 or 64"
+#endif
 
 
 /*
@@ -26,4 +42,130 @@ This keyword can enable the wrapper features
 */
 #define MCU_MSG_USE_WRAPPER         1
 
+
+/*
+Binary encoding of messages (tagged elements, varint integers, raw floats) and
+transcoder between the text and binary formats
+*/
+#define MCU_MSG_USE_BIN             1
+
+
+/*
+Session dictionary: registered message, object, key and command ids are printed as short
+numeric tokens (%N) and resolved back by the dictionary aware getters
+*/
+#define MCU_MSG_USE_DICT            1
+
+
+/*
+Delta mode: wrapper messages are sent with the changed keys only (and periodic keyframes),
+the receiver merges them into a state store
+*/
+#define MCU_MSG_USE_DELTA           1
+
+
+/*
+Minimum reserved size of the values in the state store and of the last sent strings of delta
+streams, longer values are stored at the end of the pool
+*/
+#define MCU_MSG_STATE_VAL_SIZE      12
+
+
+/*
+Framing layer: messages are sent in frames with length and CRC32C header, receivers can skip
+frames and resync after corrupted bytes whitout parsing
+*/
+#define MCU_MSG_USE_FRAME           1
+
+
+/*
+Max. payload length of frames, headers with longer length are treated as corrupted (the receiver
+resyncs from the next byte instead of waiting for a frame which never completes)
+*/
+#define MCU_MSG_FRAME_MAX_LEN       1024
+
+
+/*
+Scatter-gather output: printed messages are collected in iovec entries for writev, ids and
+strings are referenced whitout copy. It's available only on unix targets (sys/uio.h)
+*/
+#define MCU_MSG_USE_IOVEC           1
+
+
+/*
+Shorter ids and strings than this are copied to the scratch in iovec mode (an iovec entry costs
+more than copying a few bytes), 1 to reference every span
+*/
+#define MCU_MSG_IOVEC_MIN_REF       8
+
+
+/*
+Lock-free single producer / single consumer byte ring between threads (or ISR and main loop).
+On linux the waiting side sleeps on futex and the consumer can be woken by eventfd
+*/
+#define MCU_MSG_USE_RING            1
+
+
+/*
+Producer and consumer indexes of the ring are separated by this many bytes to avoid false
+sharing, set it to 4 on targets whitout data cache
+*/
+#define MCU_MSG_CACHE_LINE          64
+
+
+/*
+Parser entry points on two-segment views (wrapped ring buffers), messages which straddle the
+end of the ring are parsed whitout copying them to a linear buffer
+*/
+#define MCU_MSG_USE_SEG             1
+
+
+/*
+Receive buffer with read cursor: handled messages are consumed, scans start from the cursor
+and the handled prefix is dropped by bulk compaction
+*/
+#define MCU_MSG_USE_RX              1
+
+
+/*
+Message router: handlers are registered per message id and per command, the ids are compiled
+into a trie and every message is dispatched by one scan
+*/
+#define MCU_MSG_USE_ROUTER          1
+
+
+/*
+Max. count of dispatched commands in one message, further commands of the message are not
+dispatched (local array of the dispatcher)
+*/
+#define MCU_MSG_ROUTER_CMD_MAX      8
+
+
+/*
+Capture file reader: the file is mapped read-only and the messages are iterated in the mapping
+whitout copying (POSIX hosts). Files larger than the max. of msg_size_t need MCU_MSG_SIZE_BITS 32 or 64
+*/
+#define MCU_MSG_USE_FILE            1
+
+
+/*
+Parser uses SSE2/AVX2 instructions to find the flags and quotation marks in 64 byte blocks
+On targets whitout these instruction sets the scalar implementation is used
+*/
+#define MCU_MSG_USE_SIMD            1
+
+
+/*
+Size of the output staging buffer. Printed spans are collected here and passed to the sink
+in one write call, larger spans bypass the staging buffer
+*/
+#define MCU_MSG_STAGE_SIZE          64
+
+
+/*
+Minimum width of the value slots of message templates. Values are padded with spaces,
+a template can be rendered while the new values fit in their slots
+*/
+#define MCU_MSG_TPL_SLOT_WIDTH      12
+
 #endif
\ No newline at end of file
@@ -24,20 +24,41 @@ char test_str1[] = "#test_msg{<CMD1>\t\t @obj1($key11=-1123334567  ; $key12 = 's
 \r@obj2  ($key21 =   -1.123456789; $key22   = 'val22'; $key23 = 1000; $key24 = 12.34)<CMD_last>}";
 
 
+/*Master and slave are connected by two lock-free rings*/
 typedef struct {
-    char *buff;
-    msg_size_t buff_size;
+    msg_ring_t *rx;     /* incoming messages */
+    msg_ring_t *tx;     /* outgoing messages */
 } thread_arg;
 
 
 
-pthread_mutex_t outp_lock;
 pthread_t thr_master, thr_slave;
-thread_arg common_buff;
+char master_rx_buff[256], slave_rx_buff[256];
+msg_ring_t master_rx, slave_rx;
+thread_arg master_arg, slave_arg;
 
 void *thread_mcu_master_fnc(void *arg);
 void *thread_mcu_slave_fnc(void *arg);
 
+#if MCU_MSG_USE_ROUTER
+/*route handler of the router demo, prints the route name*/
+void route_print(msg_t msg, msg_cmd_t cmd, void *arg)
+{
+    printf("%s: #%.*s", (char *)arg, (int)msg.id.len, msg.id.s);
+    if(msg_get_cmd_content(cmd) != NULL) printf(" <%.*s>", (int)cmd.cmd.len, cmd.cmd.s);
+    printf("\n");
+}
+#endif
+
+/*span writer for the sink demo, counts the write calls*/
+int sink_write_cnt = 0;
+int sink_write(void *arg, const char *p, msg_size_t n)
+{
+    (void)arg;
+    sink_write_cnt++;
+    return (int)fwrite(p, 1, n, stdout);
+}
+
 
 
 int main()
@@ -67,7 +88,7 @@ int main()
     printf(">> getting test_msg...\n");
     msg = msg_get(test_str1, "test_msg", sizeof(test_str1));
     if(msg_get_content(msg) != NULL) {
-        printf("msg.id_len: %d msg.content_len: %d\n", msg.id.len, msg.content.len);
+        printf("msg.id_len: %d msg.content_len: %d\n", (int)msg.id.len, (int)msg.content.len);
         hnd.print_str(msg.id);
         printf(":");
         hnd.print_str(msg.content);
@@ -95,14 +116,14 @@ int main()
     
     printf(">> getting obj1...\n");
     obj1 = msg_parser_get_obj(msg, "obj1");
-    printf("obj1.id_len: %d obj1.content_len: %d\n", obj1.id.len, obj1.content.len);
+    printf("obj1.id_len: %d obj1.content_len: %d\n", (int)obj1.id.len, (int)obj1.content.len);
     hnd.print_str(obj1.id); printf(":"); hnd.print_str(obj1.content);
     printf("\n\n");
 
     
     printf(">> getting obj2...\n");
     obj2 = msg_parser_get_obj(msg, "obj2");
-    printf("obj2.id_len: %d obj2.content_len: %d\n", obj2.id.len, obj2.content.len);
+    printf("obj2.id_len: %d obj2.content_len: %d\n", (int)obj2.id.len, (int)obj2.content.len);
     hnd.print_str(obj2.id); printf(":"); hnd.print_str(obj2.content);
     printf("\n\n");
     
@@ -119,14 +140,104 @@ int main()
     printf("r = %d fval = %.11f\n\n", res, fval);
 
     
+    printf(">> getting obj2->key21 double...\n");
+    double dval = 0.0;
+    res = msg_parser_get_double(&dval, obj2, "key21");
+    printf("r = %d dval = %.11f\n\n", res, dval);
+
+    printf(">> getting obj1->key11 64 bit integer...\n");
+    int64_t i64val = 0;
+    res = msg_parser_get_int64(&i64val, obj1, "key11");
+    printf("r = %d i64val = %" PRId64 "\n\n", res, i64val);
+
+    printf(">> getting obj1->key11 unsigned 64 bit integer...\n");
+    uint64_t u64val = 0;
+    res = msg_parser_get_uint64(&u64val, obj1, "key11");
+    printf("r = %d (%s)\n\n", res, res == MSG_NUM_OVERFLOW ? "overflow" : "ok");
+
+    printf(">> getting integers longer than 20 digits...\n");
+    char long_ints[] = "#L{@N($u1=100000000000000000000;$u2=184467440737095516150;$i1=78045301573441722100;$u3=18446744073709551615)}";
+    msg_obj_t long_obj = msg_parser_get_obj(msg_get(long_ints, "L", sizeof(long_ints)), "N");
+    res = msg_parser_get_uint64(&u64val, long_obj, "u1");
+    printf("u1: %s\n", res == MSG_NUM_OVERFLOW ? "overflow" : "ok");
+    res = msg_parser_get_uint64(&u64val, long_obj, "u2");
+    printf("u2: %s\n", res == MSG_NUM_OVERFLOW ? "overflow" : "ok");
+    res = msg_parser_get_int64(&i64val, long_obj, "i1");
+    printf("i1: %s\n", res == MSG_NUM_OVERFLOW ? "overflow" : "ok");
+    res = msg_parser_get_uint64(&u64val, long_obj, "u3");
+    printf("u3: %s %" PRIu64 "\n\n", res == MSG_NUM_OVERFLOW ? "overflow" : "ok", u64val);
+
     printf(">> getting obj1->key12 string...\n");
     msg_str_t str = msg_parser_get_str(obj1, "key12");
     if(msg_str_p(str) != NULL) {
-        hnd.print_str(str); printf(" len: %d\n\n", str.len);
+        hnd.print_str(str); printf(" len: %d\n\n", (int)str.len);
     } else {
         printf("error getting string\n\n");
     }
     
+
+    printf(">> getting all of obj2 keys with one scan...\n");
+    int key23;
+    float key21, key24;
+    msg_str_t key22;
+    msg_key_desc_t descs[] = {
+        {"key21", MSG_KEY_FLOAT, &key21},
+        {"key22", MSG_KEY_STR,   &key22},
+        {"key23", MSG_KEY_INT,   &key23},
+        {"key24", MSG_KEY_FLOAT, &key24},
+        {"key25", MSG_KEY_INT,   &key23}
+    };
+    res = msg_parser_get_many(obj2, descs, 5);
+    printf("found: 0x%02x key21 = %f key23 = %d key24 = %f key22 = ", res, key21, key23, key24);
+    hnd.print_str(key22); printf("\n\n");
+
+    printf(">> walking objects, keys and commands of test_msg...\n");
+    msg_size_t obj_cursor = 0, key_cursor, cmd_cursor = 0;
+    msg_obj_t it_obj;
+    msg_cmd_t it_cmd;
+    msg_str_t it_key, it_val;
+    while((it_obj = msg_parser_next_obj(msg, &obj_cursor)).content.s != NULL) {
+        hnd.print_str(it_obj.id); printf(":");
+        key_cursor = 0;
+        while((it_key = msg_parser_next_key(it_obj, &key_cursor, &it_val)).s != NULL) {
+            printf(" "); hnd.print_str(it_key);
+            if(msg_num_ok(msg_val_to_double(&dval, it_val))) printf("=%g", dval);
+            else { printf("="); hnd.print_str(msg_val_to_str(it_val)); }
+        }
+        printf("\n");
+    }
+    while((it_cmd = msg_parser_next_cmd(msg, &cmd_cursor)).cmd.s != NULL) {
+        printf("cmd: "); hnd.print_str(it_cmd.cmd); printf("\n");
+    }
+    printf("\n");
+
+    printf(">> building index of test_msg...\n");
+    msg_index_rec_t recs[16];
+    msg_index_t idx = msg_index_build(msg, recs, 16);
+    printf("records: %d overflow: %d\n", (int)idx.cnt, idx.overflow);
+    obj2 = msg_index_get_obj(&idx, "obj2");
+    res = msg_index_get_int(&ival, &idx, obj2, "key23");
+    printf("r = %d obj2->key23 = %d\n", res, ival);
+    res = msg_index_get_float(&fval, &idx, obj2, "key24");
+    printf("r = %d obj2->key24 = %f\n", res, fval);
+    str = msg_index_get_str(&idx, obj2, "key22");
+    hnd.print_str(str); printf(" len: %d\n", (int)str.len);
+    cmd = msg_index_get_cmd(&idx, "CMD_last");
+    printf("CMD_last: %s\n\n", msg_get_cmd_content(cmd) ? "True" : "False");
+
+    printf(">> feeding test_str1 to the stream parser in 7 byte chunks...\n");
+    char stream_buff[200];
+    msg_stream_t stream;
+    msg_size_t pos = 0, n;
+    msg_stream_init(&stream, stream_buff, sizeof(stream_buff));
+    while(pos < sizeof(test_str1)) {
+        n = msg_stream_feed(&stream, test_str1 + pos, sizeof(test_str1) - pos < 7 ? sizeof(test_str1) - pos : 7);
+        pos += n;
+        if(msg_stream_ready(&stream)) {
+            printf("message completed at %d: ", (int)pos);
+            hnd.print_str(stream.msg.id); printf(" content_len: %d\n\n", (int)stream.msg.content.len);
+        }
+    }
     
 
 
@@ -232,12 +343,57 @@ int main()
     printf("Add '@wrapped_obj1' AGAIN to '#wrapped_msg'...\n\n");
     msg_wrapper_add_obj_to_msg(&msg_wrap, &obj1_wrap);
 
+    printf("Formatting numbers: ");
+    hnd.print_float(0.05, 2); putchar(' ');
+    hnd.print_float(f2.val, MSG_FMT_SHORTEST); putchar(' ');
+    hnd.print_float(3.0e25f, MSG_FMT_SHORTEST); putchar(' ');      // beyond 2^64
+    hnd.print_float(1.0e-20f, MSG_FMT_SHORTEST); putchar(' ');     // tiny
+    hnd.print_float(1.0e-45f, MSG_FMT_SHORTEST); putchar(' ');     // subnormal
+    hnd.print_int(i1.val); printf("\n\n");
+
     printf("Wrapped message:\n");
     printf("---------------\n\n");
     hnd.print_wrapper_msg(msg_wrap);
 
 
     printf("\n\n");
+    printf("Same message with builder:\n");
+    printf("-------------------------\n\n");
+    msg_bld_entry_t arena[16];
+    msg_builder_t bld = msg_builder_create("wrapped_msg", arena, 16);
+    msg_size_t bld_obj1, bld_obj2, bld_rem[4];
+
+    msg_builder_add_cmd(&bld, "CMD_WRAP");
+    bld_rem[0] = msg_builder_add_cmd(&bld, "CMD_REMOVEABLE");
+    bld_obj2 = msg_builder_add_obj(&bld, "wrapped_obj2");
+    msg_builder_add_int(&bld, bld_obj2, "i1", -3244);
+    bld_rem[1] = msg_builder_add_int(&bld, bld_obj2, "i2", 456789);
+    bld_rem[2] = msg_builder_add_float(&bld, bld_obj2, "f1", 1.23456, 6);
+    msg_builder_add_float(&bld, bld_obj2, "f2", -0.3345, 6);
+    bld_obj1 = msg_builder_add_obj(&bld, "wrapped_obj1");
+    bld_rem[3] = msg_builder_add_str(&bld, bld_obj1, "str2", "This is 'string 2'");
+    msg_builder_add_str(&bld, bld_obj1, "str3", ".... \"string 3\"");
+    for(int k = 0; k < 4; k++) msg_builder_rm(&bld, bld_rem[k]);
+    hnd.print_builder(&bld);
+    printf("\n(%d arena entries used)\n\n", (int)bld.cnt);
+
+    printf("Same message with template (values changed after compile):\n");
+    printf("----------------------------------------------------------\n\n");
+    char tpl_buff[200];
+    msg_tpl_slot_t tpl_slots[8];
+    msg_template_t tpl = msg_template_compile(msg_wrap, tpl_buff, sizeof(tpl_buff), tpl_slots, 8);
+    hnd.print_template(&tpl); printf("\n");
+    i1.val = 42;
+    f2.val = 12.5;
+    hnd.print_template(&tpl); printf("\n");
+    msg_reparsed = msg_get(tpl_buff, "wrapped_msg", tpl.buff.len);
+    obj_reparsed = msg_parser_get_obj(msg_reparsed, "wrapped_obj2");
+    msg_parser_get_int(&i_val, obj_reparsed, "i1");
+    msg_parser_get_float(&f_val, obj_reparsed, "f2");
+    printf("reparsed $i1 = %d $f2 = %f\n", i_val, f_val);
+    i1.val = -3244;
+    f2.val = -0.3345;
+    printf("\n");
 
     char buff[1000] = {0};
     hnd.init_str_buff(buff, 1000);
@@ -252,11 +408,34 @@ int main()
     printf("Buffer content:\n");
     printf("%s\n\n", buff);
 
+    printf("Wrapped message through span sink:\n");
+    msg_sink_t sink = {sink_write, NULL};
+    msg_ctx_t sink_ctx;
+    msg_ctx_init_sink(&sink_ctx, sink);
+    msg_ctx_print_wrapper_msg(&sink_ctx, msg_wrap);
+    printf("\nsink write calls: %d\n\n", sink_write_cnt);
+
+    printf("Measuring #wrapped_msg: %u bytes\n", (unsigned)msg_wrap_measure(msg_wrap));
+    char small_buff[64];
+    uint32_t required;
+    msg_size_t written = msg_wrap_print_to_buff(msg_wrap, small_buff, sizeof(small_buff), &required);
+    printf("Printing to %d bytes buffer: written %d, required %u\n", (int)sizeof(small_buff), (int)written, (unsigned)required);
+    written = msg_wrap_print_to_buff(msg_wrap, buff, 1000, &required);
+    printf("Printing to 1000 bytes buffer: written %d, required %u\n\n", (int)written, (unsigned)required);
+
+    printf("Walking all messages of the buffer...\n\n");
+    msg_size_t cursor = 0;
+    for(msg_reparsed = msg_next(buff, 1000, &cursor); msg_get_content(msg_reparsed) != NULL; 
+                                                        msg_reparsed = msg_next(buff, 1000, &cursor)) {
+        hnd.print_str(msg_reparsed.id); printf(" content_len: %d end: %d\n", (int)msg_reparsed.content.len, (int)cursor);
+    }
+    printf("\n");
+
     printf("Reparsing '#wrapped_msg' '@wrapped_obj2'...\n\n");
     msg_reparsed = msg_get(buff, "wrapped_msg", 1000);
     hnd.print_msg(msg_reparsed); printf("\n\n");
     obj_reparsed = msg_parser_get_obj(msg_reparsed, "wrapped_obj2");
-    hnd.print_str(obj_reparsed.content); printf(" len: %d\n\n", obj_reparsed.content.len);
+    hnd.print_str(obj_reparsed.content); printf(" len: %d\n\n", (int)obj_reparsed.content.len);
 
 
     msg_parser_get_float(&f_val, obj_reparsed, "f2");
@@ -264,24 +443,232 @@ int main()
     printf("reparsed $i = %d $f2 = %f\n\n", i_val, f_val);
     printf("\n\n");
 
+    printf("Binary encoding...\n\n");
+    char bin_buff[300], text_buff[300];
+    msg_size_t bin_len = msg_bin_wrap(msg_wrap, bin_buff, sizeof(bin_buff));
+    printf("#wrapped_msg text: %u bytes, binary: %d bytes\n", (unsigned)msg_wrap_measure(msg_wrap), (int)bin_len);
+    msg_t msg_bin = msg_bin_get(bin_buff, "wrapped_msg", bin_len);
+    obj_reparsed = msg_bin_get_obj(msg_bin, "wrapped_obj2");
+    msg_bin_get_float(&f_val, obj_reparsed, "f2");
+    msg_bin_get_int(&i_val, obj_reparsed, "i1");
+    printf("binary $i = %d $f2 = %f\n", i_val, f_val);
+    printf("binary $f2 as int: %s\n", msg_bin_get_int(&i_val, obj_reparsed, "f2") ? "found" : "not found (fraction)");
+    msg_size_t text_len = msg_bin_to_text(msg_bin, text_buff, sizeof(text_buff));
+    printf("binary to text: %.*s\n\n", (int)text_len, text_buff);
+
+    msg_reparsed = msg_get(test_str1, "test_msg", sizeof(test_str1));
+    bin_len = msg_bin_from_text(msg_reparsed, bin_buff, sizeof(bin_buff));
+    text_len = msg_reparsed.content.s + msg_reparsed.content.len + 1 - (msg_reparsed.id.s - 1); // from '#' to '}'
+    printf("#test_msg text: %d bytes, binary: %d bytes\n", (int)text_len, (int)bin_len);
+    text_len = msg_bin_to_text(msg_bin_get(bin_buff, "test_msg", bin_len), text_buff, sizeof(text_buff));
+    printf("round trip: %.*s\n\n", (int)text_len, text_buff);
+
+    msg_wrap_t ieee_wrap = msg_wrapper_create_msg("ieee");
+    msg_wrap_obj_t ieee_obj = msg_wrapper_create_obj("o");
+    msg_wrap_float_t ieee_f[3];
+    int fi;
+    ieee_f[0] = msg_wrapper_create_float("tiny", 1.0e-20f, MSG_FMT_SHORTEST);
+    ieee_f[1] = msg_wrapper_create_float("sub", 1.0e-45f, MSG_FMT_SHORTEST);
+    ieee_f[2] = msg_wrapper_create_float("pi", 3.14159265f, MSG_FMT_SHORTEST);
+    for(fi = 0; fi < 3; fi++) msg_wrapper_add_float_to_obj(&ieee_obj, &ieee_f[fi]);
+    msg_wrapper_add_obj_to_msg(&ieee_wrap, &ieee_obj);
+    bin_len = msg_bin_wrap(ieee_wrap, bin_buff, sizeof(bin_buff));
+    text_len = msg_bin_to_text(msg_bin_get(bin_buff, "ieee", bin_len), text_buff, sizeof(text_buff));
+    printf("raw IEEE floats to text: %.*s\n", (int)text_len, text_buff);
+    obj_reparsed = msg_parser_get_obj(msg_get(text_buff, "ieee", text_len), "o");
+    for(fi = 0; fi < 3; fi++) {
+        f_val = 0;
+        msg_parser_get_float(&f_val, obj_reparsed, ieee_f[fi].id.s);
+        printf("$%.*s: %s\n", (int)ieee_f[fi].id.len, ieee_f[fi].id.s, memcmp(&f_val, &ieee_f[fi].val, sizeof(float)) ? "differs" : "same bits");
+    }
+    printf("\n\n");
+
+    printf("Session dictionary...\n\n");
+    msg_str_t dict_ids[8], rx_ids[8];
+    char rx_pool[64];
+    msg_dict_t dict = msg_dict_create(dict_ids, 8, NULL, 0);
+    msg_dict_add(&dict, "wrapped_msg");
+    msg_dict_add(&dict, "wrapped_obj1");
+    msg_dict_add(&dict, "wrapped_obj2");
+    msg_dict_add(&dict, "CMD_WRAP");
+    msg_ctx_t dict_ctx;
+    msg_ctx_init(&dict_ctx, NULL);
+    msg_ctx_init_str_buff(&dict_ctx, text_buff, sizeof(text_buff));
+    msg_ctx_enable_buff(&dict_ctx);
+    msg_ctx_print_dict(&dict_ctx, &dict); // announce, then tokens are used
+    msg_ctx_set_dict(&dict_ctx, &dict);
+    msg_ctx_print_wrapper_msg(&dict_ctx, msg_wrap);
+    text_len = dict_ctx.p - text_buff;
+    printf("sent: %.*s\n", (int)text_len, text_buff);
+    printf("#wrapped_msg bytes saved: %u of %u\n", (unsigned)msg_dict_wrap_saved(&dict, msg_wrap),
+                                                  (unsigned)msg_wrap_measure(msg_wrap));
+
+    msg_dict_t rx_dict = msg_dict_create(rx_ids, 8, rx_pool, sizeof(rx_pool));
+    cursor = 0;
+    printf("learned ids: %d\n", (int)msg_dict_learn(&rx_dict, msg_next(text_buff, text_len, &cursor)));
+    msg_reparsed = msg_dict_get(&rx_dict, text_buff, "wrapped_msg", text_len);
+    obj_reparsed = msg_dict_get_obj(&rx_dict, msg_reparsed, "wrapped_obj2");
+    msg_dict_get_int(&i_val, &rx_dict, obj_reparsed, "i1");
+    printf("received #"); hnd.print_str(msg_reparsed.id); printf(" @"); hnd.print_str(obj_reparsed.id);
+    printf(" $i1 = %d\n\n\n", i_val);
+
+    printf("Delta mode...\n\n");
+    msg_delta_slot_t delta_slots[8];
+    char delta_pool[64];
+    msg_state_entry_t state_entries[8];
+    char state_pool[128];
+    msg_delta_t delta = msg_delta_create(msg_wrap, delta_slots, 8, delta_pool, sizeof(delta_pool), 3);
+    msg_state_t state = msg_state_create(state_entries, 8, state_pool, sizeof(state_pool));
+    for(int frame = 0; frame < 4; frame++) {
+        if(frame == 1) i1.val++;
+        msg_ctx_reset_str_buff(&dict_ctx);
+        msg_ctx_set_dict(&dict_ctx, NULL);
+        msg_ctx_print_delta(&dict_ctx, &delta);
+        text_len = dict_ctx.p - text_buff;
+        msg_state_merge(&state, msg_get(text_buff, "wrapped_msg", text_len));
+        msg_state_get_int(&i_val, &state, "wrapped_obj2", "i1");
+        printf("sent: %.*s -> state $i1 = %d\n", (int)text_len, text_buff, i_val);
+    }
+    msg_wrapper_add_int_to_obj(&obj2_wrap, &i2);                      // new key: keyframe with the new shape
+    msg_ctx_reset_str_buff(&dict_ctx);
+    msg_ctx_print_delta(&dict_ctx, &delta);
+    text_len = dict_ctx.p - text_buff;
+    printf("$i2 added, sent: %.*s\n", (int)text_len, text_buff);
+    msg_wrapper_rm_int_from_obj(&obj2_wrap, &i2);
+    i1.val--;
+    printf("\n\n");
+
+    printf("Framing...\n\n");
+    msg_size_t frame_len = msg_wrap_print_frame(msg_wrap, text_buff, sizeof(text_buff), NULL);
+    memcpy(text_buff + frame_len, text_buff, frame_len);              // second copy of the frame
+    text_buff[frame_len + MSG_FRAME_HDR_SIZE + 5] ^= 0x20;            // corrupted byte in the second frame
+    memcpy(text_buff + 2 * frame_len, text_buff, frame_len);          // third, valid copy
+    printf("3 frames of %d bytes, the second is corrupted\n", (int)frame_len);
+    cursor = 0;
+    msg_str_t payload;
+    for(payload = msg_frame_next(text_buff, 3 * frame_len, sizeof(text_buff), &cursor); payload.s != NULL;
+                                                        payload = msg_frame_next(text_buff, 3 * frame_len, sizeof(text_buff), &cursor)) {
+        printf("valid frame end: %d payload: %.*s\n", (int)cursor, (int)payload.len, payload.s);
+    }
+    printf("\n\n");
+
+#if MCU_MSG_USE_IOVEC
+    printf("iovec output...\n\n");
+    struct iovec iov[16];
+    char iov_scratch[64];
+    msg_size_t iov_cnt = msg_wrap_to_iovec(msg_wrap, iov, 16, iov_scratch, sizeof(iov_scratch));
+    printf("%d iovec entries, referenced spans:", (int)iov_cnt);
+    for(int k = 0; k < iov_cnt; k++) {
+        if((char *)iov[k].iov_base < iov_scratch || (char *)iov[k].iov_base >= iov_scratch + sizeof(iov_scratch)) {
+            printf(" '%.*s'", (int)iov[k].iov_len, (char *)iov[k].iov_base);
+        }
+    }
+    printf("\nwritev: ");
+    fflush(stdout);
+    writev(STDOUT_FILENO, iov, iov_cnt);
+    printf("\n\n\n");
+#endif
+
+#if MCU_MSG_USE_RX
+    printf("Receive buffer with cursor...\n\n");
+    char rx_buff[64];
+    msg_rx_t rx = msg_rx_create(rx_buff, sizeof(rx_buff));
+    msg_t rx_msg;
+    char rx_chunks[][24] = {"#MASTER_MSG{<Get_", "Temp>}#MAST", "ER_MSG{<Get_Volt>}\r\n"};
+    for(int k = 0; k < 3; k++) {
+        msg_rx_write(&rx, rx_chunks[k], strlen(rx_chunks[k]));
+        rx_msg = msg_rx_get(&rx, "MASTER_MSG");
+        while(msg_get_content(rx_msg) != NULL) {
+            printf("chunk %d: '%.*s' handled, ", k, (int)rx_msg.content.len, rx_msg.content.s);
+            msg_consume(&rx, rx_msg); // it's not found again
+            rx_msg = msg_rx_get(&rx, "MASTER_MSG");
+        }
+        printf("chunk %d: %d pending bytes\n", k, (int)msg_rx_pending(&rx));
+    }
+    printf("\n\n");
+#endif
+
+#if MCU_MSG_USE_ROUTER
+    printf("Dispatching messages by router...\n\n");
+    msg_route_node_t route_node[64];
+    msg_route_t route[8];
+    msg_router_t router = msg_router_create(route_node, 64, route, 8);
+    char route_buff[] = "#MASTER_MSG{<Get_Temp>}#SLAVE_MSG{@Temp($T1=32.45)}#MASTER_MSG{<Reset>}#LOG{$x=1}";
+    msg_size_t route_cursor = 0;
+    msg_router_add(&router, "MASTER_MSG", route_print, "master");
+    msg_router_add(&router, "SLAVE_MSG", route_print, "slave");
+    msg_router_add_cmd(&router, "MASTER_MSG", "Get_Temp", route_print, "get temp");
+    msg_router_add_cmd(&router, NULL, "Reset", route_print, "reset");
+    msg_router_set_default(&router, route_print, "default");
+    printf("%d messages dispatched, %d trie nodes\n", (int)msg_router_dispatch(&router, route_buff, sizeof(route_buff), &route_cursor), (int)router.cnt);
+    printf("\n\n");
+#endif
+
+#if MCU_MSG_USE_FILE
+    printf("Reading mapped capture file...\n\n");
+    char cap_path[] = "/tmp/mcu-msg-capture-XXXXXX";
+    char cap_text[] = "#SENSOR{@Temp($T1=21.5)}\r\nnoise\r\n#LOG{$text='#SENSOR{@Temp($T1=0)}'}\r\n#SENSOR{@Temp($T1=22.25)}\r\n";
+    int cap_fd = mkstemp(cap_path);
+    msg_file_t cap;
+    msg_t cap_msg;
+    if(cap_fd >= 0 && write(cap_fd, cap_text, strlen(cap_text)) > 0 && msg_file_open(&cap, cap_path) == 0) {
+        printf("%d bytes mapped\n", (int)cap.len);
+        while(msg_get_content((cap_msg = msg_file_get(&cap, "SENSOR"))) != NULL) {
+            if(msg_num_ok(msg_parser_get_float(&f_val, msg_parser_get_obj(cap_msg, "Temp"), "T1"))) printf("offset %d: T1 = %f\n", (int)(cap_msg.id.s - 1 - cap.base), f_val);
+        }
+        msg_file_close(&cap);
+    }
+    if(cap_fd >= 0) {
+        close(cap_fd);
+        unlink(cap_path);
+    }
+    printf("\n\n");
+#endif
+
+#if MCU_MSG_USE_SEG
+    printf("Parsing wrapped ring segments...\n\n");
+    char seg_ring_buff[64];
+    msg_ring_t seg_ring = msg_ring_create(seg_ring_buff, sizeof(seg_ring_buff));
+    msg_ctx_t seg_ctx;
+    msg_seg_t view;
+    char seg_fill[] = "#FILL{$pad='012345678901234'}";
+    char seg_sensor[] = "#SENSOR{@Temp($T1=32.45;$name='outdoor unit')}";
+    msg_str_t seg_src = {seg_fill, sizeof(seg_fill) - 1};
+    msg_ctx_init_ring(&seg_ctx, &seg_ring);
+    msg_ctx_print_str(&seg_ctx, seg_src);
+    msg_ring_commit(&seg_ring);
+    msg_ring_consume(&seg_ring, msg_ring_avail(&seg_ring)); // next message wraps around
+    seg_src.s = seg_sensor;
+    seg_src.len = sizeof(seg_sensor) - 1;
+    msg_ctx_print_str(&seg_ctx, seg_src);
+    msg_ring_commit(&seg_ring);
+    msg_ring_peek(&seg_ring, view.part);
+    printf("segments: '%.*s' + '%.*s'\n", (int)view.part[0].len, view.part[0].s, (int)view.part[1].len, view.part[1].s);
+    msg_seg_msg_t seg_msg = msg_get_seg(view, "SENSOR");
+    msg_seg_obj_t seg_obj = msg_parser_get_obj_seg(seg_msg, "Temp");
+    msg_seg_t seg_str = msg_parser_get_str_seg(seg_obj, "name");
+    if(msg_num_ok(msg_parser_get_float_seg(&f_val, seg_obj, "T1"))) printf("T1 = %f\n", f_val);
+    printf("name = '%.*s' + '%.*s'\n", (int)seg_str.part[0].len, seg_str.part[0].s, (int)seg_str.part[1].len, seg_str.part[1].s);
+    msg_ring_consume(&seg_ring, msg_seg_len(view));
+    printf("\n\n");
+#endif
+
 
     /*Emulating master slave communication*/
     
     printf("Emulating a master - slave communaication:\n");
     printf("-----------------------------------------\n\n");
-    memset(buff, 0, 1000);
-    common_buff.buff = buff;
-    common_buff.buff_size = 1000;
+    master_rx = msg_ring_create(master_rx_buff, sizeof(master_rx_buff));
+    slave_rx = msg_ring_create(slave_rx_buff, sizeof(slave_rx_buff));
+    master_arg.rx = slave_arg.tx = &master_rx;
+    master_arg.tx = slave_arg.rx = &slave_rx;
 
-    if(pthread_mutex_init(&outp_lock, NULL)) return 0;
-    
-    pthread_create(&thr_master, NULL, thread_mcu_master_fnc, (void *) &common_buff);
-    pthread_create(&thr_slave, NULL, thread_mcu_slave_fnc, (void *) &common_buff);
+    pthread_create(&thr_master, NULL, thread_mcu_master_fnc, (void *) &master_arg);
+    pthread_create(&thr_slave, NULL, thread_mcu_slave_fnc, (void *) &slave_arg);
 
 
     pthread_join(thr_master, NULL);
     pthread_join(thr_slave, NULL);
-    pthread_mutex_destroy(&outp_lock);
 #endif
 
     printf("\n\n");
@@ -296,20 +683,19 @@ int main()
 
 void *thread_mcu_master_fnc(void *arg)
 {
-        thread_arg *buff = (thread_arg *) arg;
-        msg_hnd_t hnd;
-        msg_t msg_in;
-        msg_obj_t temp_obj;
+        thread_arg *ring = (thread_arg *) arg;
+        msg_ctx_t ctx, tx_ctx;
+        msg_seg_msg_t msg_in;
+        msg_seg_obj_t temp_obj;
+        msg_seg_t rx_view;
         msg_wrap_t msg_out;
         msg_wrap_cmd_t cmd;
 
         float T1, T2;
 
-        /*Create handler*/
-        hnd = msg_hnd_create((int (*) (char))putchar);
-
-        /*init common string buffer*/
-        hnd.init_str_buff(buff->buff, buff->buff_size);
+        /*Own output contexts of the thread, no locking needed*/
+        msg_ctx_init(&ctx, (int (*) (char))putchar);
+        msg_ctx_init_ring(&tx_ctx, ring->tx);
         
         /*Init message wrappeper*/
         msg_out = msg_wrapper_create_msg("MASTER_MSG");
@@ -320,47 +706,40 @@ void *thread_mcu_master_fnc(void *arg)
         /*Add command to the message*/
         msg_wrapper_add_cmd_to_msg(&msg_out, &cmd);
 
-        /*Enable string buffer and send message*/
-        pthread_mutex_lock(&outp_lock); // LOCK
-        
-        hnd.enable_buff();
-        hnd.print_wrapper_msg(msg_out);
-        hnd.disable_buff();
-        
-
         /*Print message to stdout*/
         printf("Master >> ");
-        hnd.print_wrapper_msg(msg_out);
+        msg_ctx_print_wrapper_msg(&ctx, msg_out);
         printf("\n");
 
-        pthread_mutex_unlock(&outp_lock); // UNLOCK
+        /*Send message, commit wakes the slave*/
+        msg_ctx_print_wrapper_msg(&tx_ctx, msg_out);
+        msg_ring_commit(ring->tx);
 
-        /*Polling the common buffer*/
-        while(1) {
+        /*Sleeping until the answer arrives, it's parsed in the ring whitout copy*/
+        while(msg_ring_wait(ring->rx, -1)) {
             
-            msg_in = msg_get(buff->buff, "SLAVE_MSG", buff->buff_size);
-            if(msg_get_content(msg_in) != NULL) { // msg is arrived
+            msg_ring_peek(ring->rx, rx_view.part);
+            msg_in = msg_get_seg(rx_view, "SLAVE_MSG");
+            if(msg_seg_p(msg_in.content) != NULL) { // msg is arrived
                 
-                pthread_mutex_lock(&outp_lock); // LOCK
-                
-                temp_obj = msg_parser_get_obj(msg_in, "Temp");
+                temp_obj = msg_parser_get_obj_seg(msg_in, "Temp");
 
-                if(msg_get_content(temp_obj) != NULL) {
+                if(msg_seg_p(temp_obj.content) != NULL) {
                     
-                    if(msg_parser_get_float(&T1, temp_obj, "T1")) {
+                    if(msg_num_ok(msg_parser_get_float_seg(&T1, temp_obj, "T1"))) {
                     printf("Master >> T1 = %f (from Slave)\n", T1);
                     }
-                    if(msg_parser_get_float(&T2, temp_obj, "T2")) {
+                    if(msg_num_ok(msg_parser_get_float_seg(&T2, temp_obj, "T2"))) {
                         printf("Master >> T2 = %f (from Slave)\n", T2);
                     }
                     
                 }
-                
-                pthread_mutex_unlock(&outp_lock); // UNLOCK
 
+                /*The views point into the ring, the bytes are released after the last parse*/
+                msg_ring_consume(ring->rx, msg_seg_len(rx_view));
                 break;
             }
-            usleep(1000);
+            msg_ring_consume(ring->rx, msg_seg_len(rx_view)); // not arrived, the bytes aren't needed
         }
 
         return 0;
@@ -370,20 +749,21 @@ void *thread_mcu_master_fnc(void *arg)
 
 void *thread_mcu_slave_fnc(void *arg)
 {
-        thread_arg *buff = (thread_arg *) arg;
-        msg_hnd_t hnd;
+        thread_arg *ring = (thread_arg *) arg;
+        msg_ctx_t ctx, tx_ctx;
         msg_t msg_in;
         msg_cmd_t cmd;
         msg_wrap_obj_t temp_obj;
         msg_wrap_t msg_out;
         msg_wrap_float_t T1;
         msg_wrap_float_t T2;
+        msg_str_t rx_seg[2];
+        char rx_buff[300];
+        msg_rx_t rx = msg_rx_create(rx_buff, sizeof(rx_buff));
 
-        /*Create handler*/
-        hnd = msg_hnd_create((int(*)(char))putchar);
-
-        /*init common string buffer*/
-        hnd.init_str_buff(buff->buff, buff->buff_size);
+        /*Own output contexts of the thread, no locking needed*/
+        msg_ctx_init(&ctx, (int(*)(char))putchar);
+        msg_ctx_init_ring(&tx_ctx, ring->tx);
 
         /*Init message wrappeper*/
         msg_out = msg_wrapper_create_msg("SLAVE_MSG");
@@ -402,36 +782,37 @@ void *thread_mcu_slave_fnc(void *arg)
         /*Add object to message*/
         msg_wrapper_add_obj_to_msg(&msg_out, &temp_obj);
 
-        /*Polling the commong buffer*/
-        while(1) {
+        /*Sleeping until a message arrives*/
+        while(msg_ring_wait(ring->rx, -1)) {
             
-            /*Get message*/
-            msg_in = msg_get(buff->buff, "MASTER_MSG", buff->buff_size);
+            /*Append the received bytes to the receive buffer*/
+            msg_ring_peek(ring->rx, rx_seg);
+            msg_rx_write(&rx, rx_seg[0].s, rx_seg[0].len);
+            msg_rx_write(&rx, rx_seg[1].s, rx_seg[1].len);
+            msg_ring_consume(ring->rx, rx_seg[0].len + rx_seg[1].len);
+
+            /*Get message after the handled ones*/
+            msg_in = msg_rx_get(&rx, "MASTER_MSG");
         
             if(msg_get_content(msg_in) != NULL) { //message arrived
 
-                /*Get command*/
+                /*Get command, the message is handled*/
                 cmd = msg_parser_get_cmd(msg_in, "Get_Temp");
+                msg_consume(&rx, msg_in);
                 if(msg_get_cmd_content(cmd) != NULL) { //command arrived
 
-                    pthread_mutex_lock(&outp_lock); // LOCK
-
-                    /*Send to the master*/
-                    hnd.enable_buff();
-                    hnd.print_wrapper_msg(msg_out);
-                    hnd.disable_buff();
-
                     /*Print to stdout*/
                     printf("Slave: >> ");
-                    hnd.print_wrapper_msg(msg_out);
+                    msg_ctx_print_wrapper_msg(&ctx, msg_out);
                     printf("\n");
-                    
-                    pthread_mutex_unlock(&outp_lock); // UNLOCK
+
+                    /*Send to the master*/
+                    msg_ctx_print_wrapper_msg(&tx_ctx, msg_out);
+                    msg_ring_commit(ring->tx);
 
                     break;
                 }
             }
-            usleep(1000);
         }
 
         return 0;
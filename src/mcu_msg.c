@@ -15,8 +15,51 @@
  */
 
 #include <stdio.h>
+#include <limits.h>
 #include "mcu_msg.h"
 
+/*SIMD scanner is used if it's enabled and the target supports it*/
+#if MCU_MSG_USE_SIMD && (defined(__AVX2__) || defined(__SSE2__))
+#define __MSG_SIMD                1
+#include <immintrin.h>
+#else
+#define __MSG_SIMD                0
+#endif
+
+/*CRC32C instruction is used if it's enabled and the target supports it*/
+#if MCU_MSG_USE_SIMD && defined(__SSE4_2__)
+#define __MSG_CRC32C_HW           1
+#include <nmmintrin.h>
+#else
+#define __MSG_CRC32C_HW           0
+#endif
+
+/*Waiting side of the ring sleeps on futex on linux*/
+#if MCU_MSG_USE_RING && defined(__linux__)
+#define __MSG_RING_FUTEX          1
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
+#else
+#define __MSG_RING_FUTEX          0
+#endif
+
+/*Capture files are mapped on POSIX hosts*/
+#if MCU_MSG_USE_FILE && (defined(__unix__) || defined(__APPLE__))
+#define __MSG_FILE_MMAP           1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define __MSG_FILE_MMAP           0
+#endif
+#if MCU_MSG_USE_FILE
+#include <errno.h>
+#endif
+
 /*Control chars*/
 #define __CTRL_MSG_FLAG           '#'
 #define __CTRL_START_MSG          '{'
@@ -30,44 +73,230 @@
 #define __CTRL_CMD_START_FLAG     '<'
 #define __CTRL_CMD_STOP_FLAG      '>'
 
+/*Output modes of context*/
+#define __OUTP_DEFAULT            0     // putchar or sink
+#define __OUTP_BUFF               1     // string buffer
+#define __OUTP_COUNT              2     // only counting (measure)
+#define __OUTP_IOVEC              3     // iovec entries, scratch is the string buffer
+
+/*Words of big integers (2^1280 covers the exact comparisons of every double)*/
+#define __BIG_WORDS               40
+
+/*Bits of infinite double*/
+#define __DOUBLE_INF_BITS         0x7FF0000000000000ULL
+
+
+static msg_ctx_t __ctx;                  // default context of the handler
+
+/*Parsed decimal number*/
+typedef struct msg_num {
+    uint64_t m;          // mantissa (significant digits)
+    int32_t  exp;        // decimal exponent
+    uint8_t  neg;        // negative sign
+    uint8_t  trunc;      // digits were dropped, mantissa is not exact
+} __msg_num_t;
+
+/*Big integer for exact decimal - binary comparisons*/
+typedef struct msg_big {
+    uint32_t w[__BIG_WORDS];  // words, w[0] is the lowest
+    uint8_t  n;               // count of used words
+} __msg_big_t;
+
+/*Binary float format parameters for Eisel-Lemire algorithm*/
+typedef struct msg_bin_fmt {
+    uint8_t  mbits;      // explicit mantissa bits
+    int32_t  min_exp;    // minimum exponent
+    int32_t  inf_pow;    // biased exponent of infinity
+    int32_t  even_min;   // decimal exponent range where round to even is possible
+    int32_t  even_max;
+} __msg_bin_fmt_t;
 
-/*typedef for internal string buffer*/
-typedef struct msg_str_buff {
-    msg_str_t  buff;                      // string buffer
-    char*      p;                         // pointer to the next element
-} msg_str_buff_t;
+#if MCU_MSG_USE_ROUTER
+/*Matched command of the dispatched message*/
+typedef struct msg_route_hit {
+    msg_size_t route;    // route number
+    msg_size_t start;    // command position in the buffer
+    msg_size_t len;      // command length
+} __msg_route_hit_t;
+#endif
+
+#if MCU_MSG_USE_BIN
+/*Element of binary encoded message*/
+typedef struct msg_bin_elem {
+    uint8_t   tag;       // element tag (MSG_BIN_...)
+    msg_str_t id;        // id string
+    msg_str_t val;       // encoded value, bytes whitout length for length prefixed values
+} __msg_bin_elem_t;
+#endif
+
+/*Range of decimal exponents in the power table*/
+#define __POW5_MIN                (-64)
+#define __POW5_MAX                64
+
+/*Size of dictionary token buffer ('%', digits of token number and '\0')*/
+#define __DICT_TOK_SIZE           (sizeof(msg_size_t) * 3 + 2)
+
+/*Empty hash bucket and end of bucket list of the state store*/
+#define __STATE_NONE              ((msg_size_t)~0)
+
+/*Results of frame header check*/
+#define __FRAME_BAD               0     // not a frame header
+#define __FRAME_PART              1     // incomplete frame
+#define __FRAME_OK                2     // valid header, payload is in the buffer
+
+/*Not found position of segmented parser*/
+#define __SEG_NONE                ((msg_size_t)~0)
 
-static msg_str_buff_t __str_buff;        // internal string buffer, must be intialized always
-static uint8_t __redir_outp_to_buff = 0; // redirect output to buffer indicator
+/*Size of local buffer of numbers which straddle the boundary of a view*/
+#define __SEG_NUM_SIZE            64
 
-/*putchar implementation: must be implemented for printing to UART or other output*/
-static int (*__putc)(char) = NULL; 
+/*Root nodes of the router*/
+#define __ROUTE_MSG_ROOT          0     // message ids
+#define __ROUTE_CMD_ROOT          1     // commands of every message
+
+/*Command matching states of the dispatcher*/
+#define __ROUTE_CMD_OFF           0     // outside of command
+#define __ROUTE_CMD_ID            1     // reading command id
+#define __ROUTE_CMD_END           2     // spaces after the command id
+
+/*FNV-1a hash parameters*/
+#define __FNV_OFFSET              2166136261UL
+#define __FNV_PRIME               16777619UL
+
+/*Max. mantissa before 8 digits can be added whitout overflow*/
+#define __SWAR_MAX                ((UINT64_MAX - 99999999ULL) / 100000000ULL)
 
 /*Static function declarations*/
 static void             __msg_enable_buff(void);
 static void             __msg_disable_buff(void);
 static void             __msg_init_str_buff(char *buff, msg_size_t buff_size);
 static void             __msg_reset_str_buff(void);
-static msg_size_t       __msg_putc_to_buff(char c);
-static void             __msg_putc(char c); //use std out or redirected string buff;
+static void             __msg_flush(void);
+static msg_size_t       __msg_putc_to_buff(msg_ctx_t *ctx, char c);
+static msg_size_t       __msg_write_to_buff(msg_ctx_t *ctx, const char *p, msg_size_t n);
+static void             __msg_putc(msg_ctx_t *ctx, char c); //use std out or redirected string buff;
+static void             __msg_write(msg_ctx_t *ctx, const char *p, msg_size_t n);
+static void             __msg_write_ref(msg_ctx_t *ctx, const char *p, msg_size_t n);
+#if MCU_MSG_USE_IOVEC
+static void             __iov_add(msg_ctx_t *ctx, const char *p, msg_size_t n);
+#endif
 
 static inline uint8_t   __is_ctrl_char(char c);
 static inline uint8_t   __is_whitespace(char c);
 static msg_size_t       __str_len(char *str);
 static inline uint8_t   __is_p_in_str(msg_str_t str, char *p);
-static char*            __skip_internal_str(char *start);
+static char*            __scan_chars(char *p, char *end, char a, char b, char c);
+static char*            __skip_internal_str(msg_str_t str, char *start);
 static msg_str_t        __find_keyword(msg_str_t str, char *keyword, char flagc, char stopc);
 static msg_str_t        __find_val(msg_obj_t obj, char *key);
+static uint8_t          __str_to_num(__msg_num_t *num, msg_str_t sval, uint8_t frac);
+static uint8_t          __str_to_int(int *res_val, msg_str_t sval);
+static uint8_t          __str_to_int64(int64_t *res_val, msg_str_t sval);
+static uint8_t          __str_to_uint64(uint64_t *res_val, msg_str_t sval);
+static uint8_t          __str_to_float(float *res_val, msg_str_t sval);
+static uint8_t          __str_to_double(double *res_val, msg_str_t sval);
+static msg_str_t        __str_unquote(msg_str_t sval);
+static inline msg_str_t __val_bound(msg_obj_t obj, msg_str_t sval);
+static inline uint8_t   __keyword_eq(msg_str_t id, char *keyword);
+static char*            __next_token(msg_str_t str, char *p, msg_index_rec_t *tok);
+static msg_index_rec_t  __next_kind(msg_str_t str, msg_size_t *cursor, uint8_t kind);
+static inline void      __scan_restart(msg_scan_t *sc);
+static uint8_t          __scan_step(msg_scan_t *sc, char c);
+static msg_index_rec_t* __index_find_key(msg_index_t *idx, msg_obj_t obj, char *key);
 static void             __msg_print(msg_t msg);
+static void             __msg_write_int(msg_ctx_t *ctx, int i);
+static void             __msg_write_float(msg_ctx_t *ctx, float f, uint8_t prec);
+static void             __msg_write_id(msg_ctx_t *ctx, msg_str_t id);
 static void             __msg_print_int(int i);
 static void             __msg_print_float(float f, uint8_t prec);
 static void             __msg_print_str(msg_str_t str);
 static inline char      __define_qmark(msg_str_t str);
 
 #if MCU_MSG_USE_WRAPPER
-static void             __msg_wrapper_print_obj(msg_wrap_obj_t obj);
-static inline void      __msg_wrapper_print_cmd(msg_wrap_cmd_t cmd);
+static void             __msg_wrapper_print_obj(msg_ctx_t *ctx, msg_wrap_obj_t obj);
+static inline void      __msg_wrapper_print_cmd(msg_ctx_t *ctx, msg_wrap_cmd_t cmd);
 static void             __msg_wrapper_print_msg(msg_wrap_t msg);
+static void             __msg_builder_print(const msg_builder_t *b);
+static void             __bld_link(msg_builder_t *b, msg_size_t *head, msg_size_t *tail, msg_size_t i);
+static msg_size_t       __bld_add_key(msg_builder_t *b, msg_size_t obj, char *key, uint8_t type);
+static msg_size_t       __tpl_fmt(const msg_tpl_slot_t *sl, char *tmp);
+static uint8_t          __tpl_reserve(msg_ctx_t *ctx, msg_template_t *tpl, msg_size_t slot_size, const void *src, uint8_t type);
+static uint8_t          __tpl_fill(msg_template_t *tpl, msg_tpl_slot_t *sl);
+static void             __msg_template_print(msg_template_t *tpl);
+#endif
+
+#if MCU_MSG_USE_BIN
+static char*            __bin_get_uvar(char *p, char *end, uint64_t *v);
+static void             __bin_put_uvar(msg_ctx_t *ctx, uint64_t v);
+static void             __bin_put_head(msg_ctx_t *ctx, uint8_t tag, msg_str_t id);
+static void             __bin_put_float(msg_ctx_t *ctx, float f);
+static void             __bin_close(msg_ctx_t *ctx, char *lenp);
+static char*            __bin_elem(msg_str_t str, char *p, __msg_bin_elem_t *e);
+static uint8_t          __bin_find(msg_str_t str, uint8_t tag_min, uint8_t tag_max, char *id, __msg_bin_elem_t *e);
+static void             __bin_to_num(const __msg_bin_elem_t *e, __msg_num_t *num);
+static float            __bin_to_float(const __msg_bin_elem_t *e);
+static uint8_t          __bin_dec(msg_str_t v, uint64_t *m, uint8_t *neg, uint8_t *scale);
+static void             __bin_put_text_key(msg_ctx_t *ctx, const msg_index_rec_t *tok);
+static void             __bin_ctx_init(msg_ctx_t *ctx, char *buff, msg_size_t size);
+static uint8_t          __bin_print_val(msg_ctx_t *ctx, const __msg_bin_elem_t *e);
+static uint8_t          __bin_print_text(msg_ctx_t *ctx, msg_str_t content);
+#endif
+
+#if MCU_MSG_USE_DICT
+static msg_size_t       __dict_find(const msg_dict_t *dict, msg_str_t id);
+static msg_size_t       __dict_token(const msg_dict_t *dict, msg_str_t id, char *tok);
+static msg_size_t       __dict_key_token(const msg_dict_t *dict, char *key, char *tok);
+#endif
+
+#if MCU_MSG_USE_DELTA
+static uint32_t         __hash_str(msg_str_t str, uint32_t h);
+ #if MCU_MSG_USE_WRAPPER
+static uint8_t          __delta_bound(const msg_delta_t *d);
+static void             __delta_bind(msg_delta_t *d);
+static void             __delta_clear(msg_delta_t *d);
+static void             __delta_store(msg_delta_t *d, msg_delta_slot_t *sl, msg_str_t str);
+static uint8_t          __delta_changed(msg_delta_t *d, msg_delta_slot_t *sl, uint8_t key, const void *src);
+static void             __msg_delta_print(msg_delta_t *d);
+ #endif
+static inline uint8_t   __str_eq(msg_str_t a, msg_str_t b);
+static void             __state_reset(msg_state_t *st);
+static char*            __state_alloc(msg_state_t *st, msg_size_t n);
+static msg_state_entry_t* __state_find(const msg_state_t *st, msg_str_t obj, msg_str_t key, uint32_t h);
+static uint8_t          __state_set(msg_state_t *st, msg_str_t obj, msg_str_t key, msg_str_t val);
+static const msg_state_entry_t* __state_get(const msg_state_t *st, char *obj, char *key);
+#endif
+
+#if MCU_MSG_USE_FRAME
+static uint8_t          __frame_head(const char *p, const char *end, uint32_t max, uint32_t *len);
+static char*            __frame_scan(char *buff, msg_size_t len, msg_size_t size, msg_size_t *cursor, char *id, msg_str_t *payload);
+#endif
+
+#if MCU_MSG_USE_RING
+static void             __ring_copy(char *dst, const char *src, msg_size_t n);
+static void             __ring_wake(msg_ring_t *ring, uint32_t *addr);
+static void             __ring_sleep(uint32_t *addr, uint32_t val, int timeout_ms);
+static int              __ring_write(void *arg, const char *p, msg_size_t n);
+#endif
+
+#if MCU_MSG_USE_SEG
+static inline char      __seg_at(msg_seg_t v, msg_size_t i);
+static msg_seg_t        __seg_sub(msg_seg_t v, msg_size_t off, msg_size_t len);
+static void             __seg_destroy(msg_seg_t *v);
+static msg_size_t       __seg_scan(msg_seg_t v, msg_size_t p, char a, char b, char c);
+static msg_size_t       __seg_skip_str(msg_seg_t v, msg_size_t p);
+static msg_size_t       __seg_find_keyword(msg_seg_t v, char *keyword, char flagc, char stopc);
+static msg_seg_t        __seg_content(msg_seg_t v, msg_size_t p, char startc, char stopc);
+static msg_size_t       __seg_find_val(msg_seg_obj_t obj, char *key);
+static uint8_t          __seg_num(msg_seg_obj_t obj, char *key, char *buff, msg_str_t *sval);
+static inline msg_obj_t __seg_obj_linear(msg_seg_obj_t obj);
+#endif
+
+#if MCU_MSG_USE_ROUTER
+static void             __route_node_init(msg_route_node_t *node, char c);
+static inline msg_size_t __route_child(const msg_router_t *r, msg_size_t n, char c);
+static msg_size_t       __route_insert(msg_router_t *r, msg_size_t n, char *id);
+static msg_size_t       __route_set(msg_router_t *r, msg_size_t n, msg_route_fn fn, void *arg);
+static void             __route_call(msg_router_t *r, msg_t msg, __msg_route_hit_t *hit, uint8_t hit_cnt, char *buff);
 #endif
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -166,10 +395,22 @@ static inline uint8_t __is_whitespace(char c)
  * @param c char
  * @return uint8_t comparison result
  */
-
 #define __is_valid_keyword_char(c)        ((c == '_') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || \
                                         (c >= '0' && c <= '9'))
 
+/**
+ * @brief Argument char is valid at the position of an id or not, dictionary tokens (%N) start with '%'
+ * 
+ * @param c char
+ * @param i position in the id
+ * @return uint8_t comparison result
+ */
+#if MCU_MSG_USE_DICT
+#define __is_valid_id_char(c, i)          (__is_valid_keyword_char(c) || ((i) == 0 && (c) == MSG_DICT_TOKEN))
+#else
+#define __is_valid_id_char(c, i)          __is_valid_keyword_char(c)
+#endif
+
 /**
  * @brief strlen implementation for internal usage
  * 
@@ -193,26 +434,83 @@ static msg_size_t __str_len(char *str)
  */
 static inline uint8_t __is_p_in_str(msg_str_t str, char *p)
 {
-    return ((p - str.s) < str.len);
+    return p >= str.s && p < str.s + str.len; // independent of the width of msg_size_t
 }
 
+#if __MSG_SIMD
 /**
- * @brief Skiping internal string from start qoution mark to end qmark
+ * @brief Build the bitmask of a 64 byte block, bits are set for the searched chars and zero terminator
  * 
- * @param start start pointer
- * @return char* return end pointer
+ * @param p block start pointer (unaligned)
+ * @param a searched char
+ * @param b searched char
+ * @param c searched char
+ * @return uint64_t bitmask, bit n is for p[n]
  */
-static char *__skip_internal_str(char *start)
+static inline uint64_t __block_mask(const char *p, char a, char b, char c)
 {
-    char *p = start;
-    char qmark = *start;
-    if((qmark != '\'' && qmark != '"')) return NULL;
-    ++p;
-    while(*p && (*p != qmark)) {
-        p++;
+#if defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c), vz = _mm256_setzero_si256();
+    __m256i lo = _mm256_loadu_si256((const __m256i *)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(p + 32));
+    lo = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lo, va), _mm256_cmpeq_epi8(lo, vb)),
+                         _mm256_or_si256(_mm256_cmpeq_epi8(lo, vc), _mm256_cmpeq_epi8(lo, vz)));
+    hi = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(hi, va), _mm256_cmpeq_epi8(hi, vb)),
+                         _mm256_or_si256(_mm256_cmpeq_epi8(hi, vc), _mm256_cmpeq_epi8(hi, vz)));
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8(lo) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(hi) << 32);
+#else
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c), vz = _mm_setzero_si128();
+    uint64_t mask = 0;
+    __m128i v;
+    uint8_t i;
+    for(i = 0; i < 64; i += 16) {
+        v = _mm_loadu_si128((const __m128i *)(p + i));
+        v = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vz)));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(v) << i;
     }
-    
-    return *p ? ++p : NULL;
+    return mask;
+#endif
+}
+#endif
+
+/**
+ * @brief Find the first occurance of the searched chars or zero terminator
+ * Whole 64 byte blocks are classified with SIMD (if it's available), the tail is checked char by char
+ * @param p start pointer
+ * @param end end of the buffer (exclusive)
+ * @param a searched char
+ * @param b searched char
+ * @param c searched char
+ * @return char* first occurance or end pointer
+ */
+static char *__scan_chars(char *p, char *end, char a, char b, char c)
+{
+#if __MSG_SIMD
+    uint64_t mask;
+    while(end - p >= 64) {
+        mask = __block_mask(p, a, b, c);
+        if(mask) return p + __builtin_ctzll(mask);
+        p += 64;
+    }
+#endif
+    while(p < end && *p != a && *p != b && *p != c && *p) p++;
+    return p;
+}
+
+/**
+ * @brief Skiping internal string from start qoution mark to end qmark
+ * 
+ * @param str string buffer with start pointer and length
+ * @param start start pointer (quotation mark)
+ * @return char* pointer after the closing qmark, or the end of the buffer (zero terminator) if it's not closed
+ */
+static char *__skip_internal_str(msg_str_t str, char *start)
+{
+    char *p = __scan_chars(start + 1, str.s + str.len, *start, *start, *start);
+    return (__is_p_in_str(str, p) && *p) ? ++p : p;
 }
 
 /**
@@ -233,27 +531,28 @@ static msg_str_t __find_keyword(msg_str_t str, char *keyword, char flagc, char s
     msg_size_t i;
     res.len = __str_len(keyword);
     while(__is_p_in_str(str, p) && *p) {
+        p = __scan_chars(p, str.s + str.len, flagc, '\'', '"'); // jump to the next candidate
+        if(!__is_p_in_str(str, p) || !*p) break;
         if(*p == '\'' || *p == '"') { //skip internal strings
-            p = __skip_internal_str(p);
-        }
-        if(__is_p_in_str(str, p)  && *p == flagc) { // if flag char detected start the analization
-            res.s = p + 1;
-            equal = 1;
-            for(i = 0; __is_p_in_str(str, res.s + i) && i < res.len; i++) { // if not equal during the iterateion, break the loop
-                if((*(res.s + i) != *(keyword + i)) || __is_ctrl_char(*(res.s + i)) || 
-                                    !__is_valid_keyword_char(*(res.s + i))) {
-                    equal = 0;
-                    break;
-                }
-            }
-            while(__is_p_in_str(str, res.s + i) && __is_whitespace(*(res.s + i))) i++; //skip spaces
-            if(equal && *(res.s + i) == stopc) { //if the stop char is the next, whitout spaces, return with the match string
-                return res;
-            } else {
-                p = res.s + i; // if not matched, return continue the iteration from last checked char
+            p = __skip_internal_str(str, p);
+            continue;
+        }
+        // flag char detected start the analization
+        res.s = p + 1;
+        equal = 1;
+        for(i = 0; __is_p_in_str(str, res.s + i) && i < res.len; i++) { // if not equal during the iterateion, break the loop
+            if((*(res.s + i) != *(keyword + i)) || __is_ctrl_char(*(res.s + i)) || 
+                                !__is_valid_id_char(*(res.s + i), i)) {
+                equal = 0;
+                break;
             }
         }
-        p++;
+        while(__is_p_in_str(str, res.s + i) && __is_whitespace(*(res.s + i))) i++; //skip spaces
+        if(equal && __is_p_in_str(str, res.s + i) && *(res.s + i) == stopc) { //if the stop char is the next, whitout spaces, return with the match string
+            return res;
+        } else {
+            p = res.s + i; // if not matched, continue the iteration from last checked char
+        }
     }
     // if not found (loop finished whitout match) return with a destroyed string
     msg_destroy_str(&res);
@@ -318,6 +617,45 @@ msg_t msg_get(char *raw_str, char *id, msg_size_t len)
 }
 
 
+/*Get next message from buffer*/
+msg_t msg_next(char *buff, msg_size_t len, msg_size_t *cursor)
+{
+    msg_t res;
+    msg_scan_t sc;
+    msg_size_t i, start = 0, content = 0;
+    uint8_t prev;
+
+    sc.state = MSG_SCAN_IDLE;
+    sc.qmark = 0;
+    sc.depth = 0;
+    sc.id_len = 0;
+
+    for(i = *cursor; i < len && buff[i]; i++) {
+        prev = sc.state;
+        switch(__scan_step(&sc, buff[i])) {
+            case MSG_SCAN_ID:
+                if(!sc.id_len) start = i; // new message flag
+            break;
+            case MSG_SCAN_CONTENT:
+                if(prev == MSG_SCAN_ID || prev == MSG_SCAN_START) content = i + 1;
+            break;
+            case MSG_SCAN_READY:
+                res.id.s = buff + start + 1;
+                res.id.len = sc.id_len;
+                res.content.s = buff + content;
+                res.content.len = i - content;
+                *cursor = i + 1;
+                return res;
+            default:
+            break;
+        }
+    }
+
+    *cursor = sc.state == MSG_SCAN_IDLE ? i : start; // keep the incomplete message
+    msg_destroy(&res);
+    return res;
+}
+
 /*Get object from message by ID*/
 msg_obj_t msg_parser_get_obj(msg_t msg, char *id)
 {
@@ -350,594 +688,2541 @@ msg_cmd_t msg_parser_get_cmd(msg_t msg, char *cmd_id)
     return res;
 }
 
-/*
-Get primitive integer value from object by key
-Return 0 if there is an error or count of digits
-*/
-uint8_t msg_parser_get_int(int *res_val, msg_obj_t obj, char *key)
+/**
+ * @brief Load 8 chars to an integer, first char is the lowest byte
+ * 
+ * @param p char pointer
+ * @return uint64_t loaded chars
+ */
+static inline uint64_t __load8(const char *p)
 {
-    msg_str_t sval = __find_val(obj, key);
-    msg_size_t i;
-    unsigned m = 1;
-    int sign = 1;
-    int8_t res = 0; // result of function
+    return  (uint64_t)(uint8_t)p[0]        | (uint64_t)(uint8_t)p[1] << 8  |
+            (uint64_t)(uint8_t)p[2] << 16  | (uint64_t)(uint8_t)p[3] << 24 |
+            (uint64_t)(uint8_t)p[4] << 32  | (uint64_t)(uint8_t)p[5] << 40 |
+            (uint64_t)(uint8_t)p[6] << 48  | (uint64_t)(uint8_t)p[7] << 56;
+}
 
-    if(sval.s == NULL)  //key nout found
-        return 0;
+/**
+ * @brief All of the 8 loaded chars are digits (SWAR)
+ * 
+ * @param v loaded chars
+ * @return uint8_t comparison result
+ */
+static inline uint8_t __is_8digits(uint64_t v)
+{
+    return !(((v + 0x4646464646464646ULL) | (v - 0x3030303030303030ULL)) & 0x8080808080808080ULL);
+}
+
+/**
+ * @brief Convert 8 loaded digits to integer (SWAR)
+ * 
+ * @param v loaded chars
+ * @return uint32_t value of digits
+ */
+static inline uint32_t __parse_8digits(uint64_t v)
+{
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8); // pairs of digits
+    v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + 
+         (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return (uint32_t)v;
+}
 
+/**
+ * @brief Accumulate digits to the mantissa of the number
+ * Digits which don't fit to the mantissa set the trunc flag
+ * @param num number
+ * @param p start pointer
+ * @param end end of the value (exclusive)
+ * @param cnt digit counter
+ * @param frac digits are after the decimal separator
+ * @return char* pointer after the last digit
+ */
+static inline char *__num_digits(__msg_num_t *num, char *p, char *end, uint8_t *cnt, uint8_t frac)
+{
+    uint64_t m = num->m; // locals, char pointer may alias the number
+    int32_t exp = num->exp;
+    uint8_t trunc = num->trunc;
+    char *start = p;
+    uint64_t v;
+    uint8_t d;
 
-    switch(*sval.s) { //if the sign is defined, set the sign variable and increment the pointer
-        case '+':
-            sign = 1;
-            sval.s++;
-        break;
-        
-        case '-':
-            sign = -1;
-            sval.s++;
-        break;
-        
-        default:
-        break;
+    while(end - p >= 8 && m <= __SWAR_MAX) { // 8 digits at a time while the result fits
+        v = __load8(p);
+        if(!__is_8digits(v)) break;
+        m = m * 100000000ULL + __parse_8digits(v);
+        exp -= 8 * frac;
+        p += 8;
     }
-
-    for(i = 0; __is_p_in_str(obj.content, sval.s) && !__is_whitespace(*sval.s) && *sval.s != __CTRL_KEY_SEP; i++, sval.s++) { //move to the end of the value string with i
-        if(*sval.s < '0' || *sval.s > '9') {    // if non valid number, return with error
-            return 0;
+    for(; p < end && (d = (uint8_t)(*p - '0')) <= 9; p++) {
+        if(m < 1000000000000000000ULL) { // 10 * m + d fits whitout check
+            m = m * 10 + d;
+            exp -= frac;
+        } else if(!trunc && m <= (UINT64_MAX - d) / 10) {
+            m = m * 10 + d;
+            exp -= frac;
+        } else { // dropped digit, zeros don't make the mantissa inexact
+            if(d) trunc = 1;
+            if(!frac) exp++;
         }
     }
 
-    *res_val = 0;
-    --sval.s;
-    while(i--) { //convert value to integer
-        *res_val += (*sval.s-- - '0') * m;
-        m *= 10;
-        res++;
-    }
-    
-    *res_val *= sign; //corrigate with the sign
-
-    return res; // return with the digit count, if correct
+    num->m = m;
+    num->exp = exp;
+    num->trunc = trunc;
+    *cnt = (p - start) < MSG_NUM_OVERFLOW - *cnt ? *cnt + (p - start) : MSG_NUM_OVERFLOW - 1;
+    return p;
 }
 
-/*
-Get primitive float value from object by key
-Return 0 if key not found or digit count
-*/
-uint8_t msg_parser_get_float(float *res_val, msg_obj_t obj, char *key)
+/**
+ * @brief Parse decimal number
+ * 
+ * @param num result number
+ * @param sval value start pointer and the length until the end of the container
+ * @param frac decimal separator is accepted
+ * @return uint8_t 0 if there is an error or count of digits (+ '.' separator)
+ */
+static uint8_t __str_to_num(__msg_num_t *num, msg_str_t sval, uint8_t frac)
 {
-    msg_str_t sval = __find_val(obj, key);
-    char *pf;
-    msg_size_t i;
-    unsigned m = 1;
-    float mf = 0.1;
-    int sign = 1;
-    int8_t res = 0; // result of function
-
-    if(sval.s == NULL)  //key nout found
-        return 0;
-
-
-    switch(*sval.s) { //if the sign is defined, set the sign variable and increment the pointer
-        case '+':
-            sign = 1;
-            sval.s++;
-        break;
-        
-        case '-':
-            sign = -1;
-            sval.s++;
-        break;
-        
-        default:
-        break;
-    }
+    char *p = sval.s;
+    char *end = sval.s + sval.len;
+    uint8_t cnt = 0, dot = 0;
 
-    //move p to dec separator or end of the value
-    for(i = 0; __is_p_in_str(obj.content, sval.s) && !__is_whitespace(*sval.s) && *sval.s != __CTRL_KEY_SEP && *sval.s != '.'; i++, sval.s++) { 
-        if((*sval.s < '0' || *sval.s > '9')) {    // if non valid number, return with error
-            return 0;
-        }
-    }
+    num->m = 0;
+    num->exp = 0;
+    num->neg = 0;
+    num->trunc = 0;
 
-    *res_val = 0.0;
-    
-    if(*sval.s == '.') {
-        pf = sval.s + 1;
-        res++;
-    } else {
-        pf = NULL;
+    if(p < end && (*p == '+' || *p == '-')) { //if the sign is defined, set the sign and increment the pointer
+        num->neg = *p == '-';
+        p++;
     }
-
-    --sval.s;
-    while(i--) { // convert integer part
-        *res_val += (*sval.s-- - '0') * m;
-        m *= 10;
-        res++;
+    p = __num_digits(num, p, end, &cnt, 0);
+    if(frac && p < end && *p == '.') {
+        dot = 1;
+        cnt++;
+        p = __num_digits(num, p + 1, end, &cnt, 1);
     }
-    
-    // calculate floating point section after '.' (if there is)
-    for(; pf != NULL && __is_p_in_str(obj.content, pf) && !__is_whitespace(*pf) && *pf != __CTRL_KEY_SEP; pf++) {
-        if(*pf < '0' || *pf > '9') {    // if non valid number, return with error
-            return 0;
-        }
-        *res_val += (*pf - '0') * mf;
-        mf /= 10;
-        res++; 
+    if(cnt == dot || (p < end && !__is_whitespace(*p) && *p != __CTRL_KEY_SEP)) { // if no digit or non valid number, return with error
+        return 0;
     }
+    return cnt;
+}
 
-    *res_val *= sign; //corrigate with the sign
+/*128 bit approximations of powers of five (normalized, most significant bit is set)*/
+static const uint64_t __pow5_128[__POW5_MAX - __POW5_MIN + 1][2] = {
+    {0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL}, /* 5^-64 */
+    {0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL}, /* 5^-63 */
+    {0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL}, /* 5^-62 */
+    {0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL}, /* 5^-61 */
+    {0xcdb02555653131b6ULL, 0x3792f412cb06794dULL}, /* 5^-60 */
+    {0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL}, /* 5^-59 */
+    {0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL}, /* 5^-58 */
+    {0xc8de047564d20a8bULL, 0xf245825a5a445275ULL}, /* 5^-57 */
+    {0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL}, /* 5^-56 */
+    {0x9ced737bb6c4183dULL, 0x55464dd69685606bULL}, /* 5^-55 */
+    {0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL}, /* 5^-54 */
+    {0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL}, /* 5^-53 */
+    {0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL}, /* 5^-52 */
+    {0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL}, /* 5^-51 */
+    {0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL}, /* 5^-50 */
+    {0x95a8637627989aadULL, 0xdde7001379a44aa8ULL}, /* 5^-49 */
+    {0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL}, /* 5^-48 */
+    {0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL}, /* 5^-47 */
+    {0x9226712162ab070dULL, 0xcab3961304ca70e8ULL}, /* 5^-46 */
+    {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL}, /* 5^-45 */
+    {0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL}, /* 5^-44 */
+    {0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL}, /* 5^-43 */
+    {0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL}, /* 5^-42 */
+    {0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL}, /* 5^-41 */
+    {0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL}, /* 5^-40 */
+    {0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL}, /* 5^-39 */
+    {0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL}, /* 5^-38 */
+    {0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL}, /* 5^-37 */
+    {0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL}, /* 5^-36 */
+    {0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL}, /* 5^-35 */
+    {0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL}, /* 5^-34 */
+    {0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL}, /* 5^-33 */
+    {0xcfb11ead453994baULL, 0x67de18eda5814af2ULL}, /* 5^-32 */
+    {0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL}, /* 5^-31 */
+    {0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL}, /* 5^-30 */
+    {0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL}, /* 5^-29 */
+    {0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL}, /* 5^-28 */
+    {0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL}, /* 5^-27 */
+    {0xc612062576589ddaULL, 0x95364afe032a819eULL}, /* 5^-26 */
+    {0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL}, /* 5^-25 */
+    {0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL}, /* 5^-24 */
+    {0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL}, /* 5^-23 */
+    {0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL}, /* 5^-22 */
+    {0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL}, /* 5^-21 */
+    {0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL}, /* 5^-20 */
+    {0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL}, /* 5^-19 */
+    {0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL}, /* 5^-18 */
+    {0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL}, /* 5^-17 */
+    {0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL}, /* 5^-16 */
+    {0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL}, /* 5^-15 */
+    {0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL}, /* 5^-14 */
+    {0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL}, /* 5^-13 */
+    {0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL}, /* 5^-12 */
+    {0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL}, /* 5^-11 */
+    {0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL}, /* 5^-10 */
+    {0x89705f4136b4a597ULL, 0x31680a88f8953031ULL}, /* 5^-9 */
+    {0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL}, /* 5^-8 */
+    {0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL}, /* 5^-7 */
+    {0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL}, /* 5^-6 */
+    {0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL}, /* 5^-5 */
+    {0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL}, /* 5^-4 */
+    {0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL}, /* 5^-3 */
+    {0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL}, /* 5^-2 */
+    {0xccccccccccccccccULL, 0xcccccccccccccccdULL}, /* 5^-1 */
+    {0x8000000000000000ULL, 0x0000000000000000ULL}, /* 5^0 */
+    {0xa000000000000000ULL, 0x0000000000000000ULL}, /* 5^1 */
+    {0xc800000000000000ULL, 0x0000000000000000ULL}, /* 5^2 */
+    {0xfa00000000000000ULL, 0x0000000000000000ULL}, /* 5^3 */
+    {0x9c40000000000000ULL, 0x0000000000000000ULL}, /* 5^4 */
+    {0xc350000000000000ULL, 0x0000000000000000ULL}, /* 5^5 */
+    {0xf424000000000000ULL, 0x0000000000000000ULL}, /* 5^6 */
+    {0x9896800000000000ULL, 0x0000000000000000ULL}, /* 5^7 */
+    {0xbebc200000000000ULL, 0x0000000000000000ULL}, /* 5^8 */
+    {0xee6b280000000000ULL, 0x0000000000000000ULL}, /* 5^9 */
+    {0x9502f90000000000ULL, 0x0000000000000000ULL}, /* 5^10 */
+    {0xba43b74000000000ULL, 0x0000000000000000ULL}, /* 5^11 */
+    {0xe8d4a51000000000ULL, 0x0000000000000000ULL}, /* 5^12 */
+    {0x9184e72a00000000ULL, 0x0000000000000000ULL}, /* 5^13 */
+    {0xb5e620f480000000ULL, 0x0000000000000000ULL}, /* 5^14 */
+    {0xe35fa931a0000000ULL, 0x0000000000000000ULL}, /* 5^15 */
+    {0x8e1bc9bf04000000ULL, 0x0000000000000000ULL}, /* 5^16 */
+    {0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL}, /* 5^17 */
+    {0xde0b6b3a76400000ULL, 0x0000000000000000ULL}, /* 5^18 */
+    {0x8ac7230489e80000ULL, 0x0000000000000000ULL}, /* 5^19 */
+    {0xad78ebc5ac620000ULL, 0x0000000000000000ULL}, /* 5^20 */
+    {0xd8d726b7177a8000ULL, 0x0000000000000000ULL}, /* 5^21 */
+    {0x878678326eac9000ULL, 0x0000000000000000ULL}, /* 5^22 */
+    {0xa968163f0a57b400ULL, 0x0000000000000000ULL}, /* 5^23 */
+    {0xd3c21bcecceda100ULL, 0x0000000000000000ULL}, /* 5^24 */
+    {0x84595161401484a0ULL, 0x0000000000000000ULL}, /* 5^25 */
+    {0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL}, /* 5^26 */
+    {0xcecb8f27f4200f3aULL, 0x0000000000000000ULL}, /* 5^27 */
+    {0x813f3978f8940984ULL, 0x4000000000000000ULL}, /* 5^28 */
+    {0xa18f07d736b90be5ULL, 0x5000000000000000ULL}, /* 5^29 */
+    {0xc9f2c9cd04674edeULL, 0xa400000000000000ULL}, /* 5^30 */
+    {0xfc6f7c4045812296ULL, 0x4d00000000000000ULL}, /* 5^31 */
+    {0x9dc5ada82b70b59dULL, 0xf020000000000000ULL}, /* 5^32 */
+    {0xc5371912364ce305ULL, 0x6c28000000000000ULL}, /* 5^33 */
+    {0xf684df56c3e01bc6ULL, 0xc732000000000000ULL}, /* 5^34 */
+    {0x9a130b963a6c115cULL, 0x3c7f400000000000ULL}, /* 5^35 */
+    {0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL}, /* 5^36 */
+    {0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL}, /* 5^37 */
+    {0x96769950b50d88f4ULL, 0x1314448000000000ULL}, /* 5^38 */
+    {0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL}, /* 5^39 */
+    {0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL}, /* 5^40 */
+    {0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL}, /* 5^41 */
+    {0xb7abc627050305adULL, 0xf14a3d9e40000000ULL}, /* 5^42 */
+    {0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL}, /* 5^43 */
+    {0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL}, /* 5^44 */
+    {0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL}, /* 5^45 */
+    {0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL}, /* 5^46 */
+    {0x8c213d9da502de45ULL, 0x4526f422cc340000ULL}, /* 5^47 */
+    {0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL}, /* 5^48 */
+    {0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL}, /* 5^49 */
+    {0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL}, /* 5^50 */
+    {0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL}, /* 5^51 */
+    {0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL}, /* 5^52 */
+    {0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL}, /* 5^53 */
+    {0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL}, /* 5^54 */
+    {0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL}, /* 5^55 */
+    {0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL}, /* 5^56 */
+    {0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL}, /* 5^57 */
+    {0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL}, /* 5^58 */
+    {0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL}, /* 5^59 */
+    {0x9f4f2726179a2245ULL, 0x01d762422c946590ULL}, /* 5^60 */
+    {0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL}, /* 5^61 */
+    {0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL}, /* 5^62 */
+    {0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL}, /* 5^63 */
+    {0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL}, /* 5^64 */
+};
 
-    return res; // return with the digit count + '.' separator, if correct
+/**
+ * @brief Full 64 x 64 bit multiplication
+ * 
+ * @param a factor
+ * @param b factor
+ * @param lo lower 64 bit of the result
+ * @return uint64_t upper 64 bit of the result
+ */
+static inline uint64_t __mul_64x64(uint64_t a, uint64_t b, uint64_t *lo)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128)a * b;
+    *lo = (uint64_t)r;
+    return (uint64_t)(r >> 64);
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    *lo = (mid << 32) | (uint32_t)ll;
+    return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
 }
 
+/**
+ * @brief Count of leading zero bits
+ * 
+ * @param v value (not zero)
+ * @return uint8_t count of leading zeros
+ */
+static inline uint8_t __clz64(uint64_t v)
+{
+#if defined(__GNUC__)
+    return __builtin_clzll(v);
+#else
+    uint8_t n = 0;
+    while(!(v & 0x8000000000000000ULL)) {
+        v <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
 
-/*
-Get primitive string object from object by key
-return with string object which is destroyd if there is any error 
-*/
-msg_str_t msg_parser_get_str(msg_obj_t obj, char *key)
+/**
+ * @brief Eisel-Lemire algorithm: correctly rounded binary float from w * 10^q
+ * 
+ * @param fmt binary format parameters
+ * @param w decimal mantissa (not zero)
+ * @param q decimal exponent (in the range of the power table)
+ * @param pow2 result biased binary exponent
+ * @return uint64_t result binary mantissa whitout the implicit bit
+ */
+static uint64_t __eisel_lemire(const __msg_bin_fmt_t *fmt, uint64_t w, int32_t q, int32_t *pow2)
 {
-    msg_str_t res = __find_val(obj, key);
-    char qmark;
-    char *p;
+    const uint64_t *pow5 = __pow5_128[q - __POW5_MIN];
+    const uint64_t prec_mask = 0xFFFFFFFFFFFFFFFFULL >> (fmt->mbits + 3);
+    uint64_t hi, lo, hi2, lo2, mant;
+    uint8_t lz = __clz64(w);
+    uint8_t upperbit, shift;
 
-    if(res.s == NULL) {
-        msg_destroy_str(&res);
-        return res;
+    w <<= lz;
+    hi = __mul_64x64(w, pow5[0], &lo);
+    if((hi & prec_mask) == prec_mask) { // product is not precise enough, use the lower part of the power
+        hi2 = __mul_64x64(w, pow5[1], &lo2);
+        lo += hi2;
+        if(hi2 > lo) hi++;
     }
-        
-    qmark = *res.s;
 
-    if(qmark != '\'' && qmark != '"') { // qmark not found, this is not a string
-        msg_destroy_str(&res);
-        return res;
+    upperbit = hi >> 63;
+    shift = upperbit + 64 - fmt->mbits - 3;
+    mant = hi >> shift;
+    *pow2 = (int32_t)(((152170 + 65536) * q) >> 16) + 63 + upperbit - lz - fmt->min_exp;
+
+    if(*pow2 <= 0) { // subnormal
+        if(-*pow2 + 1 >= 64) {
+            *pow2 = 0;
+            return 0;
+        }
+        mant >>= -*pow2 + 1;
+        mant += mant & 1;
+        mant >>= 1;
+        *pow2 = mant < (1ULL << fmt->mbits) ? 0 : 1;
+        return mant & ~(1ULL << fmt->mbits);
     }
 
-    p = ++res.s;
-    while(__is_p_in_str(obj.content, p) && *p != qmark) { // calc len
-        p++;
+    if(lo <= 1 && q >= fmt->even_min && q <= fmt->even_max && (mant & 3) == 1 && 
+                                                                (mant << shift) == hi) { // round to even
+        mant &= ~1ULL;
     }
-    res.len = p - res.s;
-    return res;
+    mant += mant & 1;
+    mant >>= 1;
+    if(mant >= (2ULL << fmt->mbits)) {
+        mant = 1ULL << fmt->mbits;
+        (*pow2)++;
+    }
+    if(*pow2 >= fmt->inf_pow) { // overflow to infinity
+        *pow2 = fmt->inf_pow;
+        return 0;
+    }
+    return mant & ~(1ULL << fmt->mbits);
 }
 
 /**
- * @brief Enable buffer redirection. This function is in handler
+ * @brief Convert parsed number to binary float bits with Eisel-Lemire algorithm
  * 
+ * @param fmt binary format parameters
+ * @param num number
+ * @param bits result bits of the binary float (whitout sign)
+ * @return uint8_t 1 if it's converted, 0 if the exponent is out of the power table
+ * (more than 19 significant digits can be 1 ulp off, if the rounding boundary is in the dropped digits)
  */
-static void __msg_enable_buff(void)
+static uint8_t __num_to_bits(const __msg_bin_fmt_t *fmt, const __msg_num_t *num, uint64_t *bits)
 {
-    __redir_outp_to_buff = 1;
+    uint64_t mant, mant_up;
+    int32_t pow2, pow2_up;
+
+    if(!num->m) {
+        *bits = 0;
+        return 1;
+    }
+    if(num->exp < __POW5_MIN || num->exp > __POW5_MAX) return 0;
+
+    mant = __eisel_lemire(fmt, num->m, num->exp, &pow2);
+    if(num->trunc && num->m != UINT64_MAX) { // the exact value is between m and m + 1
+        mant_up = __eisel_lemire(fmt, num->m + 1, num->exp, &pow2_up);
+        if(mant != mant_up || pow2 != pow2_up) { // the rounding boundary is between m and m + 1, it's not decided
+            mant = mant_up;                      // by the dropped digits: m + 1 is taken, it can be 1 ulp off
+            pow2 = pow2_up;
+        }
+    }
+    *bits = mant | ((uint64_t)pow2 << fmt->mbits);
+    return 1;
 }
 
 /**
- * @brief Disable buffering and set back the standard output printing
+ * @brief Set big integer
  * 
+ * @param a big integer
+ * @param v value
  */
-static void __msg_disable_buff(void)
+static void __big_set(__msg_big_t *a, uint64_t v)
 {
-    __redir_outp_to_buff = 0;
+    a->w[0] = (uint32_t)v;
+    a->w[1] = (uint32_t)(v >> 32);
+    a->n = a->w[1] ? 2 : a->w[0] ? 1 : 0;
 }
 
 /**
- * @brief Init internal string buffer
+ * @brief Multiply big integer by 32 bit value
  * 
- * @param buff buffer pointer by user
- * @param buff_size buffer size
+ * @param a big integer
+ * @param m multiplier
  */
-static void __msg_init_str_buff(char *buff, msg_size_t buff_size)
+static void __big_mul(__msg_big_t *a, uint32_t m)
 {
-    __str_buff.buff.len = buff_size;
-    __str_buff.buff.s = buff;
-    __str_buff.p = __str_buff.buff.s;
-}
+    uint64_t c = 0;
+    uint8_t i;
 
+    for(i = 0; i < a->n; i++) {
+        c += (uint64_t)a->w[i] * m;
+        a->w[i] = (uint32_t)c;
+        c >>= 32;
+    }
+    if(c && a->n < __BIG_WORDS) a->w[a->n++] = (uint32_t)c;
+}
 
 /**
- * @brief Reset internal string buffer, set the position to first address of buffer
+ * @brief Multiply big integer by power of ten
  * 
+ * @param a big integer
+ * @param k exponent (not negative)
  */
-static void __msg_reset_str_buff(void)
+static void __big_mul_pow10(__msg_big_t *a, int32_t k)
 {
-    __str_buff.p = __str_buff.buff.s; //reset pointer (set to the start position)
+    static const uint32_t pow10[] = {
+        1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+    };
+
+    for(; k >= 9; k -= 9) __big_mul(a, pow10[9]);
+    if(k) __big_mul(a, pow10[k]);
 }
 
 /**
- * @brief Putchar to string buff
+ * @brief Shift big integer to left
  * 
- * @param c character
- * @return msg_size_t free space in buffer or 0 if there is any error 
+ * @param a big integer
+ * @param bits count of bits
  */
-static msg_size_t __msg_putc_to_buff(char c)
+static void __big_shl(__msg_big_t *a, int32_t bits)
 {
+    uint8_t words = (uint8_t)(bits / 32), sh = bits % 32;
+    int16_t i;
 
-    if(!__str_buff.buff.s || !__str_buff.buff.len) return 0;
-
-    if((__str_buff.p - __str_buff.buff.s) >= __str_buff.buff.len) // return null if position is out of buffer
-        return 0;
-    *__str_buff.p = c;
-    __str_buff.p++;
-    return __str_buff.buff.len - (__str_buff.p - __str_buff.buff.s); // return with the empty spaces
+    if(!a->n || a->n + words >= __BIG_WORDS) return; // zero or doesn't fit (not reached with doubles)
+    a->w[a->n + words] = sh ? a->w[a->n - 1] >> (32 - sh) : 0;
+    for(i = a->n - 1; i > 0; i--) {
+        a->w[i + words] = sh ? (a->w[i] << sh) | (a->w[i - 1] >> (32 - sh)) : a->w[i];
+    }
+    a->w[words] = a->w[0] << sh;
+    for(i = 0; i < words; i++) a->w[i] = 0;
+    a->n += words + (a->w[a->n + words] != 0);
 }
 
 /**
- * @brief Putchar interface for other functions
+ * @brief Compare big integers
  * 
- * @param c char
+ * @param a big integer
+ * @param b big integer
+ * @return int8_t -1, 0 or 1 if a is less, equal or greater than b
  */
-static void __msg_putc(char c)
+static int8_t __big_cmp(const __msg_big_t *a, const __msg_big_t *b)
 {
-    if (__redir_outp_to_buff) { // if output is redirected, use the internal string buffer
-        __msg_putc_to_buff(c);
-    } else {
-        __putc(c);
+    int16_t i;
+
+    if(a->n != b->n) return a->n > b->n ? 1 : -1;
+    for(i = a->n - 1; i >= 0; i--) {
+        if(a->w[i] != b->w[i]) return a->w[i] > b->w[i] ? 1 : -1;
     }
+    return 0;
 }
 
 /**
- * @brief Print integer
+ * @brief Sum of big integers
  * 
- * @param i integer value
+ * @param res result
+ * @param a big integer
+ * @param b big integer
  */
-static void __msg_print_int(int i)
+static void __big_sum(__msg_big_t *res, const __msg_big_t *a, const __msg_big_t *b)
 {
-    // int8_t sign = i < 0 ? -1: 1;
-    unsigned val = i < 0 ? ~i + 1 : i;
-                                  // 4294967295   65535
-    unsigned div = sizeof(int) > 2 ? 1000000000UL : 10000UL;
-    uint8_t dig;
-    uint8_t first_dig = 0;
+    uint64_t c = 0;
+    uint8_t i, n = a->n > b->n ? a->n : b->n;
 
-    if(!i) {
-        __msg_putc('0');
-        return;
+    for(i = 0; i < n; i++) {
+        c += (uint64_t)(i < a->n ? a->w[i] : 0) + (i < b->n ? b->w[i] : 0);
+        res->w[i] = (uint32_t)c;
+        c >>= 32;
     }
-    if(i < 0) __msg_putc('-');
-    while(div) {
-        dig = 0;
-        while(val >= div) {
-            val -= div;
-            dig += 1;
-        }
-        div /= 10;
-        if(!first_dig && dig) {
-            first_dig = 1;
-        }
-        if(first_dig) __msg_putc('0' + dig);
-    }
-    
+    res->n = n;
+    if(c && n < __BIG_WORDS) res->w[res->n++] = (uint32_t)c;
 }
 
 /**
- * @brief Print float
+ * @brief Subtract big integer
  * 
- * @param f float value
- * @param prec precision of printing
+ * @param a big integer, result (not less than b)
+ * @param b subtracted big integer
  */
-static void __msg_print_float(float f, uint8_t prec)
+static void __big_sub(__msg_big_t *a, const __msg_big_t *b)
 {
-    int i_part = (int)f;
-    float f_part = f < 0 ? (f - (float)i_part) * -1  : (f - (float)i_part);
-    unsigned mul = 1;
-    uint8_t j;
-    for(j = 0; j < prec; j++ ) mul *= 10;
-    __msg_print_int(i_part);
-    __msg_putc('.');
-    __msg_print_int((unsigned)(f_part * mul));
-}
+    uint64_t c = 0;
+    uint8_t i;
 
+    for(i = 0; i < b->n || (c && i < a->n); i++) {
+        c = (uint64_t)a->w[i] - (i < b->n ? b->w[i] : 0) - c;
+        a->w[i] = (uint32_t)c;
+        c = (c >> 32) & 1; // borrow
+    }
+    while(a->n && !a->w[a->n - 1]) a->n--;
+}
 
 /**
- * @brief Print string
- * 
- * @param str string object
+ * @brief Compare parsed number with the midpoint of a double and the next one
+ * The midpoint is (2 * mantissa + 1) * 2^(exponent - 1), the scaling is moved to the other side
+ * if the exponent is negative, so both sides are integers
+ * @param num number (decimal exponent is in the range of doubles)
+ * @param bits bits of the double (finite)
+ * @return int8_t -1, 0 or 1 if the number is less, equal or greater than the midpoint
  */
-static void __msg_print_str(msg_str_t str)
+static int8_t __num_cmp_half(const __msg_num_t *num, uint64_t bits)
 {
-    msg_size_t i;
-    // if(__msg_putc == NULL) { //if function pointer is NULL, return
-    //     return;
-    // }
-    for(i = 0; i < str.len; __msg_putc(*(str.s + i)), i++);
-}
+    __msg_big_t a, b;
+    uint64_t m = bits & ((1ULL << 52) - 1);
+    int32_t e = (int32_t)(bits >> 52);
 
+    if(e) m |= 1ULL << 52;
+    else e = 1; // subnormal
+    e -= 1075 + 1;
 
-/**
- * @brief print message
- * 
- * @param msg 
- */
-static void __msg_print(msg_t msg)
-{
-    __msg_putc(__CTRL_MSG_FLAG);
-    __msg_print_str(msg.id);
-    __msg_putc(__CTRL_START_MSG);
-    __msg_print_str(msg.content);
-    __msg_putc(__CTRL_STOP_MSG);
+    __big_set(&a, num->m);
+    __big_set(&b, 2 * m + 1);
+    if(num->exp >= 0) __big_mul_pow10(&a, num->exp);
+    else __big_mul_pow10(&b, -num->exp);
+    if(e >= 0) __big_shl(&b, e);
+    else __big_shl(&a, -e);
+    return __big_cmp(&a, &b);
 }
 
 /**
- * @brief Create string handler and set the basic functions
- * 
- * @param putc expected print function, set to NULL if you don't need the print feature
- * @return msg_string_hnd_t handler
+ * @brief Convert parsed number to double bits beyond the power table
+ * The value is scaled in more steps (every step can add 0.5 ulp error), then it's corrected by exact
+ * comparisons with the midpoints of the neighbours. Dropped digits are handled as a value above the mantissa
+ * @param num number (mantissa isn't zero)
+ * @return uint64_t bits of the double (whitout sign)
  */
-msg_hnd_t msg_hnd_create(int (*putc)(char))
+static uint64_t __num_to_bits_big(const __msg_num_t *num)
 {
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    union {
+        double   d;
+        uint64_t u;
+    } res;
+    int32_t e = num->exp;
+    int8_t c;
 
-    msg_hnd_t hnd;
-
-    // init string buff
-    __str_buff.p = __str_buff.buff.s = NULL;
-    __str_buff.buff.len = 0;
+    if(e > 309) return __DOUBLE_INF_BITS; // at least 10^310
+    if(e < -343) return 0; // less than the half of the smallest subnormal (m < 2 * 10^19)
 
-    hnd.putc = __putc = putc;            // init putchar
+    res.d = (double)num->m;
+    while(e > 22) {
+        res.d *= 1e22;
+        e -= 22;
+    }
+    while(e < -22) {
+        res.d /= 1e22;
+        e += 22;
+    }
+    res.d = e < 0 ? res.d / pow10[-e] : res.d * pow10[e];
 
-    //features
-    hnd.print_msg         = __msg_print;
-    hnd.print_str         = __msg_print_str;
-    hnd.print_int         = __msg_print_int;
-    hnd.print_float       = __msg_print_float;
-    hnd.enable_buff       = __msg_enable_buff;
-    hnd.disable_buff      = __msg_disable_buff;
-    hnd.init_str_buff     = __msg_init_str_buff;
-    hnd.reset_str_buff    = __msg_reset_str_buff;
-    hnd.print_wrapper_msg = __msg_wrapper_print_msg;
-    
-    return hnd;
+    for(;;) { // one step to the nearest (even) double until the number is between the midpoints
+        if(res.u < __DOUBLE_INF_BITS) {
+            c = __num_cmp_half(num, res.u);
+            if(c > 0 || (c == 0 && (num->trunc || (res.u & 1)))) {
+                res.u++;
+                continue;
+            }
+        }
+        if(res.u > 0) {
+            c = __num_cmp_half(num, res.u - 1);
+            if(c < 0 || (c == 0 && !num->trunc && (res.u & 1))) {
+                res.u--;
+                continue;
+            }
+        }
+        return res.u;
+    }
 }
 
 /**
- * @brief Defining the quotation mark. Default is ", if there is an occurance of ", ' will be used
- * 
- * @param str string object
- * @return char quotion mark
+ * @brief Convert parsed number to double
+ * Clinger's fast path is used if the mantissa and the power of ten are exact doubles,
+ * Eisel-Lemire algorithm in the range of the power table, big integer comparisons beyond it
+ * @param num number
+ * @return double result
  */
-static inline char __define_qmark(msg_str_t str)
+static double __num_to_double(const __msg_num_t *num)
 {
-    char *p = str.s;
-    while(__is_p_in_str(str, p) && *p) {
-        switch(*p) {
-            case '"' :  return '\'';
-            case '\'' : return '"';
-            default: break;
-        }
-        p++;
+    static const __msg_bin_fmt_t fmt = {52, -1023, 0x7FF, -4, 23};
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    union {
+        double   d;
+        uint64_t u;
+    } res;
+    int32_t e = num->exp;
+
+    if(!num->trunc && num->m <= (1ULL << 53) && e >= -22 && e <= 22) {
+        res.d = (double)num->m;
+        res.d = e < 0 ? res.d / pow10[-e] : res.d * pow10[e];
+    } else if(!__num_to_bits(&fmt, num, &res.u)) {
+        res.u = __num_to_bits_big(num);
     }
-    return '"'; // default
+    return num->neg ? -res.d : res.d;
 }
 
-
-/////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                         //
-//                                     Wrapper functions                                   //
-//                                                                                         //
-/////////////////////////////////////////////////////////////////////////////////////////////
-#if MCU_MSG_USE_WRAPPER
-
 /**
- * @brief Printing key and equal sign
+ * @brief Convert parsed number to float
  * 
+ * @param num number
+ * @return float result
  */
-#define __print_key_equ(key_str)        __msg_putc(__CTRL_KEY_FLAG); \
-                                        __msg_print_str(key_str);    \
-                                        __msg_putc(__CTRL_KEY_EQU)
+static float __num_to_float(const __msg_num_t *num)
+{
+    static const __msg_bin_fmt_t fmt = {23, -127, 0xFF, -17, 10};
+    static const float pow10f[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+    union {
+        float    f;
+        uint32_t u;
+    } res;
+    uint64_t bits;
+
+    if(!num->trunc && num->m <= (1UL << 24) && num->exp >= -10 && num->exp <= 10) {
+        res.f = (float)num->m;
+        res.f = num->exp < 0 ? res.f / pow10f[-num->exp] : res.f * pow10f[num->exp];
+    } else if(__num_to_bits(&fmt, num, &bits)) {
+        res.u = (uint32_t)bits;
+    } else {
+        res.f = (float)__num_to_double(num);
+        return res.f; // signed
+    }
+    return num->neg ? -res.f : res.f;
+}
+
 /**
- * @brief Print message start chars with flag and start char and message id
+ * @brief Convert integer value string
  * 
+ * @param res_val result integer pointer
+ * @param sval value start pointer and the length until the end of the container
+ * @return uint8_t 0 if there is an error, MSG_NUM_OVERFLOW or count of digits
  */
-#define __print_msg_start(msg)          __msg_putc(__CTRL_MSG_FLAG); \
-                                        __msg_print_str(msg.id);     \
-                                        __msg_putc(__CTRL_START_MSG)
-
+static uint8_t __str_to_int(int *res_val, msg_str_t sval)
+{
+    __msg_num_t num;
+    uint8_t res = __str_to_num(&num, sval, 0);
 
+    if(!res) return 0;
+    if(num.trunc || num.exp || num.m > (num.neg ? (uint64_t)INT_MAX + 1 : (uint64_t)INT_MAX)) // exp is set by the dropped digits
+        return MSG_NUM_OVERFLOW;
+    
+    *res_val = (num.neg && num.m) ? -(int)(num.m - 1) - 1 : (int)num.m;
+    return res;
+}
 
 /**
- * @brief Print object start with flag start char and object id
+ * @brief Convert 64 bit integer value string
  * 
+ * @param res_val result integer pointer
+ * @param sval value start pointer and the length until the end of the container
+ * @return uint8_t 0 if there is an error, MSG_NUM_OVERFLOW or count of digits
  */
-#define __print_obj_start(obj)          __msg_putc(__CTRL_OBJ_FLAG);  \
-                                        __msg_print_str(obj.id);      \
-                                        __msg_putc(__CTRL_START_OBJ)  
+static uint8_t __str_to_int64(int64_t *res_val, msg_str_t sval)
+{
+    __msg_num_t num;
+    uint8_t res = __str_to_num(&num, sval, 0);
+
+    if(!res) return 0;
+    if(num.trunc || num.exp || num.m > (num.neg ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX)) // exp is set by the dropped digits
+        return MSG_NUM_OVERFLOW;
+    
+    *res_val = (num.neg && num.m) ? -(int64_t)(num.m - 1) - 1 : (int64_t)num.m;
+    return res;
+}
 
 /**
- * @brief Print object wrapper
+ * @brief Convert unsigned 64 bit integer value string
  * 
- * @param obj object wrapper to print
+ * @param res_val result integer pointer
+ * @param sval value start pointer and the length until the end of the container
+ * @return uint8_t 0 if there is an error, MSG_NUM_OVERFLOW or count of digits
  */
-static void __msg_wrapper_print_obj(msg_wrap_obj_t obj)
+static uint8_t __str_to_uint64(uint64_t *res_val, msg_str_t sval)
 {
-    msg_wrap_str_t *sp;
-    msg_wrap_int_t *ip;
-    msg_wrap_float_t *fp;
-    char qmark;
-
-    __print_obj_start(obj);
-    
+    __msg_num_t num;
+    uint8_t res = __str_to_num(&num, sval, 0);
 
-    // print integers
+    if(!res) return 0;
+    if(num.trunc || num.exp || (num.neg && num.m)) // exp is set by the dropped digits
+        return MSG_NUM_OVERFLOW;
     
-    for(ip = obj.int_queue; ip != NULL; ip = ip->next) {
-        __print_key_equ(ip->id);
-        __msg_print_int(ip->val);
-        if(ip->next != NULL) __msg_putc(__CTRL_KEY_SEP);
-    }
+    *res_val = num.m;
+    return res;
+}
 
-    // print floats
-    if(obj.float_queue != NULL && obj.int_queue != NULL) __msg_putc(__CTRL_KEY_SEP);
-    for(fp = obj.float_queue; fp != NULL; fp = fp->next) {
-        __print_key_equ(fp->id);
-        __msg_print_float(fp->val, fp->prec);
-        if(fp->next != NULL) __msg_putc(__CTRL_KEY_SEP);
-    }
-    // print strings
-    if(obj.string_queue != NULL && obj.float_queue != NULL) __msg_putc(__CTRL_KEY_SEP);
-    for(sp = obj.string_queue; sp != NULL; sp = sp->next) {
-        __print_key_equ(sp->id);
-        qmark = __define_qmark(sp->content);
-        __msg_putc(qmark);
-        __msg_print_str(sp->content);
-        __msg_putc(qmark);
-        if(sp->next != NULL) __msg_putc(__CTRL_KEY_SEP);
-    }
+/**
+ * @brief Convert float value string
+ * 
+ * @param res_val result float pointer
+ * @param sval value start pointer and the length until the end of the container
+ * @return uint8_t 0 if there is an error, MSG_NUM_OVERFLOW or count of digits + '.' separator
+ */
+static uint8_t __str_to_float(float *res_val, msg_str_t sval)
+{
+    __msg_num_t num;
+    uint8_t res = __str_to_num(&num, sval, 1);
+    float f;
 
-    __msg_putc(__CTRL_STOP_OBJ);
+    if(!res) return 0;
+    f = __num_to_float(&num);
+    if(f - f != 0) return MSG_NUM_OVERFLOW; // infinite
+    
+    *res_val = f;
+    return res;
 }
 
-
 /**
- * @brief Print command wrapper
+ * @brief Convert double value string
  * 
- * @param cmd command wrapper to print
+ * @param res_val result double pointer
+ * @param sval value start pointer and the length until the end of the container
+ * @return uint8_t 0 if there is an error, MSG_NUM_OVERFLOW or count of digits + '.' separator
  */
-static inline void __msg_wrapper_print_cmd(msg_wrap_cmd_t cmd)
+static uint8_t __str_to_double(double *res_val, msg_str_t sval)
 {
-    if(cmd.cmd.s != NULL) {
-        __msg_putc(__CTRL_CMD_START_FLAG);
-        __msg_print_str(cmd.cmd);
-        __msg_putc(__CTRL_CMD_STOP_FLAG);
-    }
-}
+    __msg_num_t num;
+    uint8_t res = __str_to_num(&num, sval, 1);
+    double d;
 
+    if(!res) return 0;
+    d = __num_to_double(&num);
+    if(d - d != 0) return MSG_NUM_OVERFLOW; // infinite
+    
+    *res_val = d;
+    return res;
+}
 
 /**
- * @brief Print message wrapper
+ * @brief Get the string content between the quotation marks
  * 
- * @param msg message wrapper to print
+ * @param sval value start pointer and the length until the end of the container
+ * @return msg_str_t string content or destroyed string if the value is not a string
  */
-static void __msg_wrapper_print_msg(msg_wrap_t msg)
+static msg_str_t __str_unquote(msg_str_t sval)
 {
-    msg_wrap_obj_t *pobj;
-    msg_wrap_cmd_t *pcmd;
+    msg_str_t res;
+    char qmark = *sval.s;
+    char *p;
 
-    if(msg.id.s == NULL) // return if message id is not set
-        return;
-    __print_msg_start(msg);
-    
-    /*Print command queue*/
-    pcmd = msg.cmd_queue;
-    while(pcmd != NULL) {
-        __msg_wrapper_print_cmd(*pcmd);
-        pcmd = pcmd->next;   
+    if(qmark != '\'' && qmark != '"') { // qmark not found, this is not a string
+        msg_destroy_str(&res);
+        return res;
     }
-    /*Print object queue*/
-    pobj = msg.obj_queue;
-    while(pobj != NULL) {
-        __msg_wrapper_print_obj(*pobj);
-        pobj = pobj->next;  
+
+    p = res.s = sval.s + 1;
+    while(__is_p_in_str(sval, p) && *p != qmark) { // calc len
+        p++;
     }
-    __msg_putc(__CTRL_STOP_MSG);
+    res.len = p - res.s;
+    return res;
 }
 
-
-/*Destroy message wrappe*/
-void msg_wrap_destroy(msg_wrap_t *msg)
+/**
+ * @brief Extend the value found by __find_val until the end of the object content
+ * 
+ * @param obj object
+ * @param sval value location
+ * @return msg_str_t value start pointer with the remaining length of the object content
+ */
+static inline msg_str_t __val_bound(msg_obj_t obj, msg_str_t sval)
 {
-    msg_destroy_str(&msg->id);
-    msg->cmd_queue = NULL;
-    msg->obj_queue = NULL;
+    sval.len = obj.content.len - (sval.s - obj.content.s);
+    return sval;
 }
 
-/*Destroy object wrapper*/
-void msg_wrap_destroy_obj(msg_wrap_obj_t *obj)
+/*
+Get primitive integer value from object by key
+Return 0 if there is an error or count of digits
+*/
+uint8_t msg_parser_get_int(int *res_val, msg_obj_t obj, char *key)
 {
-    msg_destroy_str(&obj->id);
-    obj->int_queue = NULL;
-    obj->float_queue = NULL;
-    obj->string_queue = NULL;
-    obj->next = NULL;
-}
+    msg_str_t sval = __find_val(obj, key);
 
+    if(sval.s == NULL)  //key nout found
+        return 0;
 
-/*destroy command wrapper*/
-void msg_wrap_destroy_cmd(msg_wrap_cmd_t *cmd)
-{
-    msg_destroy_str(&cmd->cmd);
-    cmd->next = NULL;
+    return __str_to_int(res_val, __val_bound(obj, sval));
 }
 
-
-/*destroy string wrapper*/
-void msg_wrap_destroy_str(msg_wrap_str_t *str)
+/*
+Get primitive float value from object by key
+Return 0 if key not found or digit count
+*/
+uint8_t msg_parser_get_float(float *res_val, msg_obj_t obj, char *key)
 {
-    msg_destroy_str(&str->id);
-    msg_destroy_str(&str->content);
-    str->next = NULL;
-}
+    msg_str_t sval = __find_val(obj, key);
 
+    if(sval.s == NULL)  //key nout found
+        return 0;
 
-/*destroy integer wrapper*/
-void msg_wrap_destroy_int(msg_wrap_int_t *i)
-{
-    msg_destroy_str(&i->id);
-    i->val = 0;
-    i->next = NULL;
+    return __str_to_float(res_val, __val_bound(obj, sval));
 }
 
-/*Destroy float wrapper*/
-void msg_wrap_destroy_float(msg_wrap_float_t *f)
+
+/*
+Get double value from object by key
+Return 0 if key not found, MSG_NUM_OVERFLOW or digit count
+*/
+uint8_t msg_parser_get_double(double *res_val, msg_obj_t obj, char *key)
 {
-    msg_destroy_str(&f->id);
-    f->val = 0.0;
-    f->next = NULL;
-    f->prec = 0;
-}
+    msg_str_t sval = __find_val(obj, key);
 
+    if(sval.s == NULL)  //key nout found
+        return 0;
 
-/*Create message wrapper*/
-msg_wrap_t msg_wrapper_create_msg(char *msg_id)
-{
-    msg_wrap_t res;
-    res.id = msg_init_string(msg_id);
-    res.cmd_queue = NULL;
-    res.obj_queue = NULL;
-    return res;
+    return __str_to_double(res_val, __val_bound(obj, sval));
 }
 
-/*Create command wrapper*/
-msg_wrap_cmd_t msg_wrapper_create_cmd(char *cmd)
+/*
+Get 64 bit integer value from object by key
+Return 0 if key not found, MSG_NUM_OVERFLOW or digit count
+*/
+uint8_t msg_parser_get_int64(int64_t *res_val, msg_obj_t obj, char *key)
 {
-    msg_wrap_cmd_t res;
-    res.cmd = msg_init_string(cmd);
-    res.next = NULL;
-    return res;
+    msg_str_t sval = __find_val(obj, key);
+
+    if(sval.s == NULL)  //key nout found
+        return 0;
+
+    return __str_to_int64(res_val, __val_bound(obj, sval));
 }
 
-/*Create object wrapper*/
-msg_wrap_obj_t msg_wrapper_create_obj(char *obj_id)
+/*
+Get unsigned 64 bit integer value from object by key
+Return 0 if key not found, MSG_NUM_OVERFLOW or digit count
+*/
+uint8_t msg_parser_get_uint64(uint64_t *res_val, msg_obj_t obj, char *key)
 {
-    msg_wrap_obj_t res;
-    res.id = msg_init_string(obj_id);
-    res.int_queue = NULL;
-    res.float_queue = NULL;
-    res.string_queue = NULL;
-    res.next = NULL;
-    return res;
+    msg_str_t sval = __find_val(obj, key);
+
+    if(sval.s == NULL)  //key nout found
+        return 0;
+
+    return __str_to_uint64(res_val, __val_bound(obj, sval));
 }
 
-/*Create string wrapper*/
-msg_wrap_str_t msg_wrapper_create_str(char *id, char *content)
+/*
+Get primitive string object from object by key
+return with string object which is destroyd if there is any error 
+*/
+msg_str_t msg_parser_get_str(msg_obj_t obj, char *key)
 {
-    msg_wrap_str_t res;
-    res.id = msg_init_string(id);
-    res.content = msg_init_string(content);
-    res.next = NULL;
-    return res;
+    msg_str_t res = __find_val(obj, key);
+
+    if(res.s == NULL) {
+        msg_destroy_str(&res);
+        return res;
+    }
+
+    return __str_unquote(__val_bound(obj, res));
 }
 
-/*Create int wrapper*/
-msg_wrap_int_t msg_wrapper_create_int(char *id, int val)
+/**
+ * @brief Restart scanner at a message flag
+ * 
+ * @param sc scanner pointer
+ */
+static inline void __scan_restart(msg_scan_t *sc)
 {
-    msg_wrap_int_t res;
-    res.id = msg_init_string(id);
-    res.val = val;
-    res.next = NULL;
-    return res;
+    sc->state = MSG_SCAN_ID;
+    sc->id_len = 0;
+    sc->depth = 0;
 }
 
-/*create float wrapper*/
-msg_wrap_float_t msg_wrapper_create_float(char *id, float val, uint8_t prec)
+/**
+ * @brief Step the message scanner with the next char
+ * A message flag outside of internal strings always restarts the scanner (resync after lost chars)
+ * @param sc scanner pointer
+ * @param c next char
+ * @return uint8_t new state
+ */
+static uint8_t __scan_step(msg_scan_t *sc, char c)
+{
+    switch(sc->state) {
+        case MSG_SCAN_CONTENT:
+            switch(c) {
+                case '\'':
+                case '"':
+                    sc->qmark = c;
+                    sc->state = MSG_SCAN_STR;
+                break;
+                case __CTRL_START_OBJ:
+                    sc->depth++;
+                break;
+                case __CTRL_STOP_OBJ:
+                    if(sc->depth) sc->depth--;
+                break;
+                case __CTRL_STOP_MSG: // unclosed object means broken message
+                    sc->state = sc->depth ? MSG_SCAN_IDLE : MSG_SCAN_READY;
+                break;
+                case __CTRL_MSG_FLAG:
+                    __scan_restart(sc);
+                break;
+                default:
+                break;
+            }
+        break;
+
+        case MSG_SCAN_STR:
+            if(c == sc->qmark) sc->state = MSG_SCAN_CONTENT;
+        break;
+
+        case MSG_SCAN_ID:
+            if(__is_valid_id_char(c, sc->id_len)) {
+                sc->id_len++;
+                break;
+            }
+            if(sc->id_len && c == __CTRL_START_MSG) {
+                sc->state = MSG_SCAN_CONTENT;
+            } else if(sc->id_len && __is_whitespace(c)) {
+                sc->state = MSG_SCAN_START;
+            } else if(c == __CTRL_MSG_FLAG) {
+                __scan_restart(sc);
+            } else {
+                sc->state = MSG_SCAN_IDLE;
+            }
+        break;
+
+        case MSG_SCAN_START:
+            if(c == __CTRL_START_MSG) {
+                sc->state = MSG_SCAN_CONTENT;
+            } else if(c == __CTRL_MSG_FLAG) {
+                __scan_restart(sc);
+            } else if(!__is_whitespace(c)) {
+                sc->state = MSG_SCAN_IDLE;
+            }
+        break;
+
+        default: // idle or ready
+            if(c == __CTRL_MSG_FLAG) {
+                __scan_restart(sc);
+            } else {
+                sc->state = MSG_SCAN_IDLE;
+            }
+        break;
+    }
+    return sc->state;
+}
+
+/*Init stream parser*/
+void msg_stream_init(msg_stream_t *st, char *buff, msg_size_t size)
+{
+    st->scan.state = MSG_SCAN_IDLE;
+    st->scan.qmark = 0;
+    st->scan.depth = 0;
+    st->scan.id_len = 0;
+    st->buff.s = buff;
+    st->buff.len = size;
+    st->pos = 0;
+    st->content = 0;
+    msg_destroy(&st->msg);
+}
+
+/*Feed stream parser*/
+msg_size_t msg_stream_feed(msg_stream_t *st, char *chunk, msg_size_t len)
+{
+    msg_size_t i;
+    uint8_t prev;
+
+    if(msg_stream_ready(st)) { // previous message was handled
+        st->scan.state = MSG_SCAN_IDLE;
+        st->pos = 0;
+        msg_destroy(&st->msg);
+    }
+
+    for(i = 0; i < len; i++) {
+        prev = st->scan.state;
+        switch(__scan_step(&st->scan, chunk[i])) {
+            case MSG_SCAN_IDLE:
+                st->pos = 0;
+                continue;
+            case MSG_SCAN_ID:
+                if(!st->scan.id_len) st->pos = 0; // new message flag
+            break;
+            case MSG_SCAN_CONTENT:
+                if(prev == MSG_SCAN_ID || prev == MSG_SCAN_START) st->content = st->pos + 1;
+            break;
+            default:
+            break;
+        }
+
+        if(st->pos >= st->buff.len) { // message doesn't fit, drop it
+            st->scan.state = MSG_SCAN_IDLE;
+            st->pos = 0;
+            continue;
+        }
+        st->buff.s[st->pos++] = chunk[i];
+
+        if(msg_stream_ready(st)) {
+            st->msg.id.s = st->buff.s + 1;
+            st->msg.id.len = st->scan.id_len;
+            st->msg.content.s = st->buff.s + st->content;
+            st->msg.content.len = st->pos - st->content - 1;
+            return i + 1;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Compare id string with zero terminated keyword
+ * 
+ * @param id id string
+ * @param keyword keyword
+ * @return uint8_t comparison result
+ */
+static inline uint8_t __keyword_eq(msg_str_t id, char *keyword)
+{
+    msg_size_t i;
+    for(i = 0; i < id.len; i++) {
+        if(id.s[i] != keyword[i]) return 0; // keyword terminator is also a mismatch
+    }
+    return keyword[i] == '\0';
+}
+
+/**
+ * @brief Read the next object, command or key token from the string
+ * Object content is not skipped, the next call continues with the tokens inside of the object
+ * @param str source string
+ * @param p position to continue from
+ * @param tok result token
+ * @return char* position for the next call or NULL if there is no more token
+ */
+static char *__next_token(msg_str_t str, char *p, msg_index_rec_t *tok)
+{
+    char *q;
+    char stopc;
+
+    while(__is_p_in_str(str, p) && *p) {
+        switch(*p) {
+            case '\'':
+            case '"':
+                p = __skip_internal_str(str, p); //skip internal strings
+                continue;
+            case __CTRL_OBJ_FLAG:
+                tok->kind = MSG_TOK_OBJ;
+                stopc = __CTRL_START_OBJ;
+            break;
+            case __CTRL_CMD_START_FLAG:
+                tok->kind = MSG_TOK_CMD;
+                stopc = __CTRL_CMD_STOP_FLAG;
+            break;
+            case __CTRL_KEY_FLAG:
+                tok->kind = MSG_TOK_KEY;
+                stopc = __CTRL_KEY_EQU;
+            break;
+            default:
+                p++;
+                continue;
+        }
+
+        tok->id.s = q = p + 1;
+        while(__is_p_in_str(str, q) && __is_valid_id_char(*q, q - tok->id.s)) q++;
+        tok->id.len = q - tok->id.s;
+        while(__is_p_in_str(str, q) && __is_whitespace(*q)) q++; //skip spaces
+        if(!tok->id.len || !__is_p_in_str(str, q) || *q != stopc) { // not a token, continue from the last checked char
+            p = q;
+            continue;
+        }
+
+        tok->n = 0;
+        tok->val.s = ++q;
+        switch(tok->kind) {
+            case MSG_TOK_OBJ: // content until the stop char outside of internal strings
+                while(__is_p_in_str(str, q) && *q != __CTRL_STOP_OBJ) {
+                    q = (*q == '\'' || *q == '"') ? __skip_internal_str(str, q) : q + 1;
+                }
+                tok->val.len = q - tok->val.s;
+                return tok->val.s;
+
+            case MSG_TOK_CMD:
+                tok->val.len = 0;
+                return q;
+
+            default: // key value until whitespace or control char, strings with qmarks
+                while(__is_p_in_str(str, q) && __is_whitespace(*q)) q++;
+                tok->val.s = q;
+                if(__is_p_in_str(str, q) && (*q == '\'' || *q == '"')) {
+                    q = __skip_internal_str(str, q);
+                } else {
+                    while(__is_p_in_str(str, q) && !__is_whitespace(*q) && !__is_ctrl_char(*q)) q++;
+                }
+                tok->val.len = q - tok->val.s;
+                return q;
+        }
+    }
+    return NULL;
+}
+
+/*Get more values from object with one scan*/
+uint32_t msg_parser_get_many(msg_obj_t obj, const msg_key_desc_t *descs, uint8_t n)
+{
+    msg_index_rec_t tok;
+    uint32_t found = 0, done = 0;
+    uint32_t all = n >= 32 ? 0xFFFFFFFFUL : ((uint32_t)1 << n) - 1;
+    char *p = obj.content.s;
+    uint8_t i;
+
+    if(p == NULL) return 0;
+
+    while(done != all && (p = __next_token(obj.content, p, &tok)) != NULL) {
+        for(i = 0; i < n && i < 32; i++) {
+            if((done & ((uint32_t)1 << i)) || (tok.kind == MSG_TOK_CMD) != (descs[i].type == MSG_KEY_CMD) ||
+                                                                    !__keyword_eq(tok.id, descs[i].key)) {
+                continue;
+            }
+            done |= (uint32_t)1 << i; // first occurance is used, even if the conversion fails
+            switch(descs[i].type) {
+                case MSG_KEY_INT:
+                    if(tok.val.len && msg_num_ok(__str_to_int((int *)descs[i].dst, tok.val))) found |= (uint32_t)1 << i;
+                break;
+                case MSG_KEY_FLOAT:
+                    if(tok.val.len && msg_num_ok(__str_to_float((float *)descs[i].dst, tok.val))) found |= (uint32_t)1 << i;
+                break;
+                case MSG_KEY_STR:
+                    *(msg_str_t *)descs[i].dst = msg_val_to_str(tok.val); // empty value is not found, like by msg_parser_get_str
+                    if(((msg_str_t *)descs[i].dst)->s != NULL) found |= (uint32_t)1 << i;
+                break;
+                case MSG_KEY_CMD:
+                    ((msg_cmd_t *)descs[i].dst)->cmd = tok.id;
+                    found |= (uint32_t)1 << i;
+                break;
+                default:
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Read the next token of the kind, contents of objects are skipped
+ * 
+ * @param str source string
+ * @param cursor position, it's set after the token or to the end
+ * @param kind token kind (MSG_TOK_...)
+ * @return msg_index_rec_t token, kind is MSG_TOK_NONE if there is no more
+ */
+static msg_index_rec_t __next_kind(msg_str_t str, msg_size_t *cursor, uint8_t kind)
+{
+    msg_index_rec_t tok;
+    char *p = (str.s != NULL && *cursor < str.len) ? str.s + *cursor : NULL;
+
+    while(p != NULL && (p = __next_token(str, p, &tok)) != NULL) {
+        if(tok.kind == MSG_TOK_OBJ) p = tok.val.s + tok.val.len; // continue after the object
+        if(tok.kind == kind) {
+            *cursor = p - str.s;
+            return tok;
+        }
+    }
+    *cursor = str.len;
+    tok.kind = MSG_TOK_NONE;
+    return tok;
+}
+
+/*Get next object of message*/
+msg_obj_t msg_parser_next_obj(msg_t msg, msg_size_t *cursor)
+{
+    msg_index_rec_t tok = __next_kind(msg.content, cursor, MSG_TOK_OBJ);
+    msg_obj_t res;
+
+    if(tok.kind == MSG_TOK_NONE) {
+        msg_destroy_obj(&res);
+        return res;
+    }
+    res.id = tok.id;
+    res.content = tok.val;
+    return res;
+}
+
+/*Get next command of message*/
+msg_cmd_t msg_parser_next_cmd(msg_t msg, msg_size_t *cursor)
+{
+    msg_index_rec_t tok = __next_kind(msg.content, cursor, MSG_TOK_CMD);
+    msg_cmd_t res;
+
+    if(tok.kind == MSG_TOK_NONE) {
+        msg_destroy_cmd(&res);
+        return res;
+    }
+    res.cmd = tok.id;
+    return res;
+}
+
+/*Get next key of object*/
+msg_str_t msg_parser_next_key(msg_obj_t obj, msg_size_t *cursor, msg_str_t *val)
+{
+    msg_index_rec_t tok = __next_kind(obj.content, cursor, MSG_TOK_KEY);
+
+    if(tok.kind == MSG_TOK_NONE) {
+        msg_destroy_str(val);
+        msg_destroy_str(&tok.id);
+        return tok.id;
+    }
+    *val = tok.val;
+    return tok.id;
+}
+
+/*Convert raw value to int*/
+uint8_t msg_val_to_int(int *res_val, msg_str_t val)
+{
+    return val.s != NULL ? __str_to_int(res_val, val) : 0;
+}
+
+/*Convert raw value to int64*/
+uint8_t msg_val_to_int64(int64_t *res_val, msg_str_t val)
+{
+    return val.s != NULL ? __str_to_int64(res_val, val) : 0;
+}
+
+/*Convert raw value to uint64*/
+uint8_t msg_val_to_uint64(uint64_t *res_val, msg_str_t val)
+{
+    return val.s != NULL ? __str_to_uint64(res_val, val) : 0;
+}
+
+/*Convert raw value to float*/
+uint8_t msg_val_to_float(float *res_val, msg_str_t val)
+{
+    return val.s != NULL ? __str_to_float(res_val, val) : 0;
+}
+
+/*Convert raw value to double*/
+uint8_t msg_val_to_double(double *res_val, msg_str_t val)
+{
+    return val.s != NULL ? __str_to_double(res_val, val) : 0;
+}
+
+/*Convert raw value to string (remove qmarks)*/
+msg_str_t msg_val_to_str(msg_str_t val)
+{
+    if(val.s == NULL || !val.len) {
+        msg_destroy_str(&val);
+        return val;
+    }
+    return __str_unquote(val);
+}
+
+/*Build structural index*/
+msg_index_t msg_index_build(msg_t msg, msg_index_rec_t *rec, msg_size_t size)
+{
+    msg_index_t idx;
+    msg_index_rec_t tok;
+    msg_size_t obj = MSG_INDEX_NONE; // record of the current object
+    char *p = msg.content.s;
+
+    idx.msg = msg;
+    idx.rec = rec;
+    idx.cnt = 0;
+    idx.size = size;
+    idx.overflow = 0;
+
+    if(p == NULL) return idx;
+
+    while((p = __next_token(msg.content, p, &tok)) != NULL) {
+        if(idx.cnt >= size) {
+            idx.overflow = 1;
+            break;
+        }
+        if(obj != MSG_INDEX_NONE && !__is_p_in_str(rec[obj].val, tok.id.s)) { // left the object
+            obj = MSG_INDEX_NONE;
+        }
+        if(obj != MSG_INDEX_NONE) {
+            rec[obj].n++;
+        } else if(tok.kind == MSG_TOK_OBJ) {
+            obj = idx.cnt;
+        }
+        rec[idx.cnt++] = tok;
+    }
+    return idx;
+}
+
+/*Get object from index by ID*/
+msg_obj_t msg_index_get_obj(msg_index_t *idx, char *id)
+{
+    msg_obj_t res;
+    msg_size_t i;
+
+    for(i = 0; i < idx->cnt; i += idx->rec[i].n + 1) { // jump over the object content
+        if(idx->rec[i].kind == MSG_TOK_OBJ && __keyword_eq(idx->rec[i].id, id)) {
+            res.id = idx->rec[i].id;
+            res.content = idx->rec[i].val;
+            return res;
+        }
+    }
+    if(idx->overflow) return msg_parser_get_obj(idx->msg, id);
+    msg_destroy_obj(&res);
+    return res;
+}
+
+/*Get command from index by ID*/
+msg_cmd_t msg_index_get_cmd(msg_index_t *idx, char *cmd_id)
+{
+    msg_cmd_t res;
+    msg_size_t i;
+
+    for(i = 0; i < idx->cnt; i++) {
+        if(idx->rec[i].kind == MSG_TOK_CMD && __keyword_eq(idx->rec[i].id, cmd_id)) {
+            res.cmd = idx->rec[i].id;
+            return res;
+        }
+    }
+    if(idx->overflow) return msg_parser_get_cmd(idx->msg, cmd_id);
+    msg_destroy_cmd(&res);
+    return res;
+}
+
+/**
+ * @brief Find the key record of an object in the index
+ * Records are ordered by position, the object record is found with binary search
+ * @param idx index pointer
+ * @param obj object (from index or parser)
+ * @param key key
+ * @return msg_index_rec_t* key record or NULL if not found
+ */
+static msg_index_rec_t *__index_find_key(msg_index_t *idx, msg_obj_t obj, char *key)
+{
+    msg_size_t lo = 0, hi = idx->cnt, mid, i;
+    msg_index_rec_t *o;
+
+    if(obj.content.s == NULL) return NULL;
+
+    while(lo < hi) { // first record after the object content start
+        mid = lo + (hi - lo) / 2;
+        if(idx->rec[mid].id.s < obj.content.s) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if(!lo) return NULL;
+
+    o = &idx->rec[lo - 1];
+    if(o->kind != MSG_TOK_OBJ || o->val.s != obj.content.s) return NULL;
+
+    for(i = 1; i <= o->n; i++) {
+        if(o[i].kind == MSG_TOK_KEY && __keyword_eq(o[i].id, key)) return &o[i];
+    }
+    return NULL;
+}
+
+/*Get integer from index by object and key*/
+uint8_t msg_index_get_int(int *res, msg_index_t *idx, msg_obj_t obj, char *key)
+{
+    msg_index_rec_t *r = __index_find_key(idx, obj, key);
+    if(r == NULL) 
+        return idx->overflow ? msg_parser_get_int(res, obj, key) : 0;
+    return r->val.len ? __str_to_int(res, r->val) : 0;
+}
+
+/*Get float from index by object and key*/
+uint8_t msg_index_get_float(float *res_val, msg_index_t *idx, msg_obj_t obj, char *key)
+{
+    msg_index_rec_t *r = __index_find_key(idx, obj, key);
+    if(r == NULL) 
+        return idx->overflow ? msg_parser_get_float(res_val, obj, key) : 0;
+    return r->val.len ? __str_to_float(res_val, r->val) : 0;
+}
+
+/*Get string from index by object and key*/
+msg_str_t msg_index_get_str(msg_index_t *idx, msg_obj_t obj, char *key)
+{
+    msg_str_t res;
+    msg_index_rec_t *r = __index_find_key(idx, obj, key);
+    if(r == NULL) {
+        if(idx->overflow) return msg_parser_get_str(obj, key);
+        msg_destroy_str(&res);
+        return res;
+    }
+    if(!r->val.len) {
+        msg_destroy_str(&res);
+        return res;
+    }
+    return __str_unquote(r->val);
+}
+
+/*Init context with putchar output*/
+void msg_ctx_init(msg_ctx_t *ctx, int (*putc)(char))
+{
+    ctx->buff.s = ctx->p = NULL;
+    ctx->buff.len = 0;
+    ctx->redir = __OUTP_DEFAULT;
+    ctx->overflow = 0;
+    ctx->cnt = 0;
+    ctx->putc = putc;
+    ctx->sink.write = NULL;
+    ctx->sink.arg = NULL;
+    ctx->stage_len = 0;
+#if MCU_MSG_USE_DICT
+    ctx->dict = NULL;
+#endif
+#if MCU_MSG_USE_IOVEC
+    ctx->iov = NULL;
+    ctx->iov_size = ctx->iov_cnt = 0;
+#endif
+}
+
+/*Init context with span output*/
+void msg_ctx_init_sink(msg_ctx_t *ctx, msg_sink_t sink)
+{
+    msg_ctx_init(ctx, NULL);
+    ctx->sink = sink;
+}
+
+/*Init string buffer of context*/
+void msg_ctx_init_str_buff(msg_ctx_t *ctx, char *buff, msg_size_t buff_size)
+{
+    ctx->buff.len = buff_size;
+    ctx->buff.s = buff;
+    ctx->p = ctx->buff.s;
+    ctx->overflow = 0;
+}
+
+/*Reset string buffer of context*/
+void msg_ctx_reset_str_buff(msg_ctx_t *ctx)
+{
+    ctx->p = ctx->buff.s; //reset pointer (set to the start position)
+    ctx->overflow = 0;
+}
+
+/*Enable buffer redirection*/
+void msg_ctx_enable_buff(msg_ctx_t *ctx)
+{
+    msg_ctx_flush(ctx); // staged output belongs to the previous output
+    ctx->redir = __OUTP_BUFF;
+}
+
+/*Disable buffer redirection*/
+void msg_ctx_disable_buff(msg_ctx_t *ctx)
+{
+    ctx->redir = __OUTP_DEFAULT;
+}
+
+/*Flush staged output*/
+void msg_ctx_flush(msg_ctx_t *ctx)
+{
+    msg_size_t i;
+
+    if(ctx->stage_len == 0) return;
+    if(ctx->sink.write != NULL) {
+        ctx->sink.write(ctx->sink.arg, ctx->stage, ctx->stage_len);
+    } else if(ctx->putc != NULL) {
+        for(i = 0; i < ctx->stage_len; ctx->putc(ctx->stage[i]), i++);
+    }
+    ctx->stage_len = 0;
+}
+
+/**
+ * @brief Enable buffer redirection. This function is in handler
+ * 
+ */
+static void __msg_enable_buff(void)
+{
+    msg_ctx_enable_buff(&__ctx);
+}
+
+/**
+ * @brief Disable buffering and set back the standard output printing
+ * 
+ */
+static void __msg_disable_buff(void)
+{
+    msg_ctx_disable_buff(&__ctx);
+}
+
+/**
+ * @brief Init internal string buffer
+ * 
+ * @param buff buffer pointer by user
+ * @param buff_size buffer size
+ */
+static void __msg_init_str_buff(char *buff, msg_size_t buff_size)
+{
+    msg_ctx_init_str_buff(&__ctx, buff, buff_size);
+}
+
+
+/**
+ * @brief Reset internal string buffer, set the position to first address of buffer
+ * 
+ */
+static void __msg_reset_str_buff(void)
+{
+    msg_ctx_reset_str_buff(&__ctx);
+}
+
+/**
+ * @brief Pass the staged output of the default context to the sink or to putchar
+ * 
+ */
+static void __msg_flush(void)
+{
+    msg_ctx_flush(&__ctx);
+}
+
+/**
+ * @brief Putchar to string buff
+ * 
+ * @param ctx context
+ * @param c character
+ * @return msg_size_t free space in buffer or 0 if there is any error 
+ */
+static msg_size_t __msg_putc_to_buff(msg_ctx_t *ctx, char c)
+{
+
+    if(!ctx->buff.s || !ctx->buff.len) return 0;
+
+    if((ctx->p - ctx->buff.s) >= ctx->buff.len) { // return null if position is out of buffer
+        ctx->overflow = 1;
+        return 0;
+    }
+    *ctx->p = c;
+    ctx->p++;
+    return ctx->buff.len - (ctx->p - ctx->buff.s); // return with the empty spaces
+}
+
+/**
+ * @brief Copy span to string buff
+ * 
+ * @param ctx context
+ * @param p span pointer
+ * @param n span length
+ * @return msg_size_t free space in buffer or 0 if there is any error 
+ */
+static msg_size_t __msg_write_to_buff(msg_ctx_t *ctx, const char *p, msg_size_t n)
+{
+    msg_size_t i, free_len;
+
+    if(!ctx->buff.s || !ctx->buff.len) return 0;
+
+    free_len = ctx->buff.len - (ctx->p - ctx->buff.s);
+    if(n > free_len) { // copy what fits
+        n = free_len;
+        ctx->overflow = 1;
+    }
+    for(i = 0; i < n; i++) ctx->p[i] = p[i];
+    ctx->p += n;
+    return free_len - n;
+}
+
+/**
+ * @brief Putchar interface for other functions
+ * 
+ * @param ctx context
+ * @param c char
+ */
+static void __msg_putc(msg_ctx_t *ctx, char c)
+{
+    if (ctx->redir) { // if output is redirected, use the internal string buffer
+        if(ctx->redir == __OUTP_COUNT) {
+            ctx->cnt++;
+#if MCU_MSG_USE_IOVEC
+        } else if(ctx->redir == __OUTP_IOVEC) { // char is copied to the scratch
+            if(__msg_putc_to_buff(ctx, c) || !ctx->overflow) __iov_add(ctx, ctx->p - 1, 1);
+#endif
+        } else {
+            __msg_putc_to_buff(ctx, c);
+        }
+        return;
+    }
+    if(ctx->stage_len >= MCU_MSG_STAGE_SIZE) msg_ctx_flush(ctx);
+    ctx->stage[ctx->stage_len++] = c;
+}
+
+/**
+ * @brief Write span interface for other functions. The span is staged, call msg_ctx_flush to emit it
+ * 
+ * @param ctx context
+ * @param p span pointer
+ * @param n span length
+ */
+static void __msg_write(msg_ctx_t *ctx, const char *p, msg_size_t n)
+{
+    msg_size_t i, chunk;
+
+    if (ctx->redir) { // if output is redirected, use the internal string buffer
+        if(ctx->redir == __OUTP_COUNT) {
+            ctx->cnt += n;
+#if MCU_MSG_USE_IOVEC
+        } else if(ctx->redir == __OUTP_IOVEC) { // span is copied to the scratch
+            __msg_write_to_buff(ctx, p, n);
+            if(!ctx->overflow) __iov_add(ctx, ctx->p - n, n);
+#endif
+        } else {
+            __msg_write_to_buff(ctx, p, n);
+        }
+        return;
+    }
+    if(ctx->stage_len + n > MCU_MSG_STAGE_SIZE) {
+        msg_ctx_flush(ctx);
+        if(n >= MCU_MSG_STAGE_SIZE && ctx->sink.write != NULL) { // long span goes to the sink directly
+            ctx->sink.write(ctx->sink.arg, p, n);
+            return;
+        }
+    }
+    while(n) {
+        chunk = MCU_MSG_STAGE_SIZE - ctx->stage_len;
+        if(chunk > n) chunk = n;
+        for(i = 0; i < chunk; i++) ctx->stage[ctx->stage_len + i] = p[i];
+        ctx->stage_len += chunk;
+        p += chunk;
+        n -= chunk;
+        if(ctx->stage_len == MCU_MSG_STAGE_SIZE) msg_ctx_flush(ctx);
+    }
+}
+
+/**
+ * @brief Write span of caller memory (ids, string contents), in iovec mode the span is referenced
+ * whitout copy, otherwise it's the same as __msg_write
+ * 
+ * @param ctx output context
+ * @param p span start
+ * @param n span length
+ */
+static void __msg_write_ref(msg_ctx_t *ctx, const char *p, msg_size_t n)
+{
+#if MCU_MSG_USE_IOVEC
+    if(ctx->redir == __OUTP_IOVEC && n >= MCU_MSG_IOVEC_MIN_REF) {
+        __iov_add(ctx, p, n);
+        return;
+    }
+#endif
+    __msg_write(ctx, p, n);
+}
+
+/*Two digit lookup table for integer formatting*/
+static const char __digits2[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+/**
+ * @brief Write unsigned integer backwards, two digits at a time
+ * 
+ * @param end end of the destination (exclusive), it must have place for 20 digits
+ * @param v value
+ * @param min_dig minimum count of digits (leading zeros)
+ * @return char* first digit
+ */
+static char *__fmt_uint(char *end, uint64_t v, uint8_t min_dig)
+{
+    char *p = end;
+    uint32_t v32;
+
+    while(v > 0xFFFFFFFFUL) { // 64 bit division only for the upper part
+        p -= 2;
+        p[0] = __digits2[(v % 100) * 2];
+        p[1] = __digits2[(v % 100) * 2 + 1];
+        v /= 100;
+    }
+    v32 = (uint32_t)v;
+    while(v32 >= 100) {
+        p -= 2;
+        p[0] = __digits2[(v32 % 100) * 2];
+        p[1] = __digits2[(v32 % 100) * 2 + 1];
+        v32 /= 100;
+    }
+    if(v32 >= 10) {
+        p -= 2;
+        p[0] = __digits2[v32 * 2];
+        p[1] = __digits2[v32 * 2 + 1];
+    } else {
+        *--p = '0' + v32;
+    }
+    while(end - p < min_dig) *--p = '0';
+    return p;
+}
+
+/**
+ * @brief Copy formatted chars to the destination
+ * 
+ * @param dst destination span
+ * @param neg print sign first
+ * @param p chars
+ * @param len length of chars
+ * @return msg_size_t written length or 0 if it doesn't fit
+ */
+static msg_size_t __fmt_copy(msg_str_t dst, uint8_t neg, const char *p, msg_size_t len)
+{
+    msg_size_t i;
+    if(len + neg > dst.len) return 0;
+    if(neg) *dst.s++ = '-';
+    for(i = 0; i < len; i++) dst.s[i] = p[i];
+    return len + neg;
+}
+
+/**
+ * @brief Format double beyond the 64 bit integer range: significant digits followed by zeros
+ * The parser reads the zeros as dropped digits, so no exponent notation is needed. The value is an
+ * integer (mantissa * 2^e), its decimal digits are exact: it's divided by 10^9 as a big integer,
+ * the top 27 digits are kept and the lower ones are only checked for rounding
+ * @param dst destination span
+ * @param x value (absolute value is at least 2^64)
+ * @param dig count of significant digits (max. 17), rounded half to even
+ * @return msg_size_t written length or 0 if it doesn't fit or the value is infinite or NaN
+ */
+static msg_size_t __fmt_big(msg_str_t dst, double x, uint8_t dig)
+{
+    union {
+        double   d;
+        uint64_t u;
+    } v;
+    uint32_t w[34]; // 2^1024 fits
+    uint32_t top[3] = {0, 0, 0}; // last three 9 digit groups, top[0] is the highest
+    char buff[MSG_FMT_BUFF_SIZE];
+    char *end = buff + sizeof(buff);
+    char *p, *q;
+    uint8_t neg = x < 0, sticky = 0, up;
+    int16_t e, n, i, groups = 0;
+    uint64_t m, r;
+    msg_size_t zeros, len;
+
+    v.d = neg ? -x : x;
+    e = (int16_t)((v.u >> 52) & 0x7FF);
+    if(e == 0x7FF) return 0; // infinite or NaN
+    if(dig < 1) dig = 1;
+    if(dig > 17) dig = 17;
+
+    /*Mantissa shifted by e - 1075 (at least 12) to 32 bit words*/
+    m = (v.u & ((1ULL << 52) - 1)) | (1ULL << 52);
+    e -= 1075;
+    for(i = 0; i < (int16_t)(sizeof(w) / sizeof(w[0])); i++) w[i] = 0;
+    w[e / 32] = (uint32_t)(m << (e % 32));
+    w[e / 32 + 1] = (uint32_t)(m >> (32 - e % 32));
+    w[e / 32 + 2] = e % 32 ? (uint32_t)(m >> (64 - e % 32)) : 0;
+    n = e / 32 + 3;
+
+    /*Divide by 10^9 until it's zero, the lower digit groups are shifted out of top[]*/
+    while(n > 0) {
+        for(r = 0, i = n - 1; i >= 0; i--) {
+            r = (r << 32) | w[i];
+            w[i] = (uint32_t)(r / 1000000000UL);
+            r %= 1000000000UL;
+        }
+        while(n > 0 && w[n - 1] == 0) n--;
+        if(top[2]) sticky = 1;
+        top[2] = top[1];
+        top[1] = top[0];
+        top[0] = (uint32_t)r;
+        groups++;
+    }
+    zeros = 9 * (groups - 3); // 2^64 has 20 digits, there are at least 3 groups
+
+    /*Top digits, the rest is rounded*/
+    p = __fmt_uint(end, top[2], 9);
+    p = __fmt_uint(p, top[1], 9);
+    p = __fmt_uint(p, top[0], 1);
+    zeros += end - p - dig;
+    for(m = 0, r = 1, q = p; q < p + dig; q++, r *= 10) m = m * 10 + (*q - '0');
+    for(q = p + dig + 1; q < end && *q == '0'; q++);
+    if(q < end) sticky = 1;
+    up = p[dig] > '5' || (p[dig] == '5' && (sticky || (m & 1)));
+    if(up && ++m == r) { // 99..9 is rounded up to one more digit
+        m /= 10;
+        zeros++;
+    }
+
+    p = __fmt_uint(end, m, 1);
+    len = end - p;
+    if(len + neg + zeros > dst.len) return 0;
+    len = __fmt_copy(dst, neg, p, len);
+    while(zeros--) dst.s[len++] = '0';
+    return len;
+}
+
+/**
+ * @brief Format double in fixed point notation
+ * The fraction part is rounded to nearest, values beyond the 64 bit integer range are formatted
+ * with 17 significant digits and no fraction
+ * @param dst destination span
+ * @param x value
+ * @param prec count of fraction digits (max. MSG_FMT_MAX_PREC)
+ * @return msg_size_t written length or 0 if it doesn't fit
+ */
+static msg_size_t __fmt_fixed(msg_str_t dst, double x, uint8_t prec)
+{
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19
+    };
+    char buff[MSG_FMT_BUFF_SIZE];
+    char *end = buff + sizeof(buff);
+    char *p;
+    uint8_t neg = x < 0;
+    double ax = neg ? -x : x;
+    uint64_t ip, fp;
+    double fr;
+
+    if(!(ax < 18446744073709551616.0)) return __fmt_big(dst, x, 17);
+    if(prec > MSG_FMT_MAX_PREC) prec = MSG_FMT_MAX_PREC;
+
+    ip = (uint64_t)ax;
+    fr = (ax - (double)ip) * pow10[prec]; // integer part subtraction is exact
+    fp = (uint64_t)fr;
+    fr -= (double)fp;
+    if(fr > 0.5 || (fr == 0.5 && ((prec ? fp : ip) & 1))) fp++; // round half to even
+    if(fp >= (uint64_t)pow10[prec]) { // carry to the integer part
+        fp -= (uint64_t)pow10[prec];
+        if(ip == UINT64_MAX) return 0;
+        ip++;
+    }
+
+    if(prec) {
+        p = __fmt_uint(end, fp, prec);
+        *--p = '.';
+    } else {
+        p = end;
+    }
+    p = __fmt_uint(p, ip, 1);
+    return __fmt_copy(dst, neg, p, end - p);
+}
+
+/**
+ * @brief Shortest digits which are read back to the same binary float
+ * Free-format algorithm of Steele & White and Burger & Dybvig with big integers: the value and the
+ * midpoints to the neighbours are scaled to r / s, r + mp and r - mm, digits are generated until
+ * the rest is inside the rounding interval (the interval is closed if the mantissa is even)
+ * @param dig destination of digits (17 chars)
+ * @param f binary mantissa (not zero)
+ * @param e binary exponent, value = f * 2^e
+ * @param lower_half the lower neighbour is closer (lowest mantissa of a binade)
+ * @param k result decimal exponent, value = 0.digits * 10^k
+ * @return uint8_t count of digits
+ */
+static uint8_t __fmt_shortest_digits(char *dig, uint64_t f, int32_t e, uint8_t lower_half, int32_t *k)
+{
+    __msg_big_t r, s, mp, mm, t;
+    __msg_big_t *pm = lower_half ? &mm : &mp; // lower distance is the same as the upper one if it's not a binade start
+    uint8_t even = !(f & 1), n = 0, d, low, high;
+    int8_t c;
+
+    /*Value r / s, upper and lower distance to the midpoints mp / s and mm / s (all are doubled)*/
+    __big_set(&r, f);
+    __big_set(&s, 1);
+    __big_set(&mp, 1);
+    if(e >= 0) {
+        __big_shl(&r, e);
+        __big_shl(&mp, e);
+    } else {
+        __big_shl(&s, -e);
+    }
+    if(lower_half) mm = mp;
+    __big_shl(&r, 1 + lower_half);
+    __big_shl(&s, 1 + lower_half);
+    __big_shl(&mp, lower_half);
+
+    /*Estimation of the decimal exponent (not greater than the exact one), then it's corrected*/
+    *k = (int32_t)(((int64_t)(63 - __clz64(f) + e) * 1292913986LL) >> 32);
+    if(*k >= 0) {
+        __big_mul_pow10(&s, *k);
+    } else {
+        __big_mul_pow10(&r, -*k);
+        __big_mul_pow10(&mp, -*k);
+        if(lower_half) __big_mul_pow10(&mm, -*k);
+    }
+    for(;;) { // upper midpoint has to be below 1 (or at 1 if it's included)
+        __big_sum(&t, &r, &mp);
+        c = __big_cmp(&t, &s);
+        if(c < 0 || (c == 0 && !even)) break;
+        __big_mul(&s, 10);
+        (*k)++;
+    }
+
+    /*Digits until the rest is closer to the value than the neighbours*/
+    for(;;) {
+        __big_mul(&r, 10);
+        __big_mul(&mp, 10);
+        if(lower_half) __big_mul(&mm, 10);
+        for(d = 0; __big_cmp(&r, &s) >= 0; d++) __big_sub(&r, &s);
+        c = __big_cmp(&r, pm);
+        low = c < 0 || (c == 0 && even);
+        __big_sum(&t, &r, &mp);
+        c = __big_cmp(&t, &s);
+        high = c > 0 || (c == 0 && even);
+        if(low || high || n == 16) break;
+        dig[n++] = '0' + d;
+    }
+    if(low && high) { // both digits are in the interval, the closer one is taken (even digit on tie)
+        __big_sum(&t, &r, &r);
+        c = __big_cmp(&t, &s);
+        if(c > 0 || (c == 0 && (d & 1))) d++;
+    } else if(high) {
+        d++;
+    }
+    dig[n++] = '0' + d;
+    return n;
+}
+
+/**
+ * @brief Shortest digits with 64 bit integers, same algorithm as __fmt_shortest_digits
+ * It's used if the scaled values fit to 60 bits (most of the values in sensor ranges), so the digits
+ * are generated by division whitout big integers
+ * @param dig destination of digits (17 chars)
+ * @param f binary mantissa (not zero)
+ * @param e binary exponent, value = f * 2^e
+ * @param lower_half the lower neighbour is closer (lowest mantissa of a binade)
+ * @param k result decimal exponent, value = 0.digits * 10^k
+ * @return uint8_t count of digits or 0 if the values don't fit
+ */
+static uint8_t __fmt_shortest_digits64(char *dig, uint64_t f, int32_t e, uint8_t lower_half, int32_t *k)
+{
+    static const uint64_t pow10[] = {
+        1ULL,                 10ULL,                 100ULL,                 1000ULL,
+        10000ULL,             100000ULL,             1000000ULL,             10000000ULL,
+        100000000ULL,         1000000000ULL,         10000000000ULL,         100000000000ULL,
+        1000000000000ULL,     10000000000000ULL,     100000000000000ULL,     1000000000000000ULL,
+        10000000000000000ULL, 100000000000000000ULL
+    };
+    const uint64_t lim = 1ULL << 60;
+    uint64_t r, s, mp, mm;
+    uint8_t even = !(f & 1), n = 0, d, low, high;
+    uint8_t bits = 64 - __clz64(f);
+
+    if(e >= 0 ? bits + e + 1 + lower_half > 60 : 1 + lower_half - e > 59) return 0;
+    r = f << (1 + lower_half);
+    s = 2ULL << lower_half;
+    mp = 1ULL << lower_half;
+    if(e >= 0) {
+        r <<= e;
+        mp <<= e;
+    } else {
+        s <<= -e;
+    }
+    mm = mp >> lower_half;
+
+    *k = (int32_t)(((int64_t)(bits - 1 + e) * 1292913986LL) >> 32);
+    if(*k >= 0) {
+        if(*k >= (int32_t)(sizeof(pow10) / sizeof(pow10[0])) || s > lim / pow10[*k]) return 0;
+        s *= pow10[*k];
+    } else {
+        if(-*k >= (int32_t)(sizeof(pow10) / sizeof(pow10[0])) || r > lim / pow10[-*k]) return 0;
+        r *= pow10[-*k];
+        mp *= pow10[-*k];
+        mm *= pow10[-*k];
+    }
+    while(r + mp > s || (r + mp == s && even)) {
+        if(s > lim / 10) return 0;
+        s *= 10;
+        (*k)++;
+    }
+
+    for(;;) { // r, mp and mm are less than s, they fit after multiplication
+        r *= 10;
+        mp *= 10;
+        mm *= 10;
+        d = (uint8_t)(r / s);
+        r %= s;
+        low = r < mm || (r == mm && even);
+        high = r + mp > s || (r + mp == s && even);
+        if(low || high || n == 16) break;
+        dig[n++] = '0' + d;
+    }
+    if(low && high) {
+        if(2 * r > s || (2 * r == s && (d & 1))) d++;
+    } else if(high) {
+        d++;
+    }
+    dig[n++] = '0' + d;
+    return n;
+}
+
+/**
+ * @brief Format shortest round trip representation of binary float in fixed point notation
+ * Leading and trailing zeros are written as many as needed, there is no exponent notation
+ * @param dst destination span
+ * @param neg negative sign
+ * @param f binary mantissa
+ * @param e binary exponent, value = f * 2^e
+ * @param lower_half the lower neighbour is closer (lowest mantissa of a binade)
+ * @return msg_size_t written length or 0 if it doesn't fit
+ */
+static msg_size_t __fmt_shortest(msg_str_t dst, uint8_t neg, uint64_t f, int32_t e, uint8_t lower_half)
+{
+    char dig[17];
+    char *p = dst.s;
+    uint8_t n, i;
+    int32_t k, len;
+
+    if(!f) return __fmt_copy(dst, 0, "0", 1);
+    n = __fmt_shortest_digits64(dig, f, e, lower_half, &k);
+    if(!n) n = __fmt_shortest_digits(dig, f, e, lower_half, &k);
+
+    len = neg + (k <= 0 ? 2 - k + n : k >= n ? k : n + 1);
+    if(len > (int32_t)dst.len) return 0;
+    if(neg) *p++ = '-';
+    if(k <= 0) { // 0.000ddd
+        *p++ = '0';
+        *p++ = '.';
+        for(; k < 0; k++) *p++ = '0';
+        for(i = 0; i < n; i++) *p++ = dig[i];
+    } else if(k >= n) { // ddd000
+        for(i = 0; i < n; i++) *p++ = dig[i];
+        for(; k > n; k--) *p++ = '0';
+    } else { // dd.d
+        for(i = 0; i < n; i++) {
+            if(i == k) *p++ = '.';
+            *p++ = dig[i];
+        }
+    }
+    return (msg_size_t)len;
+}
+
+/*Format integer*/
+msg_size_t msg_fmt_int(msg_str_t dst, int i)
+{
+    char buff[MSG_FMT_BUFF_SIZE];
+    char *end = buff + sizeof(buff);
+    char *p = __fmt_uint(end, i < 0 ? 0 - (uint64_t)(int64_t)i : (uint64_t)i, 1);
+    return __fmt_copy(dst, i < 0, p, end - p);
+}
+
+/*Format float*/
+msg_size_t msg_fmt_float(msg_str_t dst, float f, uint8_t prec)
+{
+    union {
+        float    f;
+        uint32_t u;
+    } v;
+    int32_t e;
+    uint32_t m;
+
+    if(prec != MSG_FMT_SHORTEST) return __fmt_fixed(dst, f, prec);
+
+    v.f = f;
+    e = (int32_t)((v.u >> 23) & 0xFF);
+    m = v.u & ((1UL << 23) - 1);
+    if(e == 0xFF) return 0; // infinite or NaN
+    if(!e) return __fmt_shortest(dst, v.u >> 31, m, -149, 0); // subnormal
+    return __fmt_shortest(dst, v.u >> 31, m | (1UL << 23), e - 150, !m && e > 1);
+}
+
+/*Format double*/
+msg_size_t msg_fmt_double(msg_str_t dst, double d, uint8_t prec)
+{
+    union {
+        double   d;
+        uint64_t u;
+    } v;
+    int32_t e;
+    uint64_t m;
+
+    if(prec != MSG_FMT_SHORTEST) return __fmt_fixed(dst, d, prec);
+
+    v.d = d;
+    e = (int32_t)((v.u >> 52) & 0x7FF);
+    m = v.u & ((1ULL << 52) - 1);
+    if(e == 0x7FF) return 0; // infinite or NaN
+    if(!e) return __fmt_shortest(dst, v.u >> 63, m, -1074, 0); // subnormal
+    return __fmt_shortest(dst, v.u >> 63, m | (1ULL << 52), e - 1075, !m && e > 1);
+}
+
+/**
+ * @brief Write integer to the output stage
+ * 
+ * @param ctx context
+ * @param i integer value
+ */
+static void __msg_write_int(msg_ctx_t *ctx, int i)
+{
+    char buff[MSG_FMT_BUFF_SIZE];
+    msg_str_t str;
+    str.s = buff;
+    str.len = sizeof(buff);
+    __msg_write(ctx, buff, msg_fmt_int(str, i));
+}
+
+/**
+ * @brief Write float to the output stage
+ * 
+ * @param ctx context
+ * @param f float value
+ * @param prec precision of printing (MSG_FMT_SHORTEST for shortest round trip)
+ */
+static void __msg_write_float(msg_ctx_t *ctx, float f, uint8_t prec)
+{
+    char buff[MSG_FMT_BUFF_SIZE];
+    msg_str_t str;
+    str.s = buff;
+    str.len = sizeof(buff);
+    str.len = msg_fmt_float(str, f, prec);
+    if(!str.len) ctx->overflow = 1; // infinite or NaN, the key would be printed whitout value
+    __msg_write(ctx, buff, str.len);
+}
+
+/*Print integer*/
+void msg_ctx_print_int(msg_ctx_t *ctx, int i)
+{
+    __msg_write_int(ctx, i);
+    msg_ctx_flush(ctx);
+}
+
+/*Print float*/
+void msg_ctx_print_float(msg_ctx_t *ctx, float f, uint8_t prec)
+{
+    __msg_write_float(ctx, f, prec);
+    msg_ctx_flush(ctx);
+}
+
+/*Print string*/
+void msg_ctx_print_str(msg_ctx_t *ctx, msg_str_t str)
+{
+    __msg_write_ref(ctx, str.s, str.len);
+    msg_ctx_flush(ctx);
+}
+
+/*Print message*/
+void msg_ctx_print_msg(msg_ctx_t *ctx, msg_t msg)
+{
+    __msg_putc(ctx, __CTRL_MSG_FLAG);
+    __msg_write_ref(ctx, msg.id.s, msg.id.len);
+    __msg_putc(ctx, __CTRL_START_MSG);
+    __msg_write_ref(ctx, msg.content.s, msg.content.len);
+    __msg_putc(ctx, __CTRL_STOP_MSG);
+    msg_ctx_flush(ctx);
+}
+
+/**
+ * @brief Print integer
+ * 
+ * @param i integer value
+ */
+static void __msg_print_int(int i)
+{
+    msg_ctx_print_int(&__ctx, i);
+}
+
+/**
+ * @brief Print float
+ * 
+ * @param f float value
+ * @param prec precision of printing (MSG_FMT_SHORTEST for shortest round trip)
+ */
+static void __msg_print_float(float f, uint8_t prec)
+{
+    msg_ctx_print_float(&__ctx, f, prec);
+}
+
+
+/**
+ * @brief Print string
+ * 
+ * @param str string object
+ */
+static void __msg_print_str(msg_str_t str)
+{
+    msg_ctx_print_str(&__ctx, str);
+}
+
+
+/**
+ * @brief print message
+ * 
+ * @param msg 
+ */
+static void __msg_print(msg_t msg)
+{
+    msg_ctx_print_msg(&__ctx, msg);
+}
+
+/**
+ * @brief Create string handler and set the basic functions
+ * 
+ * @param putc expected print function, set to NULL if you don't need the print feature
+ * @return msg_string_hnd_t handler
+ */
+msg_hnd_t msg_hnd_create(int (*putc)(char))
+{
+
+    msg_hnd_t hnd;
+
+    msg_ctx_init(&__ctx, putc);          // init default context
+    hnd.ctx = &__ctx;
+    hnd.putc = putc;                     // init putchar
+
+    //features
+    hnd.flush             = __msg_flush;
+    hnd.print_msg         = __msg_print;
+    hnd.print_str         = __msg_print_str;
+    hnd.print_int         = __msg_print_int;
+    hnd.print_float       = __msg_print_float;
+    hnd.enable_buff       = __msg_enable_buff;
+    hnd.disable_buff      = __msg_disable_buff;
+    hnd.init_str_buff     = __msg_init_str_buff;
+    hnd.reset_str_buff    = __msg_reset_str_buff;
+#if MCU_MSG_USE_WRAPPER
+    hnd.print_wrapper_msg = __msg_wrapper_print_msg;
+    hnd.print_builder     = __msg_builder_print;
+    hnd.print_template    = __msg_template_print;
+ #if MCU_MSG_USE_DELTA
+    hnd.print_delta       = __msg_delta_print;
+ #endif
+#endif
+    
+    return hnd;
+}
+
+/**
+ * @brief Create string handler with span output sink
+ * 
+ * @param sink output sink, write is called with the staged spans
+ * @return msg_hnd_t handler
+ */
+msg_hnd_t msg_hnd_create_sink(msg_sink_t sink)
+{
+    msg_hnd_t hnd;
+
+    hnd = msg_hnd_create(NULL);
+    __ctx.sink = sink;
+    return hnd;
+}
+
+/**
+ * @brief Defining the quotation mark. Default is ", if there is an occurance of ", ' will be used
+ * 
+ * @param str string object
+ * @return char quotion mark
+ */
+static inline char __define_qmark(msg_str_t str)
+{
+    char *p = str.s;
+    while(__is_p_in_str(str, p) && *p) {
+        switch(*p) {
+            case '"' :  return '\'';
+            case '\'' : return '"';
+            default: break;
+        }
+        p++;
+    }
+    return '"'; // default
+}
+
+
+/**
+ * @brief Write message, object, key or command id, registered ids are written as tokens
+ * if the context has a dictionary
+ * 
+ * @param ctx output context
+ * @param id id string
+ */
+static void __msg_write_id(msg_ctx_t *ctx, msg_str_t id)
+{
+#if MCU_MSG_USE_DICT
+    char tok[__DICT_TOK_SIZE];
+    msg_size_t n;
+
+    if(ctx->dict != NULL && (n = __dict_token(ctx->dict, id, tok)) != 0) {
+        __msg_write(ctx, tok, n);
+        return;
+    }
+#endif
+    __msg_write_ref(ctx, id.s, id.len);
+}
+
+/**
+ * @brief Printing key and equal sign
+ * 
+ */
+#define __print_key_equ(ctx, key_str)       __msg_putc(ctx, __CTRL_KEY_FLAG);           \
+                                            __msg_write_id(ctx, key_str);               \
+                                            __msg_putc(ctx, __CTRL_KEY_EQU)
+/**
+ * @brief Print key separator if it is not the first key of the object
+ * 
+ */
+#define __print_key_sep(ctx, sep)           if(sep) __msg_putc(ctx, __CTRL_KEY_SEP);    \
+                                            sep = 1
+
+/**
+ * @brief Print message start chars with flag and start char and message id
+ * 
+ */
+#define __print_msg_start(ctx, msg)         __msg_putc(ctx, __CTRL_MSG_FLAG);           \
+                                            __msg_write_id(ctx, msg.id);                \
+                                            __msg_putc(ctx, __CTRL_START_MSG)
+
+
+
+/**
+ * @brief Print object start with flag start char and object id
+ * 
+ */
+#define __print_obj_start(ctx, obj)         __msg_putc(ctx, __CTRL_OBJ_FLAG);           \
+                                            __msg_write_id(ctx, obj.id);                \
+                                            __msg_putc(ctx, __CTRL_START_OBJ)
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                     Wrapper functions                                   //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_WRAPPER
+
+/**
+ * @brief Print object wrapper
+ * 
+ * @param ctx output context
+ * @param obj object wrapper to print
+ */
+static void __msg_wrapper_print_obj(msg_ctx_t *ctx, msg_wrap_obj_t obj)
+{
+    msg_wrap_str_t *sp;
+    msg_wrap_int_t *ip;
+    msg_wrap_float_t *fp;
+    uint8_t sep = 0; // separator is needed before the next key
+    char qmark;
+
+    __print_obj_start(ctx, obj);
+    
+
+    // print integers
+    
+    for(ip = obj.int_queue; ip != NULL; ip = ip->next) {
+        __print_key_sep(ctx, sep);
+        __print_key_equ(ctx, ip->id);
+        __msg_write_int(ctx, ip->val);
+    }
+
+    // print floats
+    for(fp = obj.float_queue; fp != NULL; fp = fp->next) {
+        __print_key_sep(ctx, sep);
+        __print_key_equ(ctx, fp->id);
+        __msg_write_float(ctx, fp->val, fp->prec);
+    }
+    // print strings
+    for(sp = obj.string_queue; sp != NULL; sp = sp->next) {
+        __print_key_sep(ctx, sep);
+        __print_key_equ(ctx, sp->id);
+        qmark = __define_qmark(sp->content);
+        __msg_putc(ctx, qmark);
+        __msg_write_ref(ctx, sp->content.s, sp->content.len);
+        __msg_putc(ctx, qmark);
+    }
+
+    __msg_putc(ctx, __CTRL_STOP_OBJ);
+}
+
+
+/**
+ * @brief Print command wrapper
+ * 
+ * @param ctx output context
+ * @param cmd command wrapper to print
+ */
+static inline void __msg_wrapper_print_cmd(msg_ctx_t *ctx, msg_wrap_cmd_t cmd)
+{
+    if(cmd.cmd.s != NULL) {
+        __msg_putc(ctx, __CTRL_CMD_START_FLAG);
+        __msg_write_id(ctx, cmd.cmd);
+        __msg_putc(ctx, __CTRL_CMD_STOP_FLAG);
+    }
+}
+
+
+/*Print message wrapper*/
+void msg_ctx_print_wrapper_msg(msg_ctx_t *ctx, msg_wrap_t msg)
+{
+    msg_wrap_obj_t *pobj;
+    msg_wrap_cmd_t *pcmd;
+
+    if(msg.id.s == NULL) // return if message id is not set
+        return;
+    __print_msg_start(ctx, msg);
+    
+    /*Print command queue*/
+    pcmd = msg.cmd_queue;
+    while(pcmd != NULL) {
+        __msg_wrapper_print_cmd(ctx, *pcmd);
+        pcmd = pcmd->next;   
+    }
+    /*Print object queue*/
+    pobj = msg.obj_queue;
+    while(pobj != NULL) {
+        __msg_wrapper_print_obj(ctx, *pobj);
+        pobj = pobj->next;  
+    }
+    __msg_putc(ctx, __CTRL_STOP_MSG);
+    msg_ctx_flush(ctx);
+}
+
+
+/**
+ * @brief Print message wrapper with the default context
+ * 
+ * @param msg message wrapper to print
+ */
+static void __msg_wrapper_print_msg(msg_wrap_t msg)
+{
+    msg_ctx_print_wrapper_msg(&__ctx, msg);
+}
+
+
+/*Destroy message wrappe*/
+void msg_wrap_destroy(msg_wrap_t *msg)
+{
+    msg_destroy_str(&msg->id);
+    msg->cmd_queue = NULL;
+    msg->obj_queue = NULL;
+}
+
+/*Destroy object wrapper*/
+void msg_wrap_destroy_obj(msg_wrap_obj_t *obj)
+{
+    msg_destroy_str(&obj->id);
+    obj->int_queue = NULL;
+    obj->float_queue = NULL;
+    obj->string_queue = NULL;
+    obj->next = NULL;
+}
+
+
+/*destroy command wrapper*/
+void msg_wrap_destroy_cmd(msg_wrap_cmd_t *cmd)
+{
+    msg_destroy_str(&cmd->cmd);
+    cmd->next = NULL;
+}
+
+
+/*destroy string wrapper*/
+void msg_wrap_destroy_str(msg_wrap_str_t *str)
+{
+    msg_destroy_str(&str->id);
+    msg_destroy_str(&str->content);
+    str->next = NULL;
+}
+
+
+/*destroy integer wrapper*/
+void msg_wrap_destroy_int(msg_wrap_int_t *i)
+{
+    msg_destroy_str(&i->id);
+    i->val = 0;
+    i->next = NULL;
+}
+
+/*Destroy float wrapper*/
+void msg_wrap_destroy_float(msg_wrap_float_t *f)
+{
+    msg_destroy_str(&f->id);
+    f->val = 0.0;
+    f->next = NULL;
+    f->prec = 0;
+}
+
+
+/*Create message wrapper*/
+msg_wrap_t msg_wrapper_create_msg(char *msg_id)
+{
+    msg_wrap_t res;
+    res.id = msg_init_string(msg_id);
+    res.cmd_queue = NULL;
+    res.obj_queue = NULL;
+    return res;
+}
+
+/*Create command wrapper*/
+msg_wrap_cmd_t msg_wrapper_create_cmd(char *cmd)
+{
+    msg_wrap_cmd_t res;
+    res.cmd = msg_init_string(cmd);
+    res.next = NULL;
+    return res;
+}
+
+/*Create object wrapper*/
+msg_wrap_obj_t msg_wrapper_create_obj(char *obj_id)
+{
+    msg_wrap_obj_t res;
+    res.id = msg_init_string(obj_id);
+    res.int_queue = NULL;
+    res.float_queue = NULL;
+    res.string_queue = NULL;
+    res.next = NULL;
+    return res;
+}
+
+/*Create string wrapper*/
+msg_wrap_str_t msg_wrapper_create_str(char *id, char *content)
+{
+    msg_wrap_str_t res;
+    res.id = msg_init_string(id);
+    res.content = msg_init_string(content);
+    res.next = NULL;
+    return res;
+}
+
+/*Create int wrapper*/
+msg_wrap_int_t msg_wrapper_create_int(char *id, int val)
+{
+    msg_wrap_int_t res;
+    res.id = msg_init_string(id);
+    res.val = val;
+    res.next = NULL;
+    return res;
+}
+
+/*create float wrapper*/
+msg_wrap_float_t msg_wrapper_create_float(char *id, float val, uint8_t prec)
 {
     msg_wrap_float_t res;
     res.id = msg_init_string(id);
@@ -947,177 +3232,3493 @@ msg_wrap_float_t msg_wrapper_create_float(char *id, float val, uint8_t prec)
     return res;
 }
 
-/*Add string wrapper to object wrapper*/
-void msg_wrapper_add_str_to_obj(msg_wrap_obj_t *obj, msg_wrap_str_t *str)
+/*Add string wrapper to object wrapper*/
+void msg_wrapper_add_str_to_obj(msg_wrap_obj_t *obj, msg_wrap_str_t *str)
+{
+    msg_wrap_str_t *strp;
+    if(obj->string_queue == NULL) { //empty
+        obj->string_queue = str;
+        obj->string_queue->next = NULL;
+    } else { // put to the end of the queue
+        strp = obj->string_queue;
+
+        while(strp->next != NULL) 
+            strp = strp->next;
+        strp->next = str;
+        str->next = NULL;
+    }
+}
+
+/*Remove string wrapper from string queue*/
+void msg_wrapper_rm_string_from_obj(msg_wrap_obj_t *obj, msg_wrap_str_t *str)
+{
+    msg_wrap_str_t *sp, *prev;
+    for(sp = obj->string_queue, prev = NULL; sp != NULL; sp = sp->next){
+        if(sp == str) { 
+            if(prev == NULL) { // if p is the head of the queue, reinit the head
+                obj->string_queue = str->next;
+            } else {
+                prev->next = str->next; //skip the expected
+            }
+            str->next = NULL; // reset next
+            return;
+        }
+        prev = sp;
+    }
+}
+
+/*Add int wrapper to object wrapper*/
+void msg_wrapper_add_int_to_obj(msg_wrap_obj_t *obj, msg_wrap_int_t *int_val)
+{
+    msg_wrap_int_t *ip;
+    if(obj->int_queue == NULL) { //first element
+        obj->int_queue = int_val;
+        obj->int_queue->next = NULL;
+    } else { // push to the end of the queue
+        ip = obj->int_queue;
+
+        while(ip->next != NULL) 
+            ip = ip->next;
+        ip->next = int_val;
+        int_val->next = NULL;
+    }
+}
+
+/*Remove int wrapper from integer wrapper queue*/
+void msg_wrapper_rm_int_from_obj(msg_wrap_obj_t *obj, msg_wrap_int_t *i)
+{
+    msg_wrap_int_t *ip, *prev;
+    for(ip = obj->int_queue, prev = NULL; ip != NULL; ip = ip->next){
+        if(ip == i) {
+            if(prev == NULL) { // if p is the head of the queue, reinit the head
+                obj->int_queue = i->next;
+            } else {
+                prev->next = i->next; //skip the expected
+            }
+            i->next = NULL; // reset next
+            return;
+        }
+        prev = ip;
+    }
+}
+
+/*Add float wrapper to object wrapper*/
+void msg_wrapper_add_float_to_obj(msg_wrap_obj_t *obj, msg_wrap_float_t *float_val)
+{
+    msg_wrap_float_t *fp;
+    if(obj->float_queue == NULL) { //first element
+        obj->float_queue = float_val;
+        obj->float_queue->next = NULL;
+    } else {
+        fp = obj->float_queue;
+
+        while(fp->next != NULL) 
+            fp = fp->next;
+        fp->next = float_val;
+        float_val->next = NULL;
+    }
+}
+
+/*Remove float wrapper from float queue*/
+void msg_wrapper_rm_float_from_obj(msg_wrap_obj_t *obj, msg_wrap_float_t *f)
+{
+    msg_wrap_float_t *fp, *prev;
+    for(fp = obj->float_queue, prev = NULL; fp != NULL; fp = fp->next){
+        if(fp == f) {
+            if(prev == NULL) { // if p is the head of the queue, reinit the head
+                obj->float_queue = f->next;
+            } else {
+                prev->next = f->next; //skip the expected
+            }
+            f->next = NULL; // reset next
+            return;
+        }
+        prev = fp;
+    }
+}
+
+/*Add object wrapper to message wrapper*/
+void msg_wrapper_add_obj_to_msg(msg_wrap_t *msg, msg_wrap_obj_t *obj)
+{
+    msg_wrap_obj_t *op;
+    if(msg->obj_queue == NULL) { //if empty 
+        msg->obj_queue = obj;
+        msg->obj_queue->next = NULL;
+    } else { // put to end of the queue
+        op = msg->obj_queue;
+        while(op->next != NULL)
+            op = op->next;
+        op->next = obj;
+        obj->next = NULL;
+    }
+}
+
+/*remove object wrapper from message wrapper object queue*/
+void msg_wrapper_rm_obj_from_msg(msg_wrap_t *msg, msg_wrap_obj_t *obj)
+{
+    msg_wrap_obj_t *op, *prev;
+    for(op = msg->obj_queue, prev = NULL; op != NULL; op = op->next){
+        if(op == obj) {
+            if(prev == NULL) { // if p is the head of the queue, reinit the head
+                msg->obj_queue = obj->next;
+            } else {
+                prev->next = obj->next; //skip the expected
+            }
+            obj->next = NULL; // reset next
+            return;
+        }
+        prev = op;
+    }    
+}
+
+/*Add command wrapper to message wrapper*/
+void msg_wrapper_add_cmd_to_msg(msg_wrap_t *msg, msg_wrap_cmd_t *cmd)
+{
+    msg_wrap_cmd_t *cp;
+    if(msg->cmd_queue == NULL) { //if empty 
+        msg->cmd_queue = cmd;
+        msg->cmd_queue->next = NULL;
+    } else {
+        cp = msg->cmd_queue;
+        while(cp->next != NULL)
+            cp = cp->next;
+        cp->next = cmd;
+        cmd->next = NULL;
+    }
+}
+
+/*Remove command wrapper from message wrapper command queue*/
+void msg_wrapper_rm_cmd_from_msg(msg_wrap_t *msg, msg_wrap_cmd_t *cmd)
+{
+    msg_wrap_cmd_t *cp, *prev;
+    for(cp = msg->cmd_queue, prev = NULL; cp != NULL; cp = cp->next){
+        if(cp == cmd) {
+            if(prev == NULL) { // if p is the head of the queue, reinit the head
+                msg->cmd_queue = cmd->next;
+            } else {
+                prev->next = cmd->next; //skip the expected
+            }
+            cmd->next = NULL; // reset next
+            return;
+        }
+        prev = cp;
+    }    
+}
+
+
+/**
+ * @brief Link entry to the end of a list
+ * 
+ * @param b builder pointer
+ * @param head head index of the list
+ * @param tail tail index of the list
+ * @param i entry index
+ */
+static void __bld_link(msg_builder_t *b, msg_size_t *head, msg_size_t *tail, msg_size_t i)
+{
+    b->arena[i].next = MSG_BLD_NONE;
+    if(*head == MSG_BLD_NONE) {
+        *head = i;
+    } else {
+        b->arena[*tail].next = i;
+    }
+    *tail = i;
+}
+
+/**
+ * @brief Allocate key-value entry and link it to the list of the object
+ * 
+ * @param b builder pointer
+ * @param obj entry index of the object
+ * @param key key string
+ * @param type entry type (MSG_BLD_INT, MSG_BLD_FLOAT or MSG_BLD_STR)
+ * @return msg_size_t entry index or MSG_BLD_NONE
+ */
+static msg_size_t __bld_add_key(msg_builder_t *b, msg_size_t obj, char *key, uint8_t type)
+{
+    msg_bld_entry_t *o;
+    msg_size_t i;
+
+    if(b->cnt >= b->size || obj >= b->cnt || b->arena[obj].type != MSG_BLD_OBJ) return MSG_BLD_NONE;
+    i = b->cnt++;
+    b->arena[i].id = msg_init_string(key);
+    b->arena[i].type = type;
+    b->arena[i].prec = 0;
+    o = &b->arena[obj];
+    __bld_link(b, &o->val.obj.head[type], &o->val.obj.tail[type], i);
+    return i;
+}
+
+/*Create message builder*/
+msg_builder_t msg_builder_create(char *msg_id, msg_bld_entry_t *arena, msg_size_t size)
+{
+    msg_builder_t res;
+    res.id = msg_init_string(msg_id);
+    res.arena = arena;
+    res.size = arena != NULL ? size : 0;
+    msg_builder_reset(&res);
+    return res;
+}
+
+/*Remove every entry*/
+void msg_builder_reset(msg_builder_t *b)
+{
+    b->cnt = 0;
+    b->head[0] = b->head[1] = MSG_BLD_NONE;
+    b->tail[0] = b->tail[1] = MSG_BLD_NONE;
+}
+
+/*Add command to builder*/
+msg_size_t msg_builder_add_cmd(msg_builder_t *b, char *cmd)
+{
+    msg_size_t i;
+
+    if(b->cnt >= b->size) return MSG_BLD_NONE;
+    i = b->cnt++;
+    b->arena[i].id = msg_init_string(cmd);
+    b->arena[i].type = MSG_BLD_CMD;
+    __bld_link(b, &b->head[0], &b->tail[0], i);
+    return i;
+}
+
+/*Add object to builder*/
+msg_size_t msg_builder_add_obj(msg_builder_t *b, char *obj_id)
+{
+    msg_size_t i;
+    uint8_t t;
+
+    if(b->cnt >= b->size) return MSG_BLD_NONE;
+    i = b->cnt++;
+    b->arena[i].id = msg_init_string(obj_id);
+    b->arena[i].type = MSG_BLD_OBJ;
+    for(t = 0; t < 3; t++) b->arena[i].val.obj.head[t] = b->arena[i].val.obj.tail[t] = MSG_BLD_NONE;
+    __bld_link(b, &b->head[1], &b->tail[1], i);
+    return i;
+}
+
+/*Add integer to object of builder*/
+msg_size_t msg_builder_add_int(msg_builder_t *b, msg_size_t obj, char *key, int val)
+{
+    msg_size_t i = __bld_add_key(b, obj, key, MSG_BLD_INT);
+    if(i != MSG_BLD_NONE) b->arena[i].val.i = val;
+    return i;
+}
+
+/*Add float to object of builder*/
+msg_size_t msg_builder_add_float(msg_builder_t *b, msg_size_t obj, char *key, float val, uint8_t prec)
+{
+    msg_size_t i = __bld_add_key(b, obj, key, MSG_BLD_FLOAT);
+    if(i != MSG_BLD_NONE) {
+        b->arena[i].val.f = val;
+        b->arena[i].prec = prec;
+    }
+    return i;
+}
+
+/*Add string to object of builder*/
+msg_size_t msg_builder_add_str(msg_builder_t *b, msg_size_t obj, char *key, char *content)
+{
+    msg_size_t i = __bld_add_key(b, obj, key, MSG_BLD_STR);
+    if(i != MSG_BLD_NONE) b->arena[i].val.s = msg_init_string(content);
+    return i;
+}
+
+/*Set integer entry*/
+void msg_builder_set_int(msg_builder_t *b, msg_size_t i, int val)
+{
+    if(i < b->cnt && b->arena[i].type == MSG_BLD_INT) b->arena[i].val.i = val;
+}
+
+/*Set float entry*/
+void msg_builder_set_float(msg_builder_t *b, msg_size_t i, float val)
+{
+    if(i < b->cnt && b->arena[i].type == MSG_BLD_FLOAT) b->arena[i].val.f = val;
+}
+
+/*Set string entry*/
+void msg_builder_set_str(msg_builder_t *b, msg_size_t i, char *content)
+{
+    if(i < b->cnt && b->arena[i].type == MSG_BLD_STR) b->arena[i].val.s = msg_init_string(content);
+}
+
+/*Remove entry from builder*/
+void msg_builder_rm(msg_builder_t *b, msg_size_t i)
+{
+    if(i < b->cnt) b->arena[i].type = MSG_BLD_REMOVED; // skipped by printing, list links stay valid
+}
+
+/*Print message builder*/
+void msg_ctx_print_builder(msg_ctx_t *ctx, const msg_builder_t *b)
+{
+    const msg_bld_entry_t *e, *o;
+    msg_size_t i, j;
+    uint8_t t, sep;
+    char qmark;
+
+    if(b->id.s == NULL) // return if message id is not set
+        return;
+    __print_msg_start(ctx, (*b));
+
+    /*Print command list*/
+    for(i = b->head[0]; i != MSG_BLD_NONE; i = e->next) {
+        e = &b->arena[i];
+        if(e->type != MSG_BLD_CMD) continue;
+        __msg_putc(ctx, __CTRL_CMD_START_FLAG);
+        __msg_write_id(ctx, e->id);
+        __msg_putc(ctx, __CTRL_CMD_STOP_FLAG);
+    }
+    /*Print object list, keys in int, float, string order as the wrapper*/
+    for(i = b->head[1]; i != MSG_BLD_NONE; i = o->next) {
+        o = &b->arena[i];
+        if(o->type != MSG_BLD_OBJ) continue;
+        __print_obj_start(ctx, (*o));
+        sep = 0;
+        for(t = MSG_BLD_INT; t <= MSG_BLD_STR; t++) {
+            for(j = o->val.obj.head[t]; j != MSG_BLD_NONE; j = e->next) {
+                e = &b->arena[j];
+                if(e->type != t) continue;
+                __print_key_sep(ctx, sep);
+                __print_key_equ(ctx, e->id);
+                switch(t) {
+                    case MSG_BLD_INT:
+                        __msg_write_int(ctx, e->val.i);
+                        break;
+                    case MSG_BLD_FLOAT:
+                        __msg_write_float(ctx, e->val.f, e->prec);
+                        break;
+                    default:
+                        qmark = __define_qmark(e->val.s);
+                        __msg_putc(ctx, qmark);
+                        __msg_write_ref(ctx, e->val.s.s, e->val.s.len);
+                        __msg_putc(ctx, qmark);
+                        break;
+                }
+            }
+        }
+        __msg_putc(ctx, __CTRL_STOP_OBJ);
+    }
+    __msg_putc(ctx, __CTRL_STOP_MSG);
+    msg_ctx_flush(ctx);
+}
+
+/**
+ * @brief Print message builder with the default context
+ * 
+ * @param b builder pointer
+ */
+static void __msg_builder_print(const msg_builder_t *b)
+{
+    msg_ctx_print_builder(&__ctx, b);
+}
+
+/**
+ * @brief Format value of template slot
+ * 
+ * @param sl slot pointer
+ * @param tmp format buffer (MSG_FMT_BUFF_SIZE)
+ * @return msg_size_t formatted length (strings are not formatted, length with qmarks), 0 if it can't be formatted
+ */
+static msg_size_t __tpl_fmt(const msg_tpl_slot_t *sl, char *tmp)
+{
+    const msg_wrap_float_t *fp;
+    msg_str_t dst;
+
+    dst.s = tmp;
+    dst.len = MSG_FMT_BUFF_SIZE;
+    switch(sl->type) {
+        case MSG_BLD_INT:
+            return msg_fmt_int(dst, ((const msg_wrap_int_t *)sl->src)->val);
+        case MSG_BLD_FLOAT:
+            fp = (const msg_wrap_float_t *)sl->src;
+            return msg_fmt_float(dst, fp->val, fp->prec);
+        default:
+            return ((const msg_wrap_str_t *)sl->src)->content.len + 2;
+    }
+}
+
+/**
+ * @brief Add value slot to template and reserve its place with spaces
+ * 
+ * @param ctx context of template buffer
+ * @param tpl template pointer
+ * @param slot_size size of slot array
+ * @param src wrapper value
+ * @param type value type (MSG_BLD_INT, MSG_BLD_FLOAT or MSG_BLD_STR)
+ * @return uint8_t 1 if the slot is added, 0 if slot array is full
+ */
+static uint8_t __tpl_reserve(msg_ctx_t *ctx, msg_template_t *tpl, msg_size_t slot_size, const void *src, uint8_t type)
+{
+    char tmp[MSG_FMT_BUFF_SIZE];
+    msg_tpl_slot_t *sl;
+    msg_size_t i;
+
+    if(tpl->slot_cnt >= slot_size) return 0;
+    sl = &tpl->slot[tpl->slot_cnt++];
+    sl->src = src;
+    sl->type = type;
+    sl->pos = ctx->p - ctx->buff.s;
+    sl->width = __tpl_fmt(sl, tmp);
+    if(sl->width < MCU_MSG_TPL_SLOT_WIDTH) sl->width = MCU_MSG_TPL_SLOT_WIDTH;
+    for(i = 0; i < sl->width; i++) __msg_putc(ctx, ' ');
+    return 1;
+}
+
+/**
+ * @brief Write current value of slot into the template buffer, padded with spaces
+ * 
+ * @param tpl template pointer
+ * @param sl slot pointer
+ * @return uint8_t 1 if the value fits in the slot
+ */
+static uint8_t __tpl_fill(msg_template_t *tpl, msg_tpl_slot_t *sl)
+{
+    char tmp[MSG_FMT_BUFF_SIZE];
+    char *p = tpl->buff.s + sl->pos;
+    const msg_wrap_str_t *sp;
+    msg_size_t len, i;
+
+    len = __tpl_fmt(sl, tmp);
+    if(!len || len > sl->width) return 0;
+    switch(sl->type) {
+        case MSG_BLD_INT:
+            sl->last.i = ((const msg_wrap_int_t *)sl->src)->val;
+            for(i = 0; i < len; i++) p[i] = tmp[i];
+            break;
+        case MSG_BLD_FLOAT:
+            sl->last.f = ((const msg_wrap_float_t *)sl->src)->val;
+            for(i = 0; i < len; i++) p[i] = tmp[i];
+            break;
+        default:
+            sp = (const msg_wrap_str_t *)sl->src;
+            p[0] = p[len - 1] = __define_qmark(sp->content);
+            for(i = 0; i < sp->content.len; i++) p[i + 1] = sp->content.s[i];
+            break;
+    }
+    for(i = len; i < sl->width; i++) p[i] = ' ';
+    return 1;
+}
+
+/*Compile message template*/
+msg_template_t msg_template_compile(msg_wrap_t msg, char *buff, msg_size_t size, msg_tpl_slot_t *slot, msg_size_t slot_size)
+{
+    msg_template_t tpl;
+    msg_ctx_t ctx;
+    msg_wrap_obj_t *pobj;
+    msg_wrap_cmd_t *pcmd;
+    msg_wrap_int_t *ip;
+    msg_wrap_float_t *fp;
+    msg_wrap_str_t *sp;
+    msg_size_t i;
+    uint8_t sep, ok = 1;
+
+    tpl.msg = msg;
+    tpl.slot = slot;
+    tpl.slot_cnt = 0;
+    tpl.buff.s = buff;
+    tpl.buff.len = 0;
+    if(msg.id.s == NULL || buff == NULL || !size) {
+        msg_destroy_str(&tpl.buff);
+        return tpl;
+    }
+
+    /*Render constant parts and reserve value slots*/
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_init_str_buff(&ctx, buff, size);
+    msg_ctx_enable_buff(&ctx);
+    __print_msg_start(&ctx, msg);
+    for(pcmd = msg.cmd_queue; pcmd != NULL; pcmd = pcmd->next) __msg_wrapper_print_cmd(&ctx, *pcmd);
+    for(pobj = msg.obj_queue; pobj != NULL && ok; pobj = pobj->next) {
+        __print_obj_start(&ctx, (*pobj));
+        sep = 0;
+        for(ip = pobj->int_queue; ip != NULL && ok; ip = ip->next) {
+            __print_key_sep(&ctx, sep);
+            __print_key_equ(&ctx, ip->id);
+            ok = __tpl_reserve(&ctx, &tpl, slot_size, ip, MSG_BLD_INT);
+        }
+        for(fp = pobj->float_queue; fp != NULL && ok; fp = fp->next) {
+            __print_key_sep(&ctx, sep);
+            __print_key_equ(&ctx, fp->id);
+            ok = __tpl_reserve(&ctx, &tpl, slot_size, fp, MSG_BLD_FLOAT);
+        }
+        for(sp = pobj->string_queue; sp != NULL && ok; sp = sp->next) {
+            __print_key_sep(&ctx, sep);
+            __print_key_equ(&ctx, sp->id);
+            ok = __tpl_reserve(&ctx, &tpl, slot_size, sp, MSG_BLD_STR);
+        }
+        __msg_putc(&ctx, __CTRL_STOP_OBJ);
+    }
+    __msg_putc(&ctx, __CTRL_STOP_MSG);
+    tpl.buff.len = ctx.p - buff;
+    if(ctx.overflow) ok = 0; // buffer is too small, the message is truncated
+
+    /*Render the initial values*/
+    for(i = 0; ok && i < tpl.slot_cnt; i++) ok = __tpl_fill(&tpl, &slot[i]);
+    if(!ok) msg_destroy_str(&tpl.buff);
+    return tpl;
+}
+
+/*Render current values into template*/
+msg_str_t msg_template_render(msg_template_t *tpl)
+{
+    msg_tpl_slot_t *sl;
+    msg_str_t res;
+    msg_size_t i;
+
+    msg_destroy_str(&res);
+    if(tpl->buff.s == NULL) return res;
+    for(i = 0; i < tpl->slot_cnt; i++) {
+        sl = &tpl->slot[i];
+        if(sl->type == MSG_BLD_INT && sl->last.i == ((const msg_wrap_int_t *)sl->src)->val) continue;
+        if(sl->type == MSG_BLD_FLOAT && sl->last.f == ((const msg_wrap_float_t *)sl->src)->val) continue;
+        if(!__tpl_fill(tpl, sl)) return res;
+    }
+    return tpl->buff;
+}
+
+/*Print message template*/
+void msg_ctx_print_template(msg_ctx_t *ctx, msg_template_t *tpl)
+{
+    msg_str_t str = msg_template_render(tpl);
+
+    if(str.s == NULL) { // value doesn't fit, print the message whitout slots
+        msg_ctx_print_wrapper_msg(ctx, tpl->msg);
+        return;
+    }
+    __msg_write_ref(ctx, str.s, str.len);
+    msg_ctx_flush(ctx);
+}
+
+/**
+ * @brief Print message template with the default context
+ * 
+ * @param tpl template pointer
+ */
+static void __msg_template_print(msg_template_t *tpl)
+{
+    msg_ctx_print_template(&__ctx, tpl);
+}
+
+/*Measure message wrapper*/
+uint32_t msg_wrap_measure(msg_wrap_t msg)
+{
+    msg_ctx_t ctx;
+    msg_ctx_init(&ctx, NULL);
+    ctx.redir = __OUTP_COUNT;
+    msg_ctx_print_wrapper_msg(&ctx, msg);
+    return ctx.cnt;
+}
+
+/*Measure message builder*/
+uint32_t msg_builder_measure(const msg_builder_t *b)
+{
+    msg_ctx_t ctx;
+    msg_ctx_init(&ctx, NULL);
+    ctx.redir = __OUTP_COUNT;
+    msg_ctx_print_builder(&ctx, b);
+    return ctx.cnt;
+}
+
+/*Print message wrapper to buffer*/
+msg_size_t msg_wrap_print_to_buff(msg_wrap_t msg, char *buff, msg_size_t size, uint32_t *required)
+{
+    msg_ctx_t ctx;
+    uint32_t len = msg_wrap_measure(msg);
+
+    if(required != NULL) *required = len;
+    if(buff == NULL || len > size) return 0;
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_init_str_buff(&ctx, buff, size);
+    msg_ctx_enable_buff(&ctx);
+    msg_ctx_print_wrapper_msg(&ctx, msg);
+    return ctx.overflow ? 0 : ctx.p - buff; // a float value can't be printed
+}
+
+/*Print message builder to buffer*/
+msg_size_t msg_builder_print_to_buff(const msg_builder_t *b, char *buff, msg_size_t size, uint32_t *required)
+{
+    msg_ctx_t ctx;
+    uint32_t len = msg_builder_measure(b);
+
+    if(required != NULL) *required = len;
+    if(buff == NULL || len > size) return 0;
+    msg_ctx_init(&ctx, NULL);
+    msg_ctx_init_str_buff(&ctx, buff, size);
+    msg_ctx_enable_buff(&ctx);
+    msg_ctx_print_builder(&ctx, b);
+    return ctx.overflow ? 0 : ctx.p - buff; // a float value can't be printed
+}
+#endif 
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                     Binary encoding                                     //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_BIN
+
+/*Zigzag mapping of signed integers (small absolute values get short varints)*/
+#define __zigzag(v)               ((v) < 0 ? ~((uint64_t)(v) << 1) : (uint64_t)(v) << 1)
+#define __unzigzag(u)             (((u) & 1) ? -(int64_t)((u) >> 1) - 1 : (int64_t)((u) >> 1))
+
+/**
+ * @brief Read unsigned LEB128 varint
+ * 
+ * @param p varint start
+ * @param end end of the container
+ * @param v result
+ * @return char* position after the varint or NULL if it is broken
+ */
+static char *__bin_get_uvar(char *p, char *end, uint64_t *v)
+{
+    uint8_t shift = 0, b;
+
+    *v = 0;
+    while(p < end && shift < 64) {
+        b = (uint8_t)*p++;
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if(!(b & 0x80)) return p;
+        shift += 7;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Write unsigned LEB128 varint
+ * 
+ * @param ctx context of destination buffer
+ * @param v value
+ */
+static void __bin_put_uvar(msg_ctx_t *ctx, uint64_t v)
+{
+    char buff[10];
+    uint8_t n = 0;
+
+    while(v >= 0x80) {
+        buff[n++] = (char)(v | 0x80);
+        v >>= 7;
+    }
+    buff[n++] = (char)v;
+    __msg_write(ctx, buff, n);
+}
+
+/**
+ * @brief Write element tag and id
+ * 
+ * @param ctx context of destination buffer
+ * @param tag element tag
+ * @param id id string
+ */
+static void __bin_put_head(msg_ctx_t *ctx, uint8_t tag, msg_str_t id)
+{
+    __msg_putc(ctx, (char)tag);
+    __bin_put_uvar(ctx, id.len);
+    __msg_write(ctx, id.s, id.len);
+}
+
+/**
+ * @brief Write float as 4 byte little endian IEEE 754
+ * 
+ * @param ctx context of destination buffer
+ * @param f value
+ */
+static void __bin_put_float(msg_ctx_t *ctx, float f)
+{
+    union {
+        float    f;
+        uint32_t u;
+    } v;
+    char buff[4];
+    uint8_t i;
+
+    v.f = f;
+    for(i = 0; i < 4; i++) buff[i] = (char)(v.u >> (8 * i));
+    __msg_write(ctx, buff, 4);
+}
+
+/**
+ * @brief Close length prefixed value. One byte is reserved for the length,
+ * the value is moved if its length needs a longer varint
+ * 
+ * @param ctx context of destination buffer
+ * @param lenp reserved length byte
+ */
+static void __bin_close(msg_ctx_t *ctx, char *lenp)
+{
+    char buff[10];
+    uint64_t n = ctx->p - lenp - 1;
+    uint8_t w = 0, i;
+    char *q;
+
+    if(ctx->overflow) return;
+    while(n >= 0x80) {
+        buff[w++] = (char)(n | 0x80);
+        n >>= 7;
+    }
+    buff[w++] = (char)n;
+    if(w > 1) {
+        if(ctx->buff.len - (ctx->p - ctx->buff.s) < w - 1) {
+            ctx->overflow = 1;
+            return;
+        }
+        for(q = ctx->p - 1; q > lenp; q--) q[w - 1] = *q;
+        ctx->p += w - 1;
+    }
+    for(i = 0; i < w; i++) lenp[i] = buff[i];
+}
+
+/**
+ * @brief Read the next element of binary content
+ * 
+ * @param str binary content
+ * @param p element start
+ * @param e result element
+ * @return char* position after the element or NULL if there is no more element or it is broken
+ */
+static char *__bin_elem(msg_str_t str, char *p, __msg_bin_elem_t *e)
+{
+    char *end = str.s + str.len;
+    uint64_t n;
+
+    if(p == NULL || p >= end) return NULL;
+    e->tag = (uint8_t)*p++;
+    if((p = __bin_get_uvar(p, end, &n)) == NULL || n > (uint64_t)(end - p)) return NULL;
+    e->id.s = p;
+    e->id.len = n;
+    p += n;
+    e->val.s = p;
+    switch(e->tag) {
+        case MSG_BIN_CMD:
+        break;
+        case MSG_BIN_INT:
+            if((p = __bin_get_uvar(p, end, &n)) == NULL) return NULL;
+        break;
+        case MSG_BIN_FLOAT:
+            if(end - p < 4) return NULL;
+            p += 4;
+        break;
+        case MSG_BIN_DEC: // mantissa and count of fraction digits
+            if((p = __bin_get_uvar(p, end, &n)) == NULL || p >= end) return NULL;
+            p++;
+        break;
+        case MSG_BIN_MSG:
+        case MSG_BIN_OBJ:
+        case MSG_BIN_STR:
+        case MSG_BIN_STR_SQ:
+        case MSG_BIN_RAW:
+            if((p = __bin_get_uvar(p, end, &n)) == NULL || n > (uint64_t)(end - p)) return NULL;
+            e->val.s = p;
+            p += n;
+        break;
+        default:
+            return NULL;
+    }
+    e->val.len = p - e->val.s;
+    return p;
+}
+
+/**
+ * @brief Find element by tag range and id in binary content (objects are skipped)
+ * 
+ * @param str binary content
+ * @param tag_min first accepted tag
+ * @param tag_max last accepted tag
+ * @param id id
+ * @param e result element
+ * @return uint8_t 1 if found
+ */
+static uint8_t __bin_find(msg_str_t str, uint8_t tag_min, uint8_t tag_max, char *id, __msg_bin_elem_t *e)
+{
+    char *p = str.s;
+
+    while((p = __bin_elem(str, p, e)) != NULL) {
+        if(e->tag >= tag_min && e->tag <= tag_max && __keyword_eq(e->id, id)) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read number element as decimal number
+ * 
+ * @param e element (MSG_BIN_INT or MSG_BIN_DEC)
+ * @param num result
+ */
+static void __bin_to_num(const __msg_bin_elem_t *e, __msg_num_t *num)
+{
+    uint64_t u;
+    int64_t v;
+    char *p = __bin_get_uvar(e->val.s, e->val.s + e->val.len, &u);
+
+    v = __unzigzag(u);
+    num->neg = v < 0;
+    num->m = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    num->exp = e->tag == MSG_BIN_DEC ? -(int32_t)(uint8_t)*p : 0;
+    num->trunc = 0;
+}
+
+/**
+ * @brief Read float element
+ * 
+ * @param e element (MSG_BIN_FLOAT)
+ * @return float value
+ */
+static float __bin_to_float(const __msg_bin_elem_t *e)
+{
+    union {
+        float    f;
+        uint32_t u;
+    } v;
+    uint8_t i;
+
+    v.u = 0;
+    for(i = 0; i < 4; i++) v.u |= (uint32_t)(uint8_t)e->val.s[i] << (8 * i);
+    return v.f;
+}
+
+/*Get binary message by id*/
+msg_t msg_bin_get(char *buff, char *id, msg_size_t len)
+{
+    msg_t res;
+    msg_str_t str;
+    __msg_bin_elem_t e;
+
+    str.s = buff;
+    str.len = len;
+    if(buff != NULL && __bin_find(str, MSG_BIN_MSG, MSG_BIN_MSG, id, &e)) {
+        res.id = e.id;
+        res.content = e.val;
+        return res;
+    }
+    msg_destroy(&res);
+    return res;
+}
+
+/*Get next binary message*/
+msg_t msg_bin_next(char *buff, msg_size_t len, msg_size_t *cursor)
+{
+    msg_t res;
+    msg_str_t str;
+    __msg_bin_elem_t e;
+    char *p;
+
+    str.s = buff;
+    str.len = len;
+    p = buff != NULL && *cursor < len ? buff + *cursor : NULL;
+    while((p = __bin_elem(str, p, &e)) != NULL) {
+        if(e.tag == MSG_BIN_MSG) {
+            *cursor = p - buff;
+            res.id = e.id;
+            res.content = e.val;
+            return res;
+        }
+    }
+    msg_destroy(&res);
+    return res;
+}
+
+/*Get object of binary message*/
+msg_obj_t msg_bin_get_obj(msg_t msg, char *id)
+{
+    msg_obj_t res;
+    __msg_bin_elem_t e;
+
+    if(__bin_find(msg.content, MSG_BIN_OBJ, MSG_BIN_OBJ, id, &e)) {
+        res.id = e.id;
+        res.content = e.val;
+        return res;
+    }
+    msg_destroy_obj(&res);
+    return res;
+}
+
+/*Get command of binary message*/
+msg_cmd_t msg_bin_get_cmd(msg_t msg, char *cmd)
+{
+    msg_cmd_t res;
+    __msg_bin_elem_t e;
+
+    if(__bin_find(msg.content, MSG_BIN_CMD, MSG_BIN_CMD, cmd, &e)) {
+        res.cmd = e.id;
+        return res;
+    }
+    msg_destroy_cmd(&res);
+    return res;
+}
+
+/*Get 64 bit integer of binary object*/
+uint8_t msg_bin_get_int64(int64_t *res, msg_obj_t obj, char *key)
+{
+    __msg_bin_elem_t e;
+    __msg_num_t num;
+    uint64_t u;
+    float f;
+
+    if(!__bin_find(obj.content, MSG_BIN_INT, MSG_BIN_RAW, key, &e)) return 0;
+    switch(e.tag) {
+        case MSG_BIN_INT:
+            __bin_get_uvar(e.val.s, e.val.s + e.val.len, &u);
+            *res = __unzigzag(u);
+            return e.val.len;
+        case MSG_BIN_DEC: // converted if the fraction digits are zeros
+            __bin_to_num(&e, &num);
+            for(; num.exp < 0; num.exp++) {
+                if(num.m % 10) return 0;
+                num.m /= 10;
+            }
+            if(num.m > (num.neg ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX)) return MSG_NUM_OVERFLOW;
+            *res = (num.neg && num.m) ? -(int64_t)(num.m - 1) - 1 : (int64_t)num.m;
+            return e.val.len;
+        case MSG_BIN_FLOAT: // converted if it has integer value
+            f = __bin_to_float(&e);
+            if(!(f >= -9223372036854775808.0f && f < 9223372036854775808.0f)) return f == f ? MSG_NUM_OVERFLOW : 0;
+            if((float)(int64_t)f != f) return 0;
+            *res = (int64_t)f;
+            return e.val.len;
+        case MSG_BIN_RAW:
+            return __str_to_int64(res, e.val);
+        default:
+            return 0;
+    }
+}
+
+/*Get integer of binary object*/
+uint8_t msg_bin_get_int(int *res, msg_obj_t obj, char *key)
+{
+    int64_t v;
+    uint8_t r = msg_bin_get_int64(&v, obj, key);
+
+    if(!msg_num_ok(r)) return r;
+    if(v < INT_MIN || v > INT_MAX) return MSG_NUM_OVERFLOW;
+    *res = (int)v;
+    return r;
+}
+
+/*Get double of binary object*/
+uint8_t msg_bin_get_double(double *res, msg_obj_t obj, char *key)
+{
+    __msg_bin_elem_t e;
+    __msg_num_t num;
+
+    if(!__bin_find(obj.content, MSG_BIN_INT, MSG_BIN_RAW, key, &e)) return 0;
+    switch(e.tag) {
+        case MSG_BIN_INT:
+        case MSG_BIN_DEC:
+            __bin_to_num(&e, &num);
+            *res = __num_to_double(&num);
+            return e.val.len;
+        case MSG_BIN_FLOAT:
+            *res = __bin_to_float(&e);
+            return e.val.len;
+        case MSG_BIN_RAW:
+            return __str_to_double(res, e.val);
+        default:
+            return 0;
+    }
+}
+
+/*Get float of binary object*/
+uint8_t msg_bin_get_float(float *res, msg_obj_t obj, char *key)
+{
+    __msg_bin_elem_t e;
+    __msg_num_t num;
+
+    if(!__bin_find(obj.content, MSG_BIN_INT, MSG_BIN_RAW, key, &e)) return 0;
+    switch(e.tag) {
+        case MSG_BIN_INT:
+        case MSG_BIN_DEC:
+            __bin_to_num(&e, &num);
+            *res = __num_to_float(&num);
+            return e.val.len;
+        case MSG_BIN_FLOAT:
+            *res = __bin_to_float(&e);
+            return e.val.len;
+        case MSG_BIN_RAW:
+            return __str_to_float(res, e.val);
+        default:
+            return 0;
+    }
+}
+
+/*Get string of binary object*/
+msg_str_t msg_bin_get_str(msg_obj_t obj, char *key)
+{
+    __msg_bin_elem_t e;
+
+    if(__bin_find(obj.content, MSG_BIN_INT, MSG_BIN_RAW, key, &e) && (e.tag == MSG_BIN_STR || e.tag == MSG_BIN_STR_SQ)) {
+        return e.val;
+    }
+    msg_destroy_str(&e.val);
+    return e.val;
+}
+
+/**
+ * @brief Check canonical decimal number (-?(0|[1-9][0-9]*)(.[0-9]+)?, max. 18 digits), this form can be
+ * restored exactly from mantissa and count of fraction digits
+ * 
+ * @param v value
+ * @param m mantissa (absolute value)
+ * @param neg negative sign
+ * @param scale count of fraction digits
+ * @return uint8_t 1 if the value is a canonical decimal number
+ */
+static uint8_t __bin_dec(msg_str_t v, uint64_t *m, uint8_t *neg, uint8_t *scale)
+{
+    char *p = v.s, *end = v.s + v.len;
+    uint8_t dig = 0, dot = 0;
+
+    *m = 0;
+    *scale = 0;
+    *neg = p < end && *p == '-';
+    if(*neg) p++;
+    if(p >= end || *p < '0' || *p > '9') return 0;
+    if(*p == '0' && p + 1 < end && p[1] != '.') return 0; // leading zero
+    for(; p < end && *p >= '0' && *p <= '9'; p++, dig++) *m = *m * 10 + (*p - '0');
+    if(p < end && *p == '.') {
+        dot = 1;
+        for(p++; p < end && *p >= '0' && *p <= '9'; p++, dig++, (*scale)++) *m = *m * 10 + (*p - '0');
+    }
+    return p == end && dig <= 18 && !(dot && !*scale) && !(*neg && !*m); // negative zero is kept as raw text
+}
+
+/**
+ * @brief Write key token of text message as binary element
+ * 
+ * @param ctx context of destination buffer
+ * @param tok key token
+ */
+static void __bin_put_text_key(msg_ctx_t *ctx, const msg_index_rec_t *tok)
+{
+    msg_str_t v = tok->val;
+    uint64_t m;
+    uint8_t neg, scale;
+
+    if(v.len >= 2 && (*v.s == '"' || *v.s == '\'') && v.s[v.len - 1] == *v.s) { // closed string
+        __bin_put_head(ctx, *v.s == '"' ? MSG_BIN_STR : MSG_BIN_STR_SQ, tok->id);
+        __bin_put_uvar(ctx, v.len - 2);
+        __msg_write(ctx, v.s + 1, v.len - 2);
+    } else if(__bin_dec(v, &m, &neg, &scale)) {
+        __bin_put_head(ctx, scale ? MSG_BIN_DEC : MSG_BIN_INT, tok->id);
+        __bin_put_uvar(ctx, neg ? __zigzag(-(int64_t)m) : __zigzag((int64_t)m));
+        if(scale) __msg_putc(ctx, (char)scale);
+    } else {
+        __bin_put_head(ctx, MSG_BIN_RAW, tok->id);
+        __bin_put_uvar(ctx, v.len);
+        __msg_write(ctx, v.s, v.len);
+    }
+}
+
+/**
+ * @brief Init context for writing into buffer
+ * 
+ * @param ctx context
+ * @param buff buffer
+ * @param size buffer size
+ */
+static void __bin_ctx_init(msg_ctx_t *ctx, char *buff, msg_size_t size)
+{
+    msg_ctx_init(ctx, NULL);
+    msg_ctx_init_str_buff(ctx, buff, size);
+    msg_ctx_enable_buff(ctx);
+}
+
+/*Transcode text message to binary*/
+msg_size_t msg_bin_from_text(msg_t msg, char *buff, msg_size_t size)
+{
+    msg_ctx_t ctx;
+    msg_index_rec_t tok;
+    msg_str_t obj;
+    char *p = msg.content.s, *msg_lenp, *obj_lenp = NULL;
+
+    if(msg.id.s == NULL || p == NULL || buff == NULL) return 0;
+    __bin_ctx_init(&ctx, buff, size);
+    __bin_put_head(&ctx, MSG_BIN_MSG, msg.id);
+    msg_lenp = ctx.p;
+    __msg_putc(&ctx, 0);
+
+    while((p = __next_token(msg.content, p, &tok)) != NULL) {
+        if(obj_lenp != NULL && (!__is_p_in_str(obj, tok.id.s) || tok.kind == MSG_TOK_OBJ)) { // left the object
+            __bin_close(&ctx, obj_lenp);
+            obj_lenp = NULL;
+        }
+        switch(tok.kind) {
+            case MSG_TOK_OBJ:
+                __bin_put_head(&ctx, MSG_BIN_OBJ, tok.id);
+                obj_lenp = ctx.p;
+                __msg_putc(&ctx, 0);
+                obj = tok.val;
+            break;
+            case MSG_TOK_CMD:
+                __bin_put_head(&ctx, MSG_BIN_CMD, tok.id);
+            break;
+            default:
+                __bin_put_text_key(&ctx, &tok);
+            break;
+        }
+    }
+    if(obj_lenp != NULL) __bin_close(&ctx, obj_lenp);
+    __bin_close(&ctx, msg_lenp);
+    return ctx.overflow ? 0 : ctx.p - buff;
+}
+
+/**
+ * @brief Print value of binary key element as text
+ * 
+ * @param ctx output context
+ * @param e key element
+ * @return uint8_t 0 if the value can't be printed whitout loss (infinite or NaN float, too many fraction digits)
+ */
+static uint8_t __bin_print_val(msg_ctx_t *ctx, const __msg_bin_elem_t *e)
+{
+    char buff[MSG_FMT_BUFF_SIZE];
+    char *end = buff + sizeof(buff), *p;
+    msg_str_t dst;
+    __msg_num_t num;
+    uint8_t scale;
+
+    switch(e->tag) {
+        case MSG_BIN_INT:
+        case MSG_BIN_DEC:
+            __bin_to_num(e, &num);
+            scale = (uint8_t)-num.exp;
+            if(scale > MSG_FMT_MAX_PREC) return 0;
+            p = __fmt_uint(end, num.m, scale + 1);
+            if(num.neg) __msg_putc(ctx, '-');
+            __msg_write(ctx, p, end - p - scale);
+            if(scale) {
+                __msg_putc(ctx, '.');
+                __msg_write(ctx, end - scale, scale);
+            }
+        return 1;
+        case MSG_BIN_FLOAT:
+            dst.s = buff;
+            dst.len = sizeof(buff);
+            dst.len = msg_fmt_float(dst, __bin_to_float(e), MSG_FMT_SHORTEST); // every finite float fits
+            __msg_write(ctx, buff, dst.len);
+        return dst.len != 0;
+        case MSG_BIN_STR:
+        case MSG_BIN_STR_SQ:
+            __msg_putc(ctx, e->tag == MSG_BIN_STR ? '"' : '\'');
+            __msg_write(ctx, e->val.s, e->val.len);
+            __msg_putc(ctx, e->tag == MSG_BIN_STR ? '"' : '\'');
+        return 1;
+        default: // raw text
+            __msg_write(ctx, e->val.s, e->val.len);
+        return 1;
+    }
+}
+
+/**
+ * @brief Print binary content (of message or object) as text
+ * 
+ * @param ctx output context
+ * @param content binary content
+ * @return uint8_t 0 if the binary content is broken
+ */
+static uint8_t __bin_print_text(msg_ctx_t *ctx, msg_str_t content)
+{
+    __msg_bin_elem_t e;
+    char *p = content.s, *end = content.s + content.len;
+    uint8_t sep = 0;
+
+    while(p < end) {
+        if((p = __bin_elem(content, p, &e)) == NULL) return 0;
+        switch(e.tag) {
+            case MSG_BIN_MSG: // no nested messages
+                return 0;
+            case MSG_BIN_CMD:
+                __msg_putc(ctx, __CTRL_CMD_START_FLAG);
+                __msg_write_id(ctx, e.id);
+                __msg_putc(ctx, __CTRL_CMD_STOP_FLAG);
+            break;
+            case MSG_BIN_OBJ:
+                __print_obj_start(ctx, e);
+                if(!__bin_print_text(ctx, e.val)) return 0;
+                __msg_putc(ctx, __CTRL_STOP_OBJ);
+            break;
+            default:
+                __print_key_sep(ctx, sep);
+                __print_key_equ(ctx, e.id);
+                if(!__bin_print_val(ctx, &e)) return 0;
+            break;
+        }
+    }
+    return 1;
+}
+
+/*Transcode binary message to text*/
+msg_size_t msg_bin_to_text(msg_t msg, char *buff, msg_size_t size)
+{
+    msg_ctx_t ctx;
+    uint8_t ok;
+
+    if(msg.id.s == NULL || msg.content.s == NULL || buff == NULL) return 0;
+    __bin_ctx_init(&ctx, buff, size);
+    __print_msg_start(&ctx, msg);
+    ok = __bin_print_text(&ctx, msg.content);
+    __msg_putc(&ctx, __CTRL_STOP_MSG);
+    return ok && !ctx.overflow ? ctx.p - buff : 0;
+}
+
+ #if MCU_MSG_USE_WRAPPER
+/*Encode message wrapper to binary*/
+msg_size_t msg_bin_wrap(msg_wrap_t msg, char *buff, msg_size_t size)
+{
+    msg_ctx_t ctx;
+    msg_wrap_obj_t *pobj;
+    msg_wrap_cmd_t *pcmd;
+    msg_wrap_int_t *ip;
+    msg_wrap_float_t *fp;
+    msg_wrap_str_t *sp;
+    char *msg_lenp, *obj_lenp;
+
+    if(msg.id.s == NULL || buff == NULL) return 0;
+    __bin_ctx_init(&ctx, buff, size);
+    __bin_put_head(&ctx, MSG_BIN_MSG, msg.id);
+    msg_lenp = ctx.p;
+    __msg_putc(&ctx, 0);
+
+    for(pcmd = msg.cmd_queue; pcmd != NULL; pcmd = pcmd->next) {
+        if(pcmd->cmd.s != NULL) __bin_put_head(&ctx, MSG_BIN_CMD, pcmd->cmd);
+    }
+    for(pobj = msg.obj_queue; pobj != NULL; pobj = pobj->next) {
+        __bin_put_head(&ctx, MSG_BIN_OBJ, pobj->id);
+        obj_lenp = ctx.p;
+        __msg_putc(&ctx, 0);
+        for(ip = pobj->int_queue; ip != NULL; ip = ip->next) {
+            __bin_put_head(&ctx, MSG_BIN_INT, ip->id);
+            __bin_put_uvar(&ctx, __zigzag((int64_t)ip->val));
+        }
+        for(fp = pobj->float_queue; fp != NULL; fp = fp->next) {
+            __bin_put_head(&ctx, MSG_BIN_FLOAT, fp->id);
+            __bin_put_float(&ctx, fp->val);
+        }
+        for(sp = pobj->string_queue; sp != NULL; sp = sp->next) {
+            __bin_put_head(&ctx, __define_qmark(sp->content) == '"' ? MSG_BIN_STR : MSG_BIN_STR_SQ, sp->id);
+            __bin_put_uvar(&ctx, sp->content.len);
+            __msg_write(&ctx, sp->content.s, sp->content.len);
+        }
+        __bin_close(&ctx, obj_lenp);
+    }
+    __bin_close(&ctx, msg_lenp);
+    return ctx.overflow ? 0 : ctx.p - buff;
+}
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                   Session dictionary                                    //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_DICT
+
+/**
+ * @brief Find registered id
+ * 
+ * @param dict dictionary
+ * @param id id string
+ * @return msg_size_t token number or MSG_DICT_NONE if not registered
+ */
+static msg_size_t __dict_find(const msg_dict_t *dict, msg_str_t id)
+{
+    msg_size_t i, k;
+
+    if(id.s == NULL || !id.len) return MSG_DICT_NONE;
+    for(i = 0; i < dict->cnt; i++) {
+        if(dict->ids[i].len != id.len || dict->ids[i].s[0] != id.s[0]) continue;
+        for(k = 1; k < id.len && dict->ids[i].s[k] == id.s[k]; k++);
+        if(k == id.len) return i;
+    }
+    return MSG_DICT_NONE;
+}
+
+/**
+ * @brief Format token of registered id, the token is used only if it is shorter than the id
+ * 
+ * @param dict dictionary
+ * @param id id string
+ * @param tok token buffer (__DICT_TOK_SIZE), terminated with '\0'
+ * @return msg_size_t token length, 0 if the literal id is used
+ */
+static msg_size_t __dict_token(const msg_dict_t *dict, msg_str_t id, char *tok)
+{
+    char buff[__DICT_TOK_SIZE];
+    char *end = buff + sizeof(buff), *p;
+    msg_size_t i = __dict_find(dict, id), n;
+
+    if(i == MSG_DICT_NONE) return 0;
+    p = __fmt_uint(end, i, 1);
+    n = end - p + 1;
+    if(n >= id.len) return 0;
+    tok[0] = MSG_DICT_TOKEN;
+    for(i = 1; i < n; i++) tok[i] = *p++;
+    tok[n] = '\0';
+    return n;
+}
+
+/**
+ * @brief Format token of registered id given as C string
+ * 
+ * @param dict dictionary
+ * @param key id string
+ * @param tok token buffer (__DICT_TOK_SIZE)
+ * @return msg_size_t token length, 0 if the literal id is used
+ */
+static msg_size_t __dict_key_token(const msg_dict_t *dict, char *key, char *tok)
+{
+    msg_str_t id;
+
+    if(dict == NULL || key == NULL) return 0;
+    id.s = key;
+    id.len = __str_len(key);
+    return __dict_token(dict, id, tok);
+}
+
+/*Create session dictionary*/
+msg_dict_t msg_dict_create(msg_str_t *ids, msg_size_t size, char *pool, msg_size_t pool_size)
+{
+    msg_dict_t dict;
+
+    dict.ids = ids;
+    dict.size = ids != NULL ? size : 0;
+    dict.cnt = 0;
+    dict.pool = pool;
+    dict.pool_size = pool != NULL ? pool_size : 0;
+    dict.pool_len = 0;
+    return dict;
+}
+
+/*Register id*/
+msg_size_t msg_dict_add(msg_dict_t *dict, char *id)
+{
+    msg_str_t str;
+    msg_size_t i;
+
+    if(id == NULL) return MSG_DICT_NONE;
+    str.s = id;
+    str.len = __str_len(id);
+    if((i = __dict_find(dict, str)) != MSG_DICT_NONE) return i;
+    if(dict->cnt >= dict->size || !str.len) return MSG_DICT_NONE;
+    dict->ids[dict->cnt] = str;
+    return dict->cnt++;
+}
+
+/*Resolve received id*/
+msg_str_t msg_dict_resolve(const msg_dict_t *dict, msg_str_t id)
+{
+    uint64_t n = 0;
+    msg_size_t i;
+
+    if(dict == NULL || id.s == NULL || id.len < 2 || id.s[0] != MSG_DICT_TOKEN) return id;
+    for(i = 1; i < id.len; i++) {
+        if(id.s[i] < '0' || id.s[i] > '9' || n >= dict->cnt) return id;
+        n = n * 10 + (id.s[i] - '0');
+    }
+    return n < dict->cnt ? dict->ids[n] : id;
+}
+
+/*Set dictionary of context*/
+void msg_ctx_set_dict(msg_ctx_t *ctx, const msg_dict_t *dict)
+{
+    ctx->dict = dict;
+}
+
+/*Print announce message of dictionary*/
+void msg_ctx_print_dict(msg_ctx_t *ctx, const msg_dict_t *dict)
+{
+    msg_size_t i;
+
+    __msg_putc(ctx, __CTRL_MSG_FLAG);
+    __msg_write(ctx, MSG_DICT_MSG_ID, sizeof(MSG_DICT_MSG_ID) - 1);
+    __msg_putc(ctx, __CTRL_START_MSG);
+    for(i = 0; i < dict->cnt; i++) { // always literal ids
+        __msg_putc(ctx, __CTRL_CMD_START_FLAG);
+        __msg_write(ctx, dict->ids[i].s, dict->ids[i].len);
+        __msg_putc(ctx, __CTRL_CMD_STOP_FLAG);
+    }
+    __msg_putc(ctx, __CTRL_STOP_MSG);
+    msg_ctx_flush(ctx);
+}
+
+/*Learn dictionary from announce message*/
+msg_size_t msg_dict_learn(msg_dict_t *dict, msg_t msg)
+{
+    msg_index_rec_t tok;
+    char *p = msg.content.s;
+    msg_size_t i = 0, k;
+
+    if(p == NULL || !__keyword_eq(msg.id, MSG_DICT_MSG_ID)) return 0;
+    dict->pool_len = 0;
+    while((p = __next_token(msg.content, p, &tok)) != NULL) {
+        if(tok.kind != MSG_TOK_CMD) continue;
+        if(dict->pool == NULL) { // registered ids are checked
+            if(i >= dict->cnt || __dict_find(dict, tok.id) != i) return 0;
+        } else { // announced ids are copied
+            if(i >= dict->size || dict->pool_size - dict->pool_len < tok.id.len) {
+                dict->cnt = 0;
+                return 0;
+            }
+            dict->ids[i].s = dict->pool + dict->pool_len;
+            dict->ids[i].len = tok.id.len;
+            for(k = 0; k < tok.id.len; k++) dict->pool[dict->pool_len++] = tok.id.s[k];
+        }
+        i++;
+    }
+    if(dict->pool == NULL && i != dict->cnt) return 0;
+    dict->cnt = i;
+    return i;
+}
+
+/*Get message by id or token*/
+msg_t msg_dict_get(const msg_dict_t *dict, char *raw_str, char *id, msg_size_t len)
+{
+    char tok[__DICT_TOK_SIZE];
+    msg_t res;
+
+    if(__dict_key_token(dict, id, tok)) {
+        res = msg_get(raw_str, tok, len);
+        if(res.id.s != NULL) {
+            res.id = msg_dict_resolve(dict, res.id);
+            return res;
+        }
+    }
+    return msg_get(raw_str, id, len);
+}
+
+/*Get object by id or token*/
+msg_obj_t msg_dict_get_obj(const msg_dict_t *dict, msg_t msg, char *id)
+{
+    char tok[__DICT_TOK_SIZE];
+    msg_obj_t res;
+
+    if(__dict_key_token(dict, id, tok)) {
+        res = msg_parser_get_obj(msg, tok);
+        if(res.id.s != NULL) {
+            res.id = msg_dict_resolve(dict, res.id);
+            return res;
+        }
+    }
+    return msg_parser_get_obj(msg, id);
+}
+
+/*Get command by id or token*/
+msg_cmd_t msg_dict_get_cmd(const msg_dict_t *dict, msg_t msg, char *cmd_id)
+{
+    char tok[__DICT_TOK_SIZE];
+    msg_cmd_t res;
+
+    if(__dict_key_token(dict, cmd_id, tok)) {
+        res = msg_parser_get_cmd(msg, tok);
+        if(res.cmd.s != NULL) {
+            res.cmd = msg_dict_resolve(dict, res.cmd);
+            return res;
+        }
+    }
+    return msg_parser_get_cmd(msg, cmd_id);
+}
+
+/*Get integer by key or token*/
+uint8_t msg_dict_get_int(int *res, const msg_dict_t *dict, msg_obj_t obj, char *key)
+{
+    char tok[__DICT_TOK_SIZE];
+    uint8_t r;
+
+    if(__dict_key_token(dict, key, tok) && (r = msg_parser_get_int(res, obj, tok)) != 0) return r;
+    return msg_parser_get_int(res, obj, key);
+}
+
+/*Get 64 bit integer by key or token*/
+uint8_t msg_dict_get_int64(int64_t *res, const msg_dict_t *dict, msg_obj_t obj, char *key)
+{
+    char tok[__DICT_TOK_SIZE];
+    uint8_t r;
+
+    if(__dict_key_token(dict, key, tok) && (r = msg_parser_get_int64(res, obj, tok)) != 0) return r;
+    return msg_parser_get_int64(res, obj, key);
+}
+
+/*Get float by key or token*/
+uint8_t msg_dict_get_float(float *res, const msg_dict_t *dict, msg_obj_t obj, char *key)
+{
+    char tok[__DICT_TOK_SIZE];
+    uint8_t r;
+
+    if(__dict_key_token(dict, key, tok) && (r = msg_parser_get_float(res, obj, tok)) != 0) return r;
+    return msg_parser_get_float(res, obj, key);
+}
+
+/*Get double by key or token*/
+uint8_t msg_dict_get_double(double *res, const msg_dict_t *dict, msg_obj_t obj, char *key)
+{
+    char tok[__DICT_TOK_SIZE];
+    uint8_t r;
+
+    if(__dict_key_token(dict, key, tok) && (r = msg_parser_get_double(res, obj, tok)) != 0) return r;
+    return msg_parser_get_double(res, obj, key);
+}
+
+/*Get string by key or token*/
+msg_str_t msg_dict_get_str(const msg_dict_t *dict, msg_obj_t obj, char *key)
+{
+    char tok[__DICT_TOK_SIZE];
+    msg_str_t res;
+
+    if(__dict_key_token(dict, key, tok)) {
+        res = msg_parser_get_str(obj, tok);
+        if(res.s != NULL) return res;
+    }
+    return msg_parser_get_str(obj, key);
+}
+
+ #if MCU_MSG_USE_WRAPPER
+/*Measure bytes saved on message wrapper*/
+uint32_t msg_dict_wrap_saved(const msg_dict_t *dict, msg_wrap_t msg)
+{
+    msg_ctx_t ctx;
+    msg_ctx_init(&ctx, NULL);
+    ctx.redir = __OUTP_COUNT;
+    ctx.dict = dict;
+    msg_ctx_print_wrapper_msg(&ctx, msg);
+    return msg_wrap_measure(msg) - ctx.cnt;
+}
+
+/*Measure bytes saved on message builder*/
+uint32_t msg_dict_builder_saved(const msg_dict_t *dict, const msg_builder_t *b)
+{
+    msg_ctx_t ctx;
+    msg_ctx_init(&ctx, NULL);
+    ctx.redir = __OUTP_COUNT;
+    ctx.dict = dict;
+    msg_ctx_print_builder(&ctx, b);
+    return msg_builder_measure(b) - ctx.cnt;
+}
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                       Delta mode                                        //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_DELTA
+
+/**
+ * @brief FNV-1a hash of string
+ * 
+ * @param str string
+ * @param h initial value (__FNV_OFFSET or hash of the previous string)
+ * @return uint32_t hash
+ */
+static uint32_t __hash_str(msg_str_t str, uint32_t h)
+{
+    msg_size_t i;
+
+    for(i = 0; i < str.len; i++) {
+        h ^= (uint8_t)str.s[i];
+        h *= __FNV_PRIME;
+    }
+    return h;
+}
+
+ #if MCU_MSG_USE_WRAPPER
+/**
+ * @brief Check that the slots are bound to the keys of the wrapper in printing order
+ * 
+ * @param d delta stream
+ * @return uint8_t 1 if the shape of the wrapper is the same as at the binding
+ */
+static uint8_t __delta_bound(const msg_delta_t *d)
+{
+    msg_wrap_obj_t *pobj;
+    msg_wrap_int_t *ip;
+    msg_wrap_float_t *fp;
+    msg_wrap_str_t *sp;
+    msg_size_t n = 0;
+
+    for(pobj = d->msg.obj_queue; pobj != NULL; pobj = pobj->next) {
+        for(ip = pobj->int_queue; ip != NULL; ip = ip->next) {
+            if(n >= d->slot_cnt || d->slot[n++].src != ip) return 0;
+        }
+        for(fp = pobj->float_queue; fp != NULL; fp = fp->next) {
+            if(n >= d->slot_cnt || d->slot[n++].src != fp) return 0;
+        }
+        for(sp = pobj->string_queue; sp != NULL; sp = sp->next) {
+            if(n >= d->slot_cnt || d->slot[n++].src != sp) return 0;
+        }
+    }
+    return n == d->slot_cnt;
+}
+
+/**
+ * @brief Bind one slot per key in printing order, slot_cnt is 0 if the keys don't fit
+ * 
+ * @param d delta stream
+ */
+static void __delta_bind(msg_delta_t *d)
+{
+    msg_wrap_obj_t *pobj;
+    msg_wrap_int_t *ip;
+    msg_wrap_float_t *fp;
+    msg_wrap_str_t *sp;
+    msg_size_t n = 0;
+
+    d->slot_cnt = 0;
+    for(pobj = d->msg.obj_queue; pobj != NULL; pobj = pobj->next) {
+        for(ip = pobj->int_queue; ip != NULL; ip = ip->next) n++;
+        for(fp = pobj->float_queue; fp != NULL; fp = fp->next) n++;
+        for(sp = pobj->string_queue; sp != NULL; sp = sp->next) n++;
+    }
+    if(d->slot == NULL || n > d->slot_size) return; // every message is a keyframe
+    for(pobj = d->msg.obj_queue; pobj != NULL; pobj = pobj->next) {
+        for(ip = pobj->int_queue; ip != NULL; ip = ip->next) {
+            d->slot[d->slot_cnt].src = ip;
+            d->slot[d->slot_cnt++].type = MSG_BLD_INT;
+        }
+        for(fp = pobj->float_queue; fp != NULL; fp = fp->next) {
+            d->slot[d->slot_cnt].src = fp;
+            d->slot[d->slot_cnt++].type = MSG_BLD_FLOAT;
+        }
+        for(sp = pobj->string_queue; sp != NULL; sp = sp->next) {
+            d->slot[d->slot_cnt].src = sp;
+            d->slot[d->slot_cnt++].type = MSG_BLD_STR;
+        }
+    }
+}
+
+/*Create delta stream*/
+msg_delta_t msg_delta_create(msg_wrap_t msg, msg_delta_slot_t *slot, msg_size_t slot_size, char *pool,
+                             msg_size_t pool_size, uint16_t period)
+{
+    msg_delta_t d;
+
+    d.msg = msg;
+    d.period = period;
+    d.frame = 0;
+    d.key = 1;
+    d.slot = slot;
+    d.slot_size = slot != NULL ? slot_size : 0;
+    d.pool = pool;
+    d.pool_size = pool != NULL ? pool_size : 0;
+    d.pool_len = 0;
+    __delta_bind(&d);
+    return d;
+}
+
+/*Send keyframe next time*/
+void msg_delta_keyframe(msg_delta_t *d)
+{
+    d->key = 1;
+}
+
+/**
+ * @brief Drop the string copies, the pool is filled again by the keyframe
+ * 
+ * @param d delta stream
+ */
+static void __delta_clear(msg_delta_t *d)
+{
+    msg_size_t i;
+
+    d->pool_len = 0;
+    for(i = 0; i < d->slot_cnt; i++) {
+        if(d->slot[i].type != MSG_BLD_STR) continue;
+        d->slot[i].last.str.s.s = NULL;
+        d->slot[i].last.str.s.len = d->slot[i].last.str.cap = 0;
+    }
+}
+
+/**
+ * @brief Store copy of the sent string, longer strings are stored at the end of the pool
+ * 
+ * @param d delta stream
+ * @param sl slot of the key
+ * @param str sent string
+ */
+static void __delta_store(msg_delta_t *d, msg_delta_slot_t *sl, msg_str_t str)
+{
+    msg_size_t cap, i;
+
+    if(str.len > sl->last.str.cap) {
+        cap = str.len > MCU_MSG_STATE_VAL_SIZE ? str.len : MCU_MSG_STATE_VAL_SIZE;
+        if(d->pool_size - d->pool_len < cap) { // it's sent every time until the next keyframe
+            sl->last.str.s.s = NULL;
+            sl->last.str.s.len = sl->last.str.cap = 0;
+            return;
+        }
+        sl->last.str.s.s = d->pool + d->pool_len;
+        sl->last.str.cap = cap;
+        d->pool_len += cap;
+    }
+    for(i = 0; i < str.len; i++) sl->last.str.s.s[i] = str.s[i];
+    sl->last.str.s.len = str.len;
+}
+
+/**
+ * @brief Compare key with its last sent value and store the current value
+ * 
+ * @param d delta stream
+ * @param sl slot of the key
+ * @param key keyframe, the value is sent anyway
+ * @param src source wrapper of the key
+ * @return uint8_t 1 if the key has to be sent
+ */
+static uint8_t __delta_changed(msg_delta_t *d, msg_delta_slot_t *sl, uint8_t key, const void *src)
+{
+    uint8_t changed = key;
+    int i;
+    float f;
+    uint32_t h;
+    msg_str_t str;
+
+    if(sl == NULL) return 1;
+    switch(sl->type) {
+        case MSG_BLD_INT:
+            i = ((const msg_wrap_int_t *)src)->val;
+            changed |= i != sl->last.i;
+            sl->last.i = i;
+        break;
+        case MSG_BLD_FLOAT:
+            f = ((const msg_wrap_float_t *)src)->val;
+            changed |= f != sl->last.f;
+            sl->last.f = f;
+        break;
+        default: // hash is the quick check, equal hashes are confirmed by the stored copy
+            str = ((const msg_wrap_str_t *)src)->content;
+            h = __hash_str(str, __FNV_OFFSET);
+            if(!changed) changed = h != sl->last.str.h || sl->last.str.s.s == NULL || !__str_eq(str, sl->last.str.s);
+            sl->last.str.h = h;
+            if(changed) __delta_store(d, sl, str);
+        break;
+    }
+    return changed;
+}
+
+/*Print next message of delta stream*/
+void msg_ctx_print_delta(msg_ctx_t *ctx, msg_delta_t *d)
+{
+    msg_wrap_obj_t *pobj;
+    msg_wrap_cmd_t *pcmd;
+    msg_wrap_int_t *ip;
+    msg_wrap_float_t *fp;
+    msg_wrap_str_t *sp;
+    msg_delta_slot_t *sl, *end;
+    uint8_t key, started, sep;
+    char qmark;
+
+    if(d->msg.id.s == NULL) // return if message id is not set
+        return;
+    key = d->key || (d->period && d->frame >= d->period);
+    if(!__delta_bound(d)) { // keys were added or removed, the receiver gets the new shape in a keyframe
+        __delta_bind(d);
+        key = 1;
+    }
+    if(d->slot_cnt == 0) key = 1;
+    if(key) __delta_clear(d);
+    sl = end = d->slot;
+    if(d->slot_cnt) end += d->slot_cnt;
+    d->key = 0;
+    d->frame = key ? 1 : d->frame + 1;
+
+    __print_msg_start(ctx, d->msg);
+    for(pcmd = d->msg.cmd_queue; pcmd != NULL; pcmd = pcmd->next) __msg_wrapper_print_cmd(ctx, *pcmd);
+    if(!key) {
+        __msg_putc(ctx, __CTRL_CMD_START_FLAG);
+        __msg_write(ctx, MSG_DELTA_CMD, sizeof(MSG_DELTA_CMD) - 1);
+        __msg_putc(ctx, __CTRL_CMD_STOP_FLAG);
+    }
+    /*Objects are printed only with the changed keys, keyframe is the same as the wrapper output*/
+    for(pobj = d->msg.obj_queue; pobj != NULL; pobj = pobj->next) {
+        started = key;
+        sep = 0;
+        if(key) {
+            __print_obj_start(ctx, (*pobj));
+        }
+        for(ip = pobj->int_queue; ip != NULL; ip = ip->next) {
+            if(!__delta_changed(d, sl != end ? sl++ : NULL, key, ip)) continue;
+            if(!started) { __print_obj_start(ctx, (*pobj)); started = 1; }
+            __print_key_sep(ctx, sep);
+            __print_key_equ(ctx, ip->id);
+            __msg_write_int(ctx, ip->val);
+        }
+        for(fp = pobj->float_queue; fp != NULL; fp = fp->next) {
+            if(!__delta_changed(d, sl != end ? sl++ : NULL, key, fp)) continue;
+            if(!started) { __print_obj_start(ctx, (*pobj)); started = 1; }
+            __print_key_sep(ctx, sep);
+            __print_key_equ(ctx, fp->id);
+            __msg_write_float(ctx, fp->val, fp->prec);
+        }
+        for(sp = pobj->string_queue; sp != NULL; sp = sp->next) {
+            if(!__delta_changed(d, sl != end ? sl++ : NULL, key, sp)) continue;
+            if(!started) { __print_obj_start(ctx, (*pobj)); started = 1; }
+            __print_key_sep(ctx, sep);
+            __print_key_equ(ctx, sp->id);
+            qmark = __define_qmark(sp->content);
+            __msg_putc(ctx, qmark);
+            __msg_write_ref(ctx, sp->content.s, sp->content.len);
+            __msg_putc(ctx, qmark);
+        }
+        if(started) __msg_putc(ctx, __CTRL_STOP_OBJ);
+    }
+    __msg_putc(ctx, __CTRL_STOP_MSG);
+    msg_ctx_flush(ctx);
+}
+
+/**
+ * @brief Print next message of delta stream with the default context
+ * 
+ * @param d delta stream
+ */
+static void __msg_delta_print(msg_delta_t *d)
+{
+    msg_ctx_print_delta(&__ctx, d);
+}
+ #endif
+
+/**
+ * @brief Compare strings
+ * 
+ * @param a string
+ * @param b string
+ * @return uint8_t 1 if the strings are equal
+ */
+static inline uint8_t __str_eq(msg_str_t a, msg_str_t b)
+{
+    msg_size_t i;
+
+    if(a.len != b.len) return 0;
+    for(i = 0; i < a.len && a.s[i] == b.s[i]; i++);
+    return i == a.len;
+}
+
+/**
+ * @brief Clear state store
+ * 
+ * @param st state store
+ */
+static void __state_reset(msg_state_t *st)
+{
+    msg_size_t i;
+
+    st->cnt = 0;
+    st->pool_len = 0;
+    st->overflow = 0;
+    for(i = 0; i <= st->hash_mask && st->head != NULL; i++) st->head[i] = __STATE_NONE;
+}
+
+/**
+ * @brief Allocate bytes from the pool of state store
+ * 
+ * @param st state store
+ * @param n count of bytes
+ * @return char* allocated bytes or NULL if the pool is full (overflow is set)
+ */
+static char *__state_alloc(msg_state_t *st, msg_size_t n)
+{
+    char *p;
+
+    if(st->pool_size - st->pool_len < n) {
+        st->overflow = 1;
+        return NULL;
+    }
+    p = st->pool + st->pool_len;
+    st->pool_len += n;
+    return p;
+}
+
+/**
+ * @brief Find entry of state store
+ * 
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @param h hash of object id and key
+ * @return msg_state_entry_t* entry or NULL if not found
+ */
+static msg_state_entry_t *__state_find(const msg_state_t *st, msg_str_t obj, msg_str_t key, uint32_t h)
+{
+    msg_size_t i;
+
+    if(st->head == NULL) return NULL;
+    for(i = st->head[h & st->hash_mask]; i != __STATE_NONE; i = st->entry[i].next) {
+        if(__str_eq(st->entry[i].key, key) && __str_eq(st->entry[i].obj, obj)) return &st->entry[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Set value of key in state store, new keys are added
+ * 
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @param val raw value
+ * @return uint8_t 1 if the value is stored
+ */
+static uint8_t __state_set(msg_state_t *st, msg_str_t obj, msg_str_t key, msg_str_t val)
+{
+    uint32_t h = __hash_str(key, __hash_str(obj, __FNV_OFFSET));
+    msg_state_entry_t *e = __state_find(st, obj, key, h), *prev;
+    msg_size_t cap, i;
+
+    if(e == NULL) { // new key, ids are copied (object id is shared with the previous entry)
+        if(st->cnt >= st->size) {
+            st->overflow = 1;
+            return 0;
+        }
+        e = &st->entry[st->cnt];
+        prev = st->cnt ? e - 1 : NULL;
+        if(prev != NULL && __str_eq(prev->obj, obj)) {
+            e->obj = prev->obj;
+        } else {
+            if((e->obj.s = __state_alloc(st, obj.len)) == NULL) return 0;
+            e->obj.len = obj.len;
+            for(i = 0; i < obj.len; i++) e->obj.s[i] = obj.s[i];
+        }
+        if((e->key.s = __state_alloc(st, key.len)) == NULL) return 0;
+        e->key.len = key.len;
+        for(i = 0; i < key.len; i++) e->key.s[i] = key.s[i];
+        e->val.s = NULL;
+        e->val.len = e->cap = 0;
+        e->next = st->head[h & st->hash_mask];
+        st->head[h & st->hash_mask] = st->cnt++;
+    }
+    if(val.len > e->cap) { // longer value is stored at the end of the pool
+        cap = val.len > MCU_MSG_STATE_VAL_SIZE ? val.len : MCU_MSG_STATE_VAL_SIZE;
+        if((e->val.s = __state_alloc(st, cap)) == NULL) {
+            e->val.len = e->cap = 0;
+            return 0;
+        }
+        e->cap = cap;
+    }
+    for(i = 0; i < val.len; i++) e->val.s[i] = val.s[i];
+    e->val.len = val.len;
+    return 1;
+}
+
+/**
+ * @brief Get entry of state store
+ * 
+ * @param st state store
+ * @param obj object id
+ * @param key key
+ * @return const msg_state_entry_t* entry or NULL if not found
+ */
+static const msg_state_entry_t *__state_get(const msg_state_t *st, char *obj, char *key)
+{
+    msg_str_t o, k;
+
+    if(obj == NULL || key == NULL) return NULL;
+    o.s = obj;
+    o.len = __str_len(obj);
+    k.s = key;
+    k.len = __str_len(key);
+    return __state_find(st, o, k, __hash_str(k, __hash_str(o, __FNV_OFFSET)));
+}
+
+/*Create state store*/
+msg_state_t msg_state_create(msg_state_entry_t *entry, msg_size_t size, char *pool, msg_size_t pool_size)
+{
+    msg_state_t st;
+    msg_size_t n = 1, skip;
+
+    st.entry = entry;
+    st.size = entry != NULL ? size : 0;
+    st.head = NULL;
+    st.hash_mask = 0;
+    if(pool == NULL) pool_size = 0;
+    /*Bucket table at the aligned start of the pool, fewer buckets if the pool is small*/
+    skip = (msg_size_t)(-(uintptr_t)pool & (sizeof(msg_size_t) - 1));
+    while(n < st.size && n <= (msg_size_t)~0 / 2) n *= 2;
+    while(n && (pool_size < skip || (pool_size - skip) / sizeof(msg_size_t) < n)) n /= 2;
+    if(n) {
+        st.head = (msg_size_t *)(pool + skip);
+        st.hash_mask = n - 1;
+        skip += n * sizeof(msg_size_t);
+    } else {
+        st.size = 0; // no room for a bucket, every key overflows
+        skip = pool_size;
+    }
+    st.pool = pool_size ? pool + skip : NULL;
+    st.pool_size = pool_size - skip;
+    __state_reset(&st);
+    return st;
+}
+
+/*Merge received message into state store*/
+msg_size_t msg_state_merge(msg_state_t *st, msg_t msg)
+{
+    msg_index_rec_t tok;
+    msg_str_t obj_id, obj;
+    char *p = msg.content.s;
+    msg_size_t n = 0;
+
+    if(p == NULL) return 0;
+    if(msg_parser_get_cmd(msg, MSG_DELTA_CMD).cmd.s == NULL) __state_reset(st); // keyframe
+    msg_destroy_str(&obj_id);
+    msg_destroy_str(&obj);
+    while((p = __next_token(msg.content, p, &tok)) != NULL) {
+        switch(tok.kind) {
+            case MSG_TOK_OBJ:
+                obj_id = tok.id;
+                obj = tok.val;
+            break;
+            case MSG_TOK_KEY: // keys outside of objects are ignored
+                if(obj.s != NULL && __is_p_in_str(obj, tok.id.s)) n += __state_set(st, obj_id, tok.id, tok.val);
+            break;
+            default:
+            break;
+        }
+    }
+    return n;
+}
+
+/*Get current integer*/
+uint8_t msg_state_get_int(int *res, const msg_state_t *st, char *obj, char *key)
+{
+    const msg_state_entry_t *e = __state_get(st, obj, key);
+    return e != NULL ? __str_to_int(res, e->val) : 0;
+}
+
+/*Get current 64 bit integer*/
+uint8_t msg_state_get_int64(int64_t *res, const msg_state_t *st, char *obj, char *key)
+{
+    const msg_state_entry_t *e = __state_get(st, obj, key);
+    return e != NULL ? __str_to_int64(res, e->val) : 0;
+}
+
+/*Get current float*/
+uint8_t msg_state_get_float(float *res, const msg_state_t *st, char *obj, char *key)
+{
+    const msg_state_entry_t *e = __state_get(st, obj, key);
+    return e != NULL ? __str_to_float(res, e->val) : 0;
+}
+
+/*Get current double*/
+uint8_t msg_state_get_double(double *res, const msg_state_t *st, char *obj, char *key)
+{
+    const msg_state_entry_t *e = __state_get(st, obj, key);
+    return e != NULL ? __str_to_double(res, e->val) : 0;
+}
+
+/*Get current string*/
+msg_str_t msg_state_get_str(const msg_state_t *st, char *obj, char *key)
+{
+    const msg_state_entry_t *e = __state_get(st, obj, key);
+    msg_str_t res;
+
+    if(e == NULL) {
+        msg_destroy_str(&res);
+        return res;
+    }
+    return msg_val_to_str(e->val); // empty value isn't stored in the pool (NULL)
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                         Framing                                         //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_FRAME
+
+#if !__MSG_CRC32C_HW
+/*CRC32C lookup table (reflected polynomial 0x82F63B78)*/
+static const uint32_t __crc32c_tab[256] = {
+    0x00000000UL, 0xf26b8303UL, 0xe13b70f7UL, 0x1350f3f4UL, 0xc79a971fUL, 0x35f1141cUL,
+    0x26a1e7e8UL, 0xd4ca64ebUL, 0x8ad958cfUL, 0x78b2dbccUL, 0x6be22838UL, 0x9989ab3bUL,
+    0x4d43cfd0UL, 0xbf284cd3UL, 0xac78bf27UL, 0x5e133c24UL, 0x105ec76fUL, 0xe235446cUL,
+    0xf165b798UL, 0x030e349bUL, 0xd7c45070UL, 0x25afd373UL, 0x36ff2087UL, 0xc494a384UL,
+    0x9a879fa0UL, 0x68ec1ca3UL, 0x7bbcef57UL, 0x89d76c54UL, 0x5d1d08bfUL, 0xaf768bbcUL,
+    0xbc267848UL, 0x4e4dfb4bUL, 0x20bd8edeUL, 0xd2d60dddUL, 0xc186fe29UL, 0x33ed7d2aUL,
+    0xe72719c1UL, 0x154c9ac2UL, 0x061c6936UL, 0xf477ea35UL, 0xaa64d611UL, 0x580f5512UL,
+    0x4b5fa6e6UL, 0xb93425e5UL, 0x6dfe410eUL, 0x9f95c20dUL, 0x8cc531f9UL, 0x7eaeb2faUL,
+    0x30e349b1UL, 0xc288cab2UL, 0xd1d83946UL, 0x23b3ba45UL, 0xf779deaeUL, 0x05125dadUL,
+    0x1642ae59UL, 0xe4292d5aUL, 0xba3a117eUL, 0x4851927dUL, 0x5b016189UL, 0xa96ae28aUL,
+    0x7da08661UL, 0x8fcb0562UL, 0x9c9bf696UL, 0x6ef07595UL, 0x417b1dbcUL, 0xb3109ebfUL,
+    0xa0406d4bUL, 0x522bee48UL, 0x86e18aa3UL, 0x748a09a0UL, 0x67dafa54UL, 0x95b17957UL,
+    0xcba24573UL, 0x39c9c670UL, 0x2a993584UL, 0xd8f2b687UL, 0x0c38d26cUL, 0xfe53516fUL,
+    0xed03a29bUL, 0x1f682198UL, 0x5125dad3UL, 0xa34e59d0UL, 0xb01eaa24UL, 0x42752927UL,
+    0x96bf4dccUL, 0x64d4cecfUL, 0x77843d3bUL, 0x85efbe38UL, 0xdbfc821cUL, 0x2997011fUL,
+    0x3ac7f2ebUL, 0xc8ac71e8UL, 0x1c661503UL, 0xee0d9600UL, 0xfd5d65f4UL, 0x0f36e6f7UL,
+    0x61c69362UL, 0x93ad1061UL, 0x80fde395UL, 0x72966096UL, 0xa65c047dUL, 0x5437877eUL,
+    0x4767748aUL, 0xb50cf789UL, 0xeb1fcbadUL, 0x197448aeUL, 0x0a24bb5aUL, 0xf84f3859UL,
+    0x2c855cb2UL, 0xdeeedfb1UL, 0xcdbe2c45UL, 0x3fd5af46UL, 0x7198540dUL, 0x83f3d70eUL,
+    0x90a324faUL, 0x62c8a7f9UL, 0xb602c312UL, 0x44694011UL, 0x5739b3e5UL, 0xa55230e6UL,
+    0xfb410cc2UL, 0x092a8fc1UL, 0x1a7a7c35UL, 0xe811ff36UL, 0x3cdb9bddUL, 0xceb018deUL,
+    0xdde0eb2aUL, 0x2f8b6829UL, 0x82f63b78UL, 0x709db87bUL, 0x63cd4b8fUL, 0x91a6c88cUL,
+    0x456cac67UL, 0xb7072f64UL, 0xa457dc90UL, 0x563c5f93UL, 0x082f63b7UL, 0xfa44e0b4UL,
+    0xe9141340UL, 0x1b7f9043UL, 0xcfb5f4a8UL, 0x3dde77abUL, 0x2e8e845fUL, 0xdce5075cUL,
+    0x92a8fc17UL, 0x60c37f14UL, 0x73938ce0UL, 0x81f80fe3UL, 0x55326b08UL, 0xa759e80bUL,
+    0xb4091bffUL, 0x466298fcUL, 0x1871a4d8UL, 0xea1a27dbUL, 0xf94ad42fUL, 0x0b21572cUL,
+    0xdfeb33c7UL, 0x2d80b0c4UL, 0x3ed04330UL, 0xccbbc033UL, 0xa24bb5a6UL, 0x502036a5UL,
+    0x4370c551UL, 0xb11b4652UL, 0x65d122b9UL, 0x97baa1baUL, 0x84ea524eUL, 0x7681d14dUL,
+    0x2892ed69UL, 0xdaf96e6aUL, 0xc9a99d9eUL, 0x3bc21e9dUL, 0xef087a76UL, 0x1d63f975UL,
+    0x0e330a81UL, 0xfc588982UL, 0xb21572c9UL, 0x407ef1caUL, 0x532e023eUL, 0xa145813dUL,
+    0x758fe5d6UL, 0x87e466d5UL, 0x94b49521UL, 0x66df1622UL, 0x38cc2a06UL, 0xcaa7a905UL,
+    0xd9f75af1UL, 0x2b9cd9f2UL, 0xff56bd19UL, 0x0d3d3e1aUL, 0x1e6dcdeeUL, 0xec064eedUL,
+    0xc38d26c4UL, 0x31e6a5c7UL, 0x22b65633UL, 0xd0ddd530UL, 0x0417b1dbUL, 0xf67c32d8UL,
+    0xe52cc12cUL, 0x1747422fUL, 0x49547e0bUL, 0xbb3ffd08UL, 0xa86f0efcUL, 0x5a048dffUL,
+    0x8ecee914UL, 0x7ca56a17UL, 0x6ff599e3UL, 0x9d9e1ae0UL, 0xd3d3e1abUL, 0x21b862a8UL,
+    0x32e8915cUL, 0xc083125fUL, 0x144976b4UL, 0xe622f5b7UL, 0xf5720643UL, 0x07198540UL,
+    0x590ab964UL, 0xab613a67UL, 0xb831c993UL, 0x4a5a4a90UL, 0x9e902e7bUL, 0x6cfbad78UL,
+    0x7fab5e8cUL, 0x8dc0dd8fUL, 0xe330a81aUL, 0x115b2b19UL, 0x020bd8edUL, 0xf0605beeUL,
+    0x24aa3f05UL, 0xd6c1bc06UL, 0xc5914ff2UL, 0x37faccf1UL, 0x69e9f0d5UL, 0x9b8273d6UL,
+    0x88d28022UL, 0x7ab90321UL, 0xae7367caUL, 0x5c18e4c9UL, 0x4f48173dUL, 0xbd23943eUL,
+    0xf36e6f75UL, 0x0105ec76UL, 0x12551f82UL, 0xe03e9c81UL, 0x34f4f86aUL, 0xc69f7b69UL,
+    0xd5cf889dUL, 0x27a40b9eUL, 0x79b737baUL, 0x8bdcb4b9UL, 0x988c474dUL, 0x6ae7c44eUL,
+    0xbe2da0a5UL, 0x4c4623a6UL, 0x5f16d052UL, 0xad7d5351UL
+};
+#endif
+
+/*Calculate CRC32C*/
+uint32_t msg_crc32c(uint32_t crc, const char *p, msg_size_t n)
+{
+    const char *end = p + n;
+
+    crc = ~crc;
+#if __MSG_CRC32C_HW
+ #if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    for(; end - p >= 8; p += 8) crc64 = _mm_crc32_u64(crc64, __load8(p));
+    crc = (uint32_t)crc64;
+ #endif
+    for(; p < end; p++) crc = _mm_crc32_u8(crc, (uint8_t)*p);
+#else
+    for(; p < end; p++) crc = __crc32c_tab[(crc ^ (uint8_t)*p) & 0xFF] ^ (crc >> 8);
+#endif
+    return ~crc;
+}
+
+/**
+ * @brief Read little endian 32 bit number
+ * 
+ */
+#define __get_le32(p)             ((uint32_t)(uint8_t)(p)[0] | (uint32_t)(uint8_t)(p)[1] << 8 |      \
+                                   (uint32_t)(uint8_t)(p)[2] << 16 | (uint32_t)(uint8_t)(p)[3] << 24)
+
+/**
+ * @brief Write little endian 32 bit number
+ * 
+ */
+#define __put_le32(p, v)          (p)[0] = (char)(v); (p)[1] = (char)((v) >> 8);                   \
+                                  (p)[2] = (char)((v) >> 16); (p)[3] = (char)((v) >> 24)
+
+/**
+ * @brief Fill frame header
+ * 
+ * @param hdr header (MSG_FRAME_HDR_SIZE bytes)
+ * @param payload payload
+ * @param len payload length
+ */
+static void __frame_fill(char *hdr, const char *payload, msg_size_t len)
+{
+    uint32_t crc = msg_crc32c(0, payload, len);
+    uint32_t hcrc;
+
+    hdr[0] = MSG_FRAME_MAGIC0;
+    hdr[1] = MSG_FRAME_MAGIC1;
+    __put_le32(hdr + 2, (uint32_t)len);
+    hcrc = msg_crc32c(0, hdr + 2, 4);
+    hdr[6] = (char)hcrc;
+    hdr[7] = (char)(hcrc >> 8);
+    __put_le32(hdr + 8, crc);
+}
+
+/**
+ * @brief Check frame header
+ * 
+ * @param p header start
+ * @param end end of the buffer
+ * @param max max. payload length (config and buffer size)
+ * @param len payload length
+ * @return uint8_t __FRAME_BAD, __FRAME_PART or __FRAME_OK
+ */
+static uint8_t __frame_head(const char *p, const char *end, uint32_t max, uint32_t *len)
+{
+    uint32_t hcrc;
+
+    if(p[0] != MSG_FRAME_MAGIC0) return __FRAME_BAD;
+    if(end - p < 2) return __FRAME_PART;
+    if(p[1] != MSG_FRAME_MAGIC1) return __FRAME_BAD;
+    if(end - p < MSG_FRAME_HDR_SIZE) return __FRAME_PART;
+    *len = __get_le32(p + 2);
+    if(*len > max) return __FRAME_BAD; // it would never complete
+    hcrc = msg_crc32c(0, p + 2, 4);
+    if(p[6] != (char)hcrc || p[7] != (char)(hcrc >> 8)) return __FRAME_BAD;
+    return (uint32_t)(end - p - MSG_FRAME_HDR_SIZE) < *len ? __FRAME_PART : __FRAME_OK;
+}
+
+/**
+ * @brief Find the next valid frame, optionally with message id
+ * 
+ * @param buff receive buffer
+ * @param len length of the received data
+ * @param size buffer size
+ * @param cursor start position, set to the end of the frame or to the start of an incomplete frame
+ * @param id message id or NULL for any frame (frames with other id are skipped whitout CRC check)
+ * @param payload result payload
+ * @return char* frame end or NULL if not found
+ */
+static char *__frame_scan(char *buff, msg_size_t len, msg_size_t size, msg_size_t *cursor, char *id, msg_str_t *payload)
+{
+    char *p = buff + *cursor, *end = buff + len;
+    uint32_t n, max = MCU_MSG_FRAME_MAX_LEN;
+    msg_str_t pid;
+
+    if(size < MSG_FRAME_HDR_SIZE) max = 0;
+    else if(size - MSG_FRAME_HDR_SIZE < max) max = size - MSG_FRAME_HDR_SIZE;
+    pid.len = id != NULL ? __str_len(id) : 0;
+    while(p < end) {
+        p = __scan_chars(p, end, MSG_FRAME_MAGIC0, MSG_FRAME_MAGIC0, MSG_FRAME_MAGIC0);
+        if(p >= end) break;
+        switch(__frame_head(p, end, max, &n)) {
+            case __FRAME_PART:
+                *cursor = p - buff;
+                return NULL;
+            case __FRAME_BAD: // resync from the next byte
+                p++;
+                continue;
+            default:
+            break;
+        }
+        payload->s = p + MSG_FRAME_HDR_SIZE;
+        payload->len = n;
+        if(id != NULL) { // compare "#id{" whitout CRC check
+            pid.s = payload->s + 1;
+            if(n < pid.len + 2 || payload->s[0] != __CTRL_MSG_FLAG || pid.s[pid.len] != __CTRL_START_MSG ||
+                                                                    !__keyword_eq(pid, id)) {
+                p = payload->s + n;
+                continue;
+            }
+        }
+        if(msg_crc32c(0, payload->s, n) != __get_le32(p + 8)) { // corrupted frame
+            p++;
+            continue;
+        }
+        p = payload->s + n;
+        *cursor = p - buff;
+        return p;
+    }
+    *cursor = len;
+    return NULL;
+}
+
+/*Write frame header*/
+msg_size_t msg_frame_seal(char *buff, msg_size_t size, msg_size_t len)
+{
+    if(buff == NULL || size < MSG_FRAME_HDR_SIZE || size - MSG_FRAME_HDR_SIZE < len || len > MCU_MSG_FRAME_MAX_LEN) return 0;
+    __frame_fill(buff, buff + MSG_FRAME_HDR_SIZE, len);
+    return len + MSG_FRAME_HDR_SIZE;
+}
+
+/*Print frame*/
+void msg_ctx_print_frame(msg_ctx_t *ctx, const char *payload, msg_size_t len)
+{
+    char hdr[MSG_FRAME_HDR_SIZE];
+
+    if(len > MCU_MSG_FRAME_MAX_LEN) { // receivers would drop it
+        ctx->overflow = 1;
+        return;
+    }
+    __frame_fill(hdr, payload, len);
+    __msg_write(ctx, hdr, MSG_FRAME_HDR_SIZE);
+    __msg_write(ctx, payload, len);
+    msg_ctx_flush(ctx);
+}
+
+/*Get payload of the next valid frame*/
+msg_str_t msg_frame_next(char *buff, msg_size_t len, msg_size_t size, msg_size_t *cursor)
+{
+    msg_str_t res;
+
+    if(buff == NULL || __frame_scan(buff, len, size, cursor, NULL, &res) == NULL) msg_destroy_str(&res);
+    return res;
+}
+
+/*Get message from the next valid frame with id*/
+msg_t msg_frame_get(char *buff, msg_size_t len, msg_size_t size, char *id, msg_size_t *cursor)
+{
+    msg_str_t payload;
+    msg_t res;
+
+    if(buff == NULL || id == NULL || __frame_scan(buff, len, size, cursor, id, &payload) == NULL) {
+        msg_destroy(&res);
+        return res;
+    }
+    return msg_get(payload.s, id, payload.len);
+}
+
+ #if MCU_MSG_USE_WRAPPER
+/*Print message wrapper as frame*/
+msg_size_t msg_wrap_print_frame(msg_wrap_t msg, char *buff, msg_size_t size, uint32_t *required)
+{
+    uint32_t req;
+    msg_size_t len = 0;
+
+    if(buff != NULL && size > MSG_FRAME_HDR_SIZE) {
+        len = msg_wrap_print_to_buff(msg, buff + MSG_FRAME_HDR_SIZE, size - MSG_FRAME_HDR_SIZE, &req);
+    } else {
+        req = msg_wrap_measure(msg);
+    }
+    if(required != NULL) *required = req + MSG_FRAME_HDR_SIZE;
+    return len ? msg_frame_seal(buff, size, len) : 0;
+}
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                      iovec output                                       //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_IOVEC
+
+/**
+ * @brief Add span to the iovec entries, continuous spans are merged
+ * 
+ * @param ctx context in iovec mode
+ * @param p span start
+ * @param n span length
+ */
+static void __iov_add(msg_ctx_t *ctx, const char *p, msg_size_t n)
+{
+    struct iovec *last = ctx->iov_cnt ? &ctx->iov[ctx->iov_cnt - 1] : NULL;
+
+    if(!n) return;
+    if(last != NULL && (const char *)last->iov_base + last->iov_len == p) {
+        last->iov_len += n;
+        return;
+    }
+    if(ctx->iov_cnt >= ctx->iov_size) {
+        ctx->overflow = 1;
+        return;
+    }
+    ctx->iov[ctx->iov_cnt].iov_base = (void *)p;
+    ctx->iov[ctx->iov_cnt++].iov_len = n;
+}
+
+/*Init context in iovec mode*/
+void msg_ctx_init_iovec(msg_ctx_t *ctx, struct iovec *iov, msg_size_t n, char *scratch, msg_size_t scratch_size)
+{
+    msg_ctx_init(ctx, NULL);
+    msg_ctx_init_str_buff(ctx, scratch, scratch_size);
+    ctx->iov = iov;
+    ctx->iov_size = iov != NULL ? n : 0;
+    ctx->redir = __OUTP_IOVEC;
+}
+
+/*Reset iovec entries*/
+void msg_ctx_reset_iovec(msg_ctx_t *ctx)
+{
+    msg_ctx_reset_str_buff(ctx);
+    ctx->iov_cnt = 0;
+}
+
+ #if MCU_MSG_USE_WRAPPER
+/*Serialize message wrapper to iovec*/
+msg_size_t msg_wrap_to_iovec(msg_wrap_t msg, struct iovec *iov, msg_size_t n, char *scratch, msg_size_t scratch_size)
+{
+    msg_ctx_t ctx;
+
+    msg_ctx_init_iovec(&ctx, iov, n, scratch, scratch_size);
+    msg_ctx_print_wrapper_msg(&ctx, msg);
+    return ctx.overflow ? 0 : ctx.iov_cnt;
+}
+
+/*Serialize message builder to iovec*/
+msg_size_t msg_builder_to_iovec(const msg_builder_t *b, struct iovec *iov, msg_size_t n, char *scratch, msg_size_t scratch_size)
+{
+    msg_ctx_t ctx;
+
+    msg_ctx_init_iovec(&ctx, iov, n, scratch, scratch_size);
+    msg_ctx_print_builder(&ctx, b);
+    return ctx.overflow ? 0 : ctx.iov_cnt;
+}
+ #endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                       SPSC ring                                         //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_RING
+
+/**
+ * @brief Copy bytes between ring and linear buffer
+ * 
+ * @param dst destination
+ * @param src source
+ * @param n count of bytes
+ */
+static void __ring_copy(char *dst, const char *src, msg_size_t n)
+{
+    const char *end = src + n;
+    while(src < end) *dst++ = *src++;
+}
+
+/**
+ * @brief Wake the other side waiting on the index (futex), the consumer may wait on eventfd
+ * 
+ * @param ring ring
+ * @param addr changed index
+ */
+static void __ring_wake(msg_ring_t *ring, uint32_t *addr)
+{
+#if __MSG_RING_FUTEX
+    if(addr == &ring->head && ring->efd >= 0) eventfd_write(ring->efd, 1);
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    (void)ring;
+    (void)addr;
+#endif
+}
+
+/**
+ * @brief Sleep while the index has the observed value
+ * 
+ * @param addr index
+ * @param val observed value
+ * @param timeout_ms timeout in ms, negative for infinite
+ */
+static void __ring_sleep(uint32_t *addr, uint32_t val, int timeout_ms)
+{
+#if __MSG_RING_FUTEX
+    struct timespec ts;
+
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout_ms < 0 ? NULL : &ts, NULL, 0);
+#else
+    (void)addr;
+    (void)val;
+    (void)timeout_ms;
+#endif
+}
+
+/**
+ * @brief Sink write of the producer, the span is copied after the pending bytes
+ * 
+ * @param arg ring
+ * @param p span
+ * @param n span length
+ * @return int written bytes, 0 if the message is dropped
+ */
+static int __ring_write(void *arg, const char *p, msg_size_t n)
+{
+    msg_ring_t *ring = (msg_ring_t *)arg;
+    uint32_t size = ring->mask + 1;
+    uint32_t tail, pos, first;
+
+    if(ring->drop || ring->buff == NULL || ring->pend - ring->head + n > size) {
+        ring->drop = 1; // whole message is dropped at commit
+        return 0;
+    }
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    while(ring->pend + n - tail > size) { // wait for the consumer
+#if __MSG_RING_FUTEX
+        __atomic_store_n(&ring->wr_wait, 1, __ATOMIC_SEQ_CST);
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+        if(ring->pend + n - tail > size) __ring_sleep(&ring->tail, tail, -1);
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+#else
+        ring->drop = 1;
+        return 0;
+#endif
+    }
+    pos = ring->pend & ring->mask;
+    first = size - pos;
+    if(first > n) first = n;
+    __ring_copy(ring->buff + pos, p, first);
+    __ring_copy(ring->buff, p + first, n - first); // wraparound
+    ring->pend += n;
+    return n;
+}
+
+/*Create ring*/
+msg_ring_t msg_ring_create(char *buff, msg_size_t size)
+{
+    msg_ring_t ring;
+    msg_size_t s = 1;
+
+    while(s <= size / 2 && s < 0x80000000UL) s *= 2; // free running 32 bit indexes, max. 2^31 bytes
+    ring.buff = size >= 2 ? buff : NULL;
+    ring.mask = (uint32_t)(s - 1);
+    ring.efd = -1;
+    ring.head = ring.pend = ring.tail = 0;
+    ring.rd_wait = ring.wr_wait = 0;
+    ring.drop = 0;
+    return ring;
+}
+
+/*Sink of the producer*/
+msg_sink_t msg_ring_sink(msg_ring_t *ring)
+{
+    msg_sink_t sink;
+    sink.write = __ring_write;
+    sink.arg = ring;
+    return sink;
+}
+
+/*Init context to print into the ring*/
+void msg_ctx_init_ring(msg_ctx_t *ctx, msg_ring_t *ring)
+{
+    msg_ctx_init_sink(ctx, msg_ring_sink(ring));
+}
+
+/*Publish pending bytes*/
+msg_size_t msg_ring_commit(msg_ring_t *ring)
+{
+    msg_size_t n = ring->pend - ring->head;
+
+    if(ring->drop) {
+        ring->pend = ring->head;
+        ring->drop = 0;
+        return 0;
+    }
+    if(n == 0) return 0;
+    __atomic_store_n(&ring->head, ring->pend, __ATOMIC_SEQ_CST);
+    if(__atomic_exchange_n(&ring->rd_wait, 0, __ATOMIC_SEQ_CST)) __ring_wake(ring, &ring->head);
+    return n;
+}
+
+/*Count of committed bytes*/
+msg_size_t msg_ring_avail(msg_ring_t *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail;
+}
+
+/*Free space of the producer*/
+msg_size_t msg_ring_space(msg_ring_t *ring)
+{
+    if(ring->buff == NULL) return 0;
+    return (ring->mask + 1) - (ring->pend - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+}
+
+/*Wait for committed bytes*/
+msg_size_t msg_ring_wait(msg_ring_t *ring, int timeout_ms)
+{
+    uint32_t head;
+
+    if(msg_ring_avail(ring)) return msg_ring_avail(ring);
+#if __MSG_RING_FUTEX
+    __atomic_store_n(&ring->rd_wait, 1, __ATOMIC_SEQ_CST);
+    head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+    if(head == ring->tail) __ring_sleep(&ring->head, head, timeout_ms);
+    __atomic_store_n(&ring->rd_wait, 0, __ATOMIC_RELAXED);
+#else
+    (void)head;
+    (void)timeout_ms;
+#endif
+    return msg_ring_avail(ring);
+}
+
+/*Get committed bytes whitout copy*/
+msg_size_t msg_ring_peek(msg_ring_t *ring, msg_str_t seg[2])
+{
+    msg_size_t n = msg_ring_avail(ring);
+    uint32_t pos = ring->tail & ring->mask;
+
+    seg[0].s = ring->buff + pos;
+    seg[0].len = (ring->mask + 1) - pos;
+    if(seg[0].len > n) seg[0].len = n;
+    seg[1].s = ring->buff;
+    seg[1].len = n - seg[0].len;
+    return n;
+}
+
+/*Release read bytes*/
+void msg_ring_consume(msg_ring_t *ring, msg_size_t n)
+{
+    __atomic_store_n(&ring->tail, ring->tail + n, __ATOMIC_SEQ_CST);
+    if(__atomic_exchange_n(&ring->wr_wait, 0, __ATOMIC_SEQ_CST)) __ring_wake(ring, &ring->tail);
+}
+
+/*Copy committed bytes to linear buffer*/
+msg_size_t msg_ring_read(msg_ring_t *ring, char *buff, msg_size_t size)
+{
+    msg_str_t seg[2];
+    msg_size_t n;
+
+    if(size == 0) return 0;
+    n = msg_ring_peek(ring, seg);
+    if(n > size - 1) { // buffer is too small, the rest remains in the ring
+        n = size - 1;
+        if(seg[0].len > n) seg[0].len = n;
+        seg[1].len = n - seg[0].len;
+    }
+    __ring_copy(buff, seg[0].s, seg[0].len);
+    __ring_copy(buff + seg[0].len, seg[1].s, seg[1].len);
+    buff[n] = '\0';
+    msg_ring_consume(ring, n);
+    return n;
+}
+
+/*Set eventfd of the consumer*/
+void msg_ring_set_eventfd(msg_ring_t *ring, int efd)
+{
+    ring->efd = efd;
+}
+
+/*Arm consumer before waiting for the eventfd*/
+msg_size_t msg_ring_arm(msg_ring_t *ring)
+{
+    msg_size_t n;
+
+    __atomic_store_n(&ring->rd_wait, 1, __ATOMIC_SEQ_CST);
+    n = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) - ring->tail;
+    if(n) __atomic_store_n(&ring->rd_wait, 0, __ATOMIC_RELAXED);
+    return n;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                    Segmented parser                                     //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_SEG
+
+/**
+ * @brief Char at the position of the view
+ * 
+ * @param v view
+ * @param i position
+ * @return char char or '\0' after the end of the view
+ */
+static inline char __seg_at(msg_seg_t v, msg_size_t i)
+{
+    if(i < v.part[0].len) return v.part[0].s[i];
+    i -= v.part[0].len;
+    return i < v.part[1].len ? v.part[1].s[i] : '\0';
+}
+
+/**
+ * @brief Sub view, the first part is always used
+ * 
+ * @param v view
+ * @param off start position
+ * @param len length
+ * @return msg_seg_t sub view
+ */
+static msg_seg_t __seg_sub(msg_seg_t v, msg_size_t off, msg_size_t len)
+{
+    msg_seg_t res;
+
+    if(off < v.part[0].len) {
+        res.part[0].s = v.part[0].s + off;
+        res.part[0].len = v.part[0].len - off;
+        if(res.part[0].len > len) res.part[0].len = len;
+        res.part[1].s = v.part[1].s;
+        res.part[1].len = len - res.part[0].len;
+    } else { // view starts in the second part
+        res.part[0].s = v.part[1].s + (off - v.part[0].len);
+        res.part[0].len = len;
+        res.part[1].len = 0;
+    }
+    if(!res.part[1].len) res.part[1].s = NULL;
+    return res;
+}
+
+/**
+ * @brief Destroy view (NULL pointers and 0 lengths)
+ * 
+ * @param v view
+ */
+static void __seg_destroy(msg_seg_t *v)
+{
+    msg_destroy_str(&v->part[0]);
+    msg_destroy_str(&v->part[1]);
+}
+
+/**
+ * @brief Find the first occurance of the searched chars or zero terminator in the view,
+ * parts are scanned by __scan_chars
+ * 
+ * @param v view
+ * @param p start position
+ * @param a searched char
+ * @param b searched char
+ * @param c searched char
+ * @return msg_size_t position of the first occurance or length of the view
+ */
+static msg_size_t __seg_scan(msg_seg_t v, msg_size_t p, char a, char b, char c)
+{
+    char *q;
+
+    if(p < v.part[0].len) {
+        q = __scan_chars(v.part[0].s + p, v.part[0].s + v.part[0].len, a, b, c);
+        if(q < v.part[0].s + v.part[0].len) return q - v.part[0].s;
+        p = v.part[0].len;
+    }
+    if(p >= msg_seg_len(v)) return msg_seg_len(v);
+    q = __scan_chars(v.part[1].s + (p - v.part[0].len), v.part[1].s + v.part[1].len, a, b, c);
+    return v.part[0].len + (q - v.part[1].s);
+}
+
+/**
+ * @brief Skip internal string, the same as __skip_internal_str
+ * 
+ * @param v view
+ * @param p position of the start qmark
+ * @return msg_size_t position after the closing qmark or the end of the view
+ */
+static msg_size_t __seg_skip_str(msg_seg_t v, msg_size_t p)
+{
+    char qmark = __seg_at(v, p);
+
+    p = __seg_scan(v, p + 1, qmark, qmark, qmark);
+    return (p < msg_seg_len(v) && __seg_at(v, p)) ? p + 1 : p;
+}
+
+/**
+ * @brief Find keyword in view, the same as __find_keyword
+ * 
+ * @param v view
+ * @param keyword keyword
+ * @param flagc flag, eg. '@', '$'
+ * @param stopc stop character eg. '(', '='
+ * @return msg_size_t position of the keyword (whitout flag) or __SEG_NONE
+ */
+static msg_size_t __seg_find_keyword(msg_seg_t v, char *keyword, char flagc, char stopc)
+{
+    msg_size_t len = msg_seg_len(v), klen = __str_len(keyword);
+    msg_size_t p = 0, i;
+    uint8_t equal;
+    char c;
+
+    while(p < len) {
+        p = __seg_scan(v, p, flagc, '\'', '"'); // jump to the next candidate
+        if(p >= len || !(c = __seg_at(v, p))) break;
+        if(c == '\'' || c == '"') { //skip internal strings
+            p = __seg_skip_str(v, p);
+            continue;
+        }
+        p++; // flag char detected, compare the keyword
+        equal = 1;
+        for(i = 0; p + i < len && i < klen; i++) {
+            c = __seg_at(v, p + i);
+            if(c != keyword[i] || __is_ctrl_char(c) || !__is_valid_id_char(c, i)) {
+                equal = 0;
+                break;
+            }
+        }
+        while(p + i < len && __is_whitespace(__seg_at(v, p + i))) i++; //skip spaces
+        if(equal && p + i < len && __seg_at(v, p + i) == stopc) return p;
+        p += i; // continue from the last checked char
+    }
+    return __SEG_NONE;
+}
+
+/**
+ * @brief Content after the keyword until the stop char, the same as msg_get and msg_parser_get_obj
+ * 
+ * @param v view
+ * @param p position after the keyword
+ * @param startc start char of the content
+ * @param stopc stop char of the content
+ * @return msg_seg_t content view
+ */
+static msg_seg_t __seg_content(msg_seg_t v, msg_size_t p, char startc, char stopc)
+{
+    msg_size_t len = msg_seg_len(v), start;
+
+    while(p + 1 < len && __seg_at(v, p) != startc) p++;
+    start = ++p;
+    while(p < len && __seg_at(v, p = __seg_scan(v, p, stopc, stopc, stopc)) != stopc) p++; // zero terminator is skipped
+    return __seg_sub(v, start, p - start);
+}
+
+/**
+ * @brief Value start position in segmented object, the same as __find_val
+ * 
+ * @param obj object
+ * @param key key
+ * @return msg_size_t position of the value or __SEG_NONE
+ */
+static msg_size_t __seg_find_val(msg_seg_obj_t obj, char *key)
+{
+    msg_size_t p = __seg_find_keyword(obj.content, key, __CTRL_KEY_FLAG, __CTRL_KEY_EQU);
+    msg_size_t len = msg_seg_len(obj.content);
+
+    if(p == __SEG_NONE) return p;
+    while(p + 1 < len && __seg_at(obj.content, p) != __CTRL_KEY_EQU) p++; // move to 'equal'
+    p++;
+    while(p < len && __is_whitespace(__seg_at(obj.content, p))) p++; //skip spaces after equal
+    return p;
+}
+
+/**
+ * @brief Number value of segmented object as contiguous string. The value is used in place
+ * if it's in one part, otherwise it's copied to the buffer
+ * 
+ * @param obj object
+ * @param key key
+ * @param buff local buffer (__SEG_NUM_SIZE)
+ * @param sval result string
+ * @return uint8_t 0 if key is not found, MSG_NUM_OVERFLOW if the value is too long, otherwise 1
+ */
+static uint8_t __seg_num(msg_seg_obj_t obj, char *key, char *buff, msg_str_t *sval)
+{
+    msg_size_t p = __seg_find_val(obj, key);
+    msg_size_t len = msg_seg_len(obj.content), end;
+    msg_seg_t v;
+    char c;
+
+    if(p == __SEG_NONE) return 0;
+    for(end = p; end < len && (c = __seg_at(obj.content, end)) && !__is_whitespace(c) && !__is_ctrl_char(c); end++);
+    v = __seg_sub(obj.content, p, end - p);
+    if(!v.part[1].len) { // value is in one part
+        *sval = v.part[0];
+        return 1;
+    }
+    if(end - p > __SEG_NUM_SIZE) return MSG_NUM_OVERFLOW;
+    sval->s = buff;
+    sval->len = msg_seg_copy(buff, __SEG_NUM_SIZE + 1, v);
+    return 1;
+}
+
+/**
+ * @brief Contiguous object for the linear parser (content has one part)
+ * 
+ * @param obj segmented object
+ * @return msg_obj_t object
+ */
+static inline msg_obj_t __seg_obj_linear(msg_seg_obj_t obj)
+{
+    msg_obj_t res;
+    res.id = obj.id.part[0];
+    res.content = obj.content.part[0];
+    return res;
+}
+
+/*Make view of a contiguous string*/
+msg_seg_t msg_seg_from_str(msg_str_t str)
+{
+    msg_seg_t res;
+    res.part[0] = str;
+    res.part[1].s = NULL;
+    res.part[1].len = 0;
+    return res;
+}
+
+/*Sub view*/
+msg_seg_t msg_seg_sub(msg_seg_t v, msg_size_t off, msg_size_t len)
+{
+    return __seg_sub(v, off, len);
+}
+
+/*Copy view to linear buffer*/
+msg_size_t msg_seg_copy(char *buff, msg_size_t size, msg_seg_t v)
+{
+    msg_size_t i, n = 0;
+    uint8_t k;
+
+    if(size == 0) return 0;
+    for(k = 0; k < 2; k++) {
+        for(i = 0; i < v.part[k].len && n + 1 < size; i++) buff[n++] = v.part[k].s[i];
+    }
+    buff[n] = '\0';
+    return n;
+}
+
+/*Get message by ID from two-segment view*/
+msg_seg_msg_t msg_get_seg(msg_seg_t buff, char *id)
+{
+    msg_seg_msg_t res;
+    msg_size_t p, klen;
+    msg_t msg;
+
+    if(!buff.part[1].len) { // contiguous view, linear parser is used
+        msg = msg_get(buff.part[0].s, id, buff.part[0].len);
+        res.id = msg_seg_from_str(msg.id);
+        res.content = msg_seg_from_str(msg.content);
+        return res;
+    }
+    p = __seg_find_keyword(buff, id, __CTRL_MSG_FLAG, __CTRL_START_MSG);
+    if(p == __SEG_NONE) {
+        __seg_destroy(&res.id);
+        __seg_destroy(&res.content);
+        return res;
+    }
+    klen = __str_len(id);
+    res.id = __seg_sub(buff, p, klen);
+    res.content = __seg_content(buff, p + klen, __CTRL_START_MSG, __CTRL_STOP_MSG);
+    return res;
+}
+
+/*Get object from segmented message by ID*/
+msg_seg_obj_t msg_parser_get_obj_seg(msg_seg_msg_t msg, char *id)
+{
+    msg_seg_obj_t res;
+    msg_obj_t obj;
+    msg_t lin;
+    msg_size_t p, klen;
+
+    if(!msg.content.part[1].len) { // contiguous content, linear parser is used
+        lin.id = msg.id.part[0];
+        lin.content = msg.content.part[0];
+        obj = msg_parser_get_obj(lin, id);
+        res.id = msg_seg_from_str(obj.id);
+        res.content = msg_seg_from_str(obj.content);
+        return res;
+    }
+    p = __seg_find_keyword(msg.content, id, __CTRL_OBJ_FLAG, __CTRL_START_OBJ);
+    if(p == __SEG_NONE) {
+        __seg_destroy(&res.id);
+        __seg_destroy(&res.content);
+        return res;
+    }
+    klen = __str_len(id);
+    res.id = __seg_sub(msg.content, p, klen);
+    res.content = __seg_content(msg.content, p + klen, __CTRL_START_OBJ, __CTRL_STOP_OBJ);
+    return res;
+}
+
+/*Get command from segmented message*/
+msg_seg_t msg_parser_get_cmd_seg(msg_seg_msg_t msg, char *cmd_id)
+{
+    msg_seg_t res;
+    msg_size_t p = __seg_find_keyword(msg.content, cmd_id, __CTRL_CMD_START_FLAG, __CTRL_CMD_STOP_FLAG);
+
+    if(p == __SEG_NONE) {
+        __seg_destroy(&res);
+        return res;
+    }
+    return __seg_sub(msg.content, p, __str_len(cmd_id));
+}
+
+/*Get integer value from segmented object*/
+uint8_t msg_parser_get_int_seg(int *res_val, msg_seg_obj_t obj, char *key)
+{
+    char buff[__SEG_NUM_SIZE + 1];
+    msg_str_t sval;
+    uint8_t r;
+
+    if(!obj.content.part[1].len) return msg_parser_get_int(res_val, __seg_obj_linear(obj), key);
+    r = __seg_num(obj, key, buff, &sval);
+    return r == 1 ? __str_to_int(res_val, sval) : r;
+}
+
+/*Get 64 bit integer value from segmented object*/
+uint8_t msg_parser_get_int64_seg(int64_t *res_val, msg_seg_obj_t obj, char *key)
+{
+    char buff[__SEG_NUM_SIZE + 1];
+    msg_str_t sval;
+    uint8_t r;
+
+    if(!obj.content.part[1].len) return msg_parser_get_int64(res_val, __seg_obj_linear(obj), key);
+    r = __seg_num(obj, key, buff, &sval);
+    return r == 1 ? __str_to_int64(res_val, sval) : r;
+}
+
+/*Get unsigned 64 bit integer value from segmented object*/
+uint8_t msg_parser_get_uint64_seg(uint64_t *res_val, msg_seg_obj_t obj, char *key)
+{
+    char buff[__SEG_NUM_SIZE + 1];
+    msg_str_t sval;
+    uint8_t r;
+
+    if(!obj.content.part[1].len) return msg_parser_get_uint64(res_val, __seg_obj_linear(obj), key);
+    r = __seg_num(obj, key, buff, &sval);
+    return r == 1 ? __str_to_uint64(res_val, sval) : r;
+}
+
+/*Get float value from segmented object*/
+uint8_t msg_parser_get_float_seg(float *res_val, msg_seg_obj_t obj, char *key)
 {
-    msg_wrap_str_t *strp;
-    if(obj->string_queue == NULL) { //empty
-        obj->string_queue = str;
-        obj->string_queue->next = NULL;
-    } else { // put to the end of the queue
-        strp = obj->string_queue;
+    char buff[__SEG_NUM_SIZE + 1];
+    msg_str_t sval;
+    uint8_t r;
 
-        while(strp->next != NULL) 
-            strp = strp->next;
-        strp->next = str;
-        str->next = NULL;
+    if(!obj.content.part[1].len) return msg_parser_get_float(res_val, __seg_obj_linear(obj), key);
+    r = __seg_num(obj, key, buff, &sval);
+    return r == 1 ? __str_to_float(res_val, sval) : r;
+}
+
+/*Get double value from segmented object*/
+uint8_t msg_parser_get_double_seg(double *res_val, msg_seg_obj_t obj, char *key)
+{
+    char buff[__SEG_NUM_SIZE + 1];
+    msg_str_t sval;
+    uint8_t r;
+
+    if(!obj.content.part[1].len) return msg_parser_get_double(res_val, __seg_obj_linear(obj), key);
+    r = __seg_num(obj, key, buff, &sval);
+    return r == 1 ? __str_to_double(res_val, sval) : r;
+}
+
+/*Get string value from segmented object*/
+msg_seg_t msg_parser_get_str_seg(msg_seg_obj_t obj, char *key)
+{
+    msg_seg_t res;
+    msg_size_t p, len, end;
+    char qmark;
+
+    if(!obj.content.part[1].len) return msg_seg_from_str(msg_parser_get_str(__seg_obj_linear(obj), key));
+    p = __seg_find_val(obj, key);
+    qmark = p != __SEG_NONE ? __seg_at(obj.content, p) : '\0';
+    if(qmark != '\'' && qmark != '"') { // key not found or the value is not a string
+        __seg_destroy(&res);
+        return res;
     }
+    len = msg_seg_len(obj.content);
+    end = __seg_scan(obj.content, ++p, qmark, qmark, qmark);
+    while(end < len && __seg_at(obj.content, end) != qmark) end = __seg_scan(obj.content, end + 1, qmark, qmark, qmark);
+    return __seg_sub(obj.content, p, end - p);
 }
+#endif
 
-/*Remove string wrapper from string queue*/
-void msg_wrapper_rm_string_from_obj(msg_wrap_obj_t *obj, msg_wrap_str_t *str)
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                     Receive buffer                                      //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_RX
+
+/*Create receive buffer*/
+msg_rx_t msg_rx_create(char *buff, msg_size_t size)
 {
-    msg_wrap_str_t *sp, *prev;
-    for(sp = obj->string_queue, prev = NULL; sp != NULL; sp = sp->next){
-        if(sp == str) { 
-            if(prev == NULL) { // if p is the head of the queue, reinit the head
-                obj->string_queue = str->next;
-            } else {
-                prev->next = str->next; //skip the expected
-            }
-            str->next = NULL; // reset next
-            return;
+    msg_rx_t rx;
+    rx.buff = buff;
+    rx.size = size;
+    rx.len = rx.cursor = 0;
+    rx.overflow = 0;
+    if(size) buff[0] = '\0';
+    return rx;
+}
+
+/*Append received bytes*/
+msg_size_t msg_rx_write(msg_rx_t *rx, const char *p, msg_size_t n)
+{
+    msg_size_t i;
+
+    if(rx->size == 0) return 0;
+    if(n > rx->size - 1 - rx->len) {
+        msg_rx_compact(rx);
+        if(n > rx->size - 1 - rx->len) { // the unhandled message can't be completed
+            rx->len = rx->cursor = 0;
+            rx->overflow = 1;
+            if(n > rx->size - 1) n = rx->size - 1;
         }
-        prev = sp;
     }
+    for(i = 0; i < n; i++) rx->buff[rx->len + i] = p[i];
+    rx->len += n;
+    rx->buff[rx->len] = '\0';
+    return n;
 }
 
-/*Add int wrapper to object wrapper*/
-void msg_wrapper_add_int_to_obj(msg_wrap_obj_t *obj, msg_wrap_int_t *int_val)
+/*Get complete message by ID*/
+msg_t msg_rx_get(msg_rx_t *rx, char *id)
 {
-    msg_wrap_int_t *ip;
-    if(obj->int_queue == NULL) { //first element
-        obj->int_queue = int_val;
-        obj->int_queue->next = NULL;
-    } else { // push to the end of the queue
-        ip = obj->int_queue;
+    msg_t res = msg_get(rx->buff + rx->cursor, id, msg_rx_pending(rx));
 
-        while(ip->next != NULL) 
-            ip = ip->next;
-        ip->next = int_val;
-        int_val->next = NULL;
+    if(res.id.s != NULL && res.content.s + res.content.len >= rx->buff + rx->len) { // stop char is not arrived
+        msg_destroy(&res);
     }
+    return res;
 }
 
-/*Remove int wrapper from integer wrapper queue*/
-void msg_wrapper_rm_int_from_obj(msg_wrap_obj_t *obj, msg_wrap_int_t *i)
+/*Get the next complete message*/
+msg_t msg_rx_next(msg_rx_t *rx)
 {
-    msg_wrap_int_t *ip, *prev;
-    for(ip = obj->int_queue, prev = NULL; ip != NULL; ip = ip->next){
-        if(ip == i) {
-            if(prev == NULL) { // if p is the head of the queue, reinit the head
-                obj->int_queue = i->next;
-            } else {
-                prev->next = i->next; //skip the expected
-            }
-            i->next = NULL; // reset next
-            return;
-        }
-        prev = ip;
+    msg_size_t cursor = 0;
+    return msg_next(rx->buff + rx->cursor, msg_rx_pending(rx), &cursor);
+}
+
+/*Mark message as handled*/
+void msg_consume(msg_rx_t *rx, msg_t msg)
+{
+    msg_size_t end;
+
+    if(msg.content.s == NULL || msg.content.s < rx->buff + rx->cursor || msg.content.s > rx->buff + rx->len) return;
+    end = msg.content.s + msg.content.len - rx->buff;
+    rx->cursor = end < rx->len ? end + 1 : rx->len; // after the stop char
+    if(rx->cursor == rx->len) { // everything is handled, nothing to move
+        rx->len = rx->cursor = 0;
+        rx->buff[0] = '\0';
     }
 }
 
-/*Add float wrapper to object wrapper*/
-void msg_wrapper_add_float_to_obj(msg_wrap_obj_t *obj, msg_wrap_float_t *float_val)
+/*Move the unhandled bytes to the start*/
+void msg_rx_compact(msg_rx_t *rx)
 {
-    msg_wrap_float_t *fp;
-    if(obj->float_queue == NULL) { //first element
-        obj->float_queue = float_val;
-        obj->float_queue->next = NULL;
-    } else {
-        fp = obj->float_queue;
+    msg_size_t i, n = msg_rx_pending(rx);
 
-        while(fp->next != NULL) 
-            fp = fp->next;
-        fp->next = float_val;
-        float_val->next = NULL;
+    if(rx->cursor == 0) return;
+    for(i = 0; i < n; i++) rx->buff[i] = rx->buff[rx->cursor + i];
+    rx->len = n;
+    rx->cursor = 0;
+    rx->buff[n] = '\0';
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                      Message router                                     //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_ROUTER
+
+/**
+ * @brief Init empty trie node
+ * 
+ * @param node node
+ * @param c char of the id
+ */
+static void __route_node_init(msg_route_node_t *node, char c)
+{
+    node->child = node->next = node->route = node->cmd = MSG_ROUTE_NONE;
+    node->c = c;
+}
+
+/**
+ * @brief Find child node by char
+ * 
+ * @param r router
+ * @param n parent node
+ * @param c char
+ * @return msg_size_t child node or MSG_ROUTE_NONE
+ */
+static inline msg_size_t __route_child(const msg_router_t *r, msg_size_t n, char c)
+{
+    for(n = r->node[n].child; n != MSG_ROUTE_NONE && r->node[n].c != c; n = r->node[n].next);
+    return n;
+}
+
+/**
+ * @brief Insert id to the trie
+ * 
+ * @param r router
+ * @param n root node
+ * @param id id string
+ * @return msg_size_t last node of the id or MSG_ROUTE_NONE if the id is invalid or the router is full
+ */
+static msg_size_t __route_insert(msg_router_t *r, msg_size_t n, char *id)
+{
+    msg_size_t child;
+    const char *start = id;
+
+    if(!r->size || id == NULL || !*id) return MSG_ROUTE_NONE;
+    for(; *id; id++) {
+        if(!__is_valid_id_char(*id, id - start)) return MSG_ROUTE_NONE;
+        if((child = __route_child(r, n, *id)) == MSG_ROUTE_NONE) {
+            if(r->cnt >= r->size) return MSG_ROUTE_NONE;
+            child = r->cnt++;
+            __route_node_init(&r->node[child], *id);
+            r->node[child].next = r->node[n].child;
+            r->node[n].child = child;
+        }
+        n = child;
     }
+    return n;
 }
 
-/*Remove float wrapper from float queue*/
-void msg_wrapper_rm_float_from_obj(msg_wrap_obj_t *obj, msg_wrap_float_t *f)
+/**
+ * @brief Set route of the node
+ * 
+ * @param r router
+ * @param n last node of the id
+ * @param fn handler function
+ * @param arg user argument
+ * @return msg_size_t route number or MSG_ROUTE_NONE if the route array is full
+ */
+static msg_size_t __route_set(msg_router_t *r, msg_size_t n, msg_route_fn fn, void *arg)
 {
-    msg_wrap_float_t *fp, *prev;
-    for(fp = obj->float_queue, prev = NULL; fp != NULL; fp = fp->next){
-        if(fp == f) {
-            if(prev == NULL) { // if p is the head of the queue, reinit the head
-                obj->float_queue = f->next;
-            } else {
-                prev->next = f->next; //skip the expected
-            }
-            f->next = NULL; // reset next
-            return;
+    if(n == MSG_ROUTE_NONE) return MSG_ROUTE_NONE;
+    if(r->node[n].route == MSG_ROUTE_NONE) {
+        if(r->route_cnt >= r->route_size) return MSG_ROUTE_NONE;
+        r->node[n].route = r->route_cnt++;
+    }
+    r->route[r->node[n].route].fn = fn;
+    r->route[r->node[n].route].arg = arg;
+    return r->node[n].route;
+}
+
+/**
+ * @brief Call the handlers of the dispatched message
+ * 
+ * @param r router
+ * @param msg message
+ * @param hit matched commands, the message route is the first if it's registered
+ * @param hit_cnt count of matched commands
+ * @param buff buffer of the message
+ */
+static void __route_call(msg_router_t *r, msg_t msg, __msg_route_hit_t *hit, uint8_t hit_cnt, char *buff)
+{
+    msg_cmd_t cmd;
+    uint8_t i;
+
+    if(!hit_cnt) {
+        if(r->def.fn != NULL) {
+            msg_destroy_cmd(&cmd);
+            r->def.fn(msg, cmd, r->def.arg);
         }
-        prev = fp;
+        return;
+    }
+    for(i = 0; i < hit_cnt; i++) {
+        if(r->route[hit[i].route].fn == NULL) continue; // route is only looked up
+        cmd.cmd.s = hit[i].len ? buff + hit[i].start : NULL;
+        cmd.cmd.len = hit[i].len;
+        r->route[hit[i].route].fn(msg, cmd, r->route[hit[i].route].arg);
     }
 }
 
-/*Add object wrapper to message wrapper*/
-void msg_wrapper_add_obj_to_msg(msg_wrap_t *msg, msg_wrap_obj_t *obj)
+/*Create router*/
+msg_router_t msg_router_create(msg_route_node_t *node, msg_size_t size, msg_route_t *route, msg_size_t route_size)
 {
-    msg_wrap_obj_t *op;
-    if(msg->obj_queue == NULL) { //if empty 
-        msg->obj_queue = obj;
-        msg->obj_queue->next = NULL;
-    } else { // put to end of the queue
-        op = msg->obj_queue;
-        while(op->next != NULL)
-            op = op->next;
-        op->next = obj;
-        obj->next = NULL;
+    msg_router_t r;
+
+    r.node = node;
+    r.size = node != NULL && size >= 2 ? size : 0;
+    r.cnt = 0;
+    r.route = route;
+    r.route_size = route != NULL ? route_size : 0;
+    r.route_cnt = 0;
+    r.def.fn = NULL;
+    r.def.arg = NULL;
+    if(r.size) {
+        __route_node_init(&node[__ROUTE_MSG_ROOT], 0);
+        __route_node_init(&node[__ROUTE_CMD_ROOT], 0);
+        r.cnt = 2;
     }
+    return r;
 }
 
-/*remove object wrapper from message wrapper object queue*/
-void msg_wrapper_rm_obj_from_msg(msg_wrap_t *msg, msg_wrap_obj_t *obj)
+/*Register handler of message id*/
+msg_size_t msg_router_add(msg_router_t *r, char *id, msg_route_fn fn, void *arg)
 {
-    msg_wrap_obj_t *op, *prev;
-    for(op = msg->obj_queue, prev = NULL; op != NULL; op = op->next){
-        if(op == obj) {
-            if(prev == NULL) { // if p is the head of the queue, reinit the head
-                msg->obj_queue = obj->next;
+    return __route_set(r, __route_insert(r, __ROUTE_MSG_ROOT, id), fn, arg);
+}
+
+/*Register handler of command*/
+msg_size_t msg_router_add_cmd(msg_router_t *r, char *id, char *cmd, msg_route_fn fn, void *arg)
+{
+    msg_size_t n = __ROUTE_CMD_ROOT;
+
+    if(!r->size) return MSG_ROUTE_NONE;
+    if(id != NULL) {
+        if((n = __route_insert(r, __ROUTE_MSG_ROOT, id)) == MSG_ROUTE_NONE) return MSG_ROUTE_NONE;
+        if(r->node[n].cmd == MSG_ROUTE_NONE) { // first command of the message
+            if(r->cnt >= r->size) return MSG_ROUTE_NONE;
+            r->node[n].cmd = r->cnt++;
+            __route_node_init(&r->node[r->node[n].cmd], 0);
+        }
+        n = r->node[n].cmd;
+    }
+    return __route_set(r, __route_insert(r, n, cmd), fn, arg);
+}
+
+/*Set default handler*/
+void msg_router_set_default(msg_router_t *r, msg_route_fn fn, void *arg)
+{
+    r->def.fn = fn;
+    r->def.arg = arg;
+}
+
+/*Find route of message id*/
+msg_size_t msg_router_find(const msg_router_t *r, msg_str_t id)
+{
+    msg_size_t i, n = __ROUTE_MSG_ROOT;
+
+    if(!r->size || id.s == NULL) return MSG_ROUTE_NONE;
+    for(i = 0; i < id.len && n != MSG_ROUTE_NONE; i++) n = __route_child(r, n, id.s[i]);
+    return n != MSG_ROUTE_NONE ? r->node[n].route : MSG_ROUTE_NONE;
+}
+
+/*Dispatch messages of buffer*/
+msg_size_t msg_router_dispatch(msg_router_t *r, char *buff, msg_size_t len, msg_size_t *cursor)
+{
+    __msg_route_hit_t hit[MCU_MSG_ROUTER_CMD_MAX + 1];
+    msg_scan_t sc;
+    msg_t msg;
+    msg_size_t i, k, start = 0, content = 0, cnt = 0, cmd_start = 0, cmd_len = 0;
+    msg_size_t id_node = MSG_ROUTE_NONE, cmd_node[2];
+    uint8_t prev, state, cmd_state = __ROUTE_CMD_OFF, hit_cnt = 0;
+    char c;
+
+    sc.state = MSG_SCAN_IDLE;
+    sc.qmark = 0;
+    sc.depth = 0;
+    sc.id_len = 0;
+
+    for(i = *cursor; i < len && buff[i]; i++) {
+        c = buff[i];
+        prev = sc.state;
+        state = __scan_step(&sc, c);
+        if(state == MSG_SCAN_ID) {
+            if(!sc.id_len) { // new message flag
+                start = i;
+                id_node = r->size ? __ROUTE_MSG_ROOT : MSG_ROUTE_NONE;
+            } else if(id_node != MSG_ROUTE_NONE) {
+                id_node = __route_child(r, id_node, c);
+            }
+        } else if(state == MSG_SCAN_CONTENT && (prev == MSG_SCAN_ID || prev == MSG_SCAN_START)) {
+            content = i + 1;
+            cmd_state = __ROUTE_CMD_OFF;
+            hit_cnt = 0;
+            if(id_node != MSG_ROUTE_NONE && r->node[id_node].route != MSG_ROUTE_NONE) { // message route is the first call
+                hit[0].route = r->node[id_node].route;
+                hit[0].len = 0;
+                hit_cnt = 1;
+            }
+        } else if(state == MSG_SCAN_CONTENT && !sc.depth) {
+            if(cmd_state == __ROUTE_CMD_OFF) {
+                if(c != __CTRL_CMD_START_FLAG || !r->size) continue;
+                cmd_node[0] = id_node != MSG_ROUTE_NONE ? r->node[id_node].cmd : MSG_ROUTE_NONE;
+                cmd_node[1] = r->node[__ROUTE_CMD_ROOT].child != MSG_ROUTE_NONE ? __ROUTE_CMD_ROOT : MSG_ROUTE_NONE;
+                cmd_start = i + 1;
+                cmd_len = 0;
+                if(cmd_node[0] != MSG_ROUTE_NONE || cmd_node[1] != MSG_ROUTE_NONE) cmd_state = __ROUTE_CMD_ID;
+            } else if(c == __CTRL_CMD_STOP_FLAG) {
+                for(k = 0; k < 2; k++) { // commands of the message, then commands of every message
+                    if(cmd_node[k] == MSG_ROUTE_NONE || r->node[cmd_node[k]].route == MSG_ROUTE_NONE) continue;
+                    if(hit_cnt > MCU_MSG_ROUTER_CMD_MAX) break;
+                    hit[hit_cnt].route = r->node[cmd_node[k]].route;
+                    hit[hit_cnt].start = cmd_start;
+                    hit[hit_cnt].len = cmd_len;
+                    hit_cnt++;
+                }
+                cmd_state = __ROUTE_CMD_OFF;
+            } else if(cmd_state == __ROUTE_CMD_ID && __is_valid_id_char(c, cmd_len)) {
+                cmd_len++;
+                for(k = 0; k < 2; k++) {
+                    if(cmd_node[k] != MSG_ROUTE_NONE) cmd_node[k] = __route_child(r, cmd_node[k], c);
+                }
+            } else if(__is_whitespace(c) && cmd_len) {
+                cmd_state = __ROUTE_CMD_END;
             } else {
-                prev->next = obj->next; //skip the expected
+                cmd_state = __ROUTE_CMD_OFF;
             }
-            obj->next = NULL; // reset next
-            return;
+        } else if(state == MSG_SCAN_READY) {
+            msg.id.s = buff + start + 1;
+            msg.id.len = sc.id_len;
+            msg.content.s = buff + content;
+            msg.content.len = i - content;
+            __route_call(r, msg, hit, hit_cnt, buff);
+            hit_cnt = 0;
+            cnt++;
+        } else {
+            cmd_state = __ROUTE_CMD_OFF; // internal string or object
         }
-        prev = op;
-    }    
+    }
+    *cursor = sc.state == MSG_SCAN_IDLE || sc.state == MSG_SCAN_READY ? i : start; // keep the incomplete message
+    return cnt;
 }
 
-/*Add command wrapper to message wrapper*/
-void msg_wrapper_add_cmd_to_msg(msg_wrap_t *msg, msg_wrap_cmd_t *cmd)
+#if MCU_MSG_USE_RX
+/*Dispatch and consume messages of receive buffer*/
+msg_size_t msg_router_dispatch_rx(msg_router_t *r, msg_rx_t *rx)
 {
-    msg_wrap_cmd_t *cp;
-    if(msg->cmd_queue == NULL) { //if empty 
-        msg->cmd_queue = cmd;
-        msg->cmd_queue->next = NULL;
-    } else {
-        cp = msg->cmd_queue;
-        while(cp->next != NULL)
-            cp = cp->next;
-        cp->next = cmd;
-        cmd->next = NULL;
+    msg_size_t cursor = 0, cnt;
+
+    cnt = msg_router_dispatch(r, rx->buff + rx->cursor, msg_rx_pending(rx), &cursor);
+    rx->cursor += cursor;
+    if(rx->cursor == rx->len) { // everything is handled
+        rx->len = rx->cursor = 0;
+        rx->buff[0] = '\0';
     }
+    return cnt;
 }
+#endif
+#endif
 
-/*Remove command wrapper from message wrapper command queue*/
-void msg_wrapper_rm_cmd_from_msg(msg_wrap_t *msg, msg_wrap_cmd_t *cmd)
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                         //
+//                                      Capture file                                       //
+//                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////
+#if MCU_MSG_USE_FILE
+
+/*Map capture file*/
+int msg_file_open(msg_file_t *f, const char *path)
 {
-    msg_wrap_cmd_t *cp, *prev;
-    for(cp = msg->cmd_queue, prev = NULL; cp != NULL; cp = cp->next){
-        if(cp == cmd) {
-            if(prev == NULL) { // if p is the head of the queue, reinit the head
-                msg->cmd_queue = cmd->next;
-            } else {
-                prev->next = cmd->next; //skip the expected
-            }
-            cmd->next = NULL; // reset next
-            return;
+#if __MSG_FILE_MMAP
+    struct stat st;
+    void *p;
+    int fd;
+
+    f->base = NULL;
+    f->len = f->cursor = 0;
+    if((fd = open(path, O_RDONLY)) < 0) return -1;
+    if(fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    if((uint64_t)st.st_size > (msg_size_t)~0) { // not addressable by msg_size_t
+        close(fd);
+        errno = EFBIG;
+        return -1;
+    }
+    if(st.st_size) {
+        p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED) {
+            close(fd);
+            return -1;
         }
-        prev = cp;
-    }    
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        f->base = (char *)p;
+        f->len = st.st_size;
+    }
+    close(fd); // the mapping is kept
+    return 0;
+#else
+    (void)path;
+    f->base = NULL;
+    f->len = f->cursor = 0;
+    errno = ENOSYS;
+    return -1;
+#endif
 }
-#endif 
-/*EOF*/
\ No newline at end of file
+
+/*Get next message from file*/
+msg_t msg_file_next(msg_file_t *f)
+{
+    msg_size_t i;
+    msg_t res;
+
+    while(f->cursor < f->len) {
+        res = msg_next(f->base, f->len, &f->cursor);
+        if(res.content.s != NULL) return res;
+        if(f->cursor >= f->len) break;
+        if(f->base[f->cursor] == '\0') { // zero byte outside of messages
+            f->cursor++;
+            continue;
+        }
+        for(i = f->cursor; i < f->len && f->base[i]; i++); // cursor is at an incomplete message
+        if(i == f->len) break; // it's at the end of the file
+        f->cursor++; // broken by zero byte, resync after its flag
+    }
+    msg_destroy(&res);
+    return res;
+}
+
+/*Get next message by ID from file*/
+msg_t msg_file_get(msg_file_t *f, char *id)
+{
+    msg_t res;
+
+    while((res = msg_file_next(f)).content.s != NULL && !__keyword_eq(res.id, id));
+    return res;
+}
+
+/*Unmap file*/
+void msg_file_close(msg_file_t *f)
+{
+#if __MSG_FILE_MMAP
+    if(f->base != NULL) munmap(f->base, f->len);
+#endif
+    f->base = NULL;
+    f->len = f->cursor = 0;
+}
+#endif
+/*EOF*/